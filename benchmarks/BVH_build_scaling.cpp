@@ -0,0 +1,98 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "logLib.hpp"
+#include "BVH.hpp"
+#include "cmd_args.hpp"
+#include "triangles_binary.hpp"
+#include "triangles_input.hpp"
+
+/*
+
+Measures BVH_t construction time on 1, 2, 4, ... threads up to --threads N.
+Triangles are read from stdin or from --input FILE, in the same formats as usecase targets expect.
+Each measurement is the best of kNumRepeats runs.
+
+*/
+
+namespace {
+  const std::size_t kNumRepeats = 5;
+
+  double measure_build_time(
+    const std::vector<triangle_t<double>>& triangles,
+    BVH_build_params_t<double>             params,
+    std::size_t&                           num_nodes
+  ) {
+    double best_time = std::numeric_limits<double>::max();
+    for (std::size_t i = 0; i < kNumRepeats; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      BVH_t<double> BVH_tree(triangles, params);
+      auto finish = std::chrono::steady_clock::now();
+
+      num_nodes = BVH_tree.get_num_nodes();
+      best_time = std::min(best_time,
+        std::chrono::duration<double, std::milli>(finish - start).count());
+    }
+
+    return best_time;
+  }
+
+  const char* get_strategy_name(BVH_split_strategy_t strategy) {
+    switch (strategy) {
+      case BVH_split_strategy_t::MEDIAN:     return "median";
+      case BVH_split_strategy_t::BINNED_SAH: return "binned SAH";
+      case BVH_split_strategy_t::LBVH:       return "LBVH";
+      default:                               return "";
+    }
+  }
+};
+
+int main(int argc, char** argv) {
+  cmd_args_t args;
+  try {
+    args = cmd_args::parse(argc, argv);
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << '\n' << cmd_args::kUsage << std::endl;
+    return 1;
+  }
+
+  std::vector<triangle_t<double>> triangles;
+  try {
+    triangles = args.input_path.empty() ? triangles_input::read_triangles<double>(std::cin)
+                                        : triangles_binary::read_file<double>(args.input_path);
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+  std::size_t num_triangles = triangles.size();
+
+  std::cout << "triangles: " << num_triangles << '\n';
+  for (auto strategy : {BVH_split_strategy_t::MEDIAN, BVH_split_strategy_t::BINNED_SAH,
+                        BVH_split_strategy_t::LBVH}) {
+    std::cout << get_strategy_name(strategy) << ":\n"
+              << "  threads    time, ms    speedup    nodes\n";
+
+    double single_thread_time = 0;
+    for (std::size_t num_threads = 1; num_threads <= args.num_threads; num_threads *= 2) {
+      BVH_build_params_t<double> params;
+      params.strategy    = strategy;
+      params.num_threads = num_threads;
+
+      std::size_t num_nodes = 0;
+      double time = measure_build_time(triangles, params, num_nodes);
+      if (num_threads == 1) {
+        single_thread_time = time;
+      }
+
+      std::cout << std::fixed << std::setprecision(2)
+                << std::setw(9)  << num_threads
+                << std::setw(12) << time
+                << std::setw(11) << single_thread_time / time
+                << std::setw(9)  << num_nodes << '\n';
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "logLib.hpp"
+#include "BVH.hpp"
+#include "cmd_args.hpp"
+#include "triangles_binary.hpp"
+#include "triangles_input.hpp"
+
+/*
+
+Compares BVH_t split strategies on the same triangles: build time, number of nodes
+and time of mark_self_intersections on the built tree, i.e. how good the tree is for queries.
+Triangles are read from stdin or from --input FILE, --threads N is used both for build and query.
+Each measurement is the best of kNumRepeats runs.
+
+*/
+
+namespace {
+  const std::size_t kNumRepeats = 5;
+
+  struct measurement_t {
+    double      build_time = std::numeric_limits<double>::max();
+    double      query_time = std::numeric_limits<double>::max();
+    std::size_t num_nodes  = 0;
+    std::size_t num_marked = 0;
+  };
+
+  double get_time_since(std::chrono::steady_clock::time_point start) {
+    auto finish = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(finish - start).count();
+  }
+
+  measurement_t measure(
+    const std::vector<triangle_t<double>>& triangles,
+    BVH_build_params_t<double>             params
+  ) {
+    measurement_t result;
+    for (std::size_t i = 0; i < kNumRepeats; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      BVH_t<double> BVH_tree(triangles, params);
+      result.build_time = std::min(result.build_time, get_time_since(start));
+
+      start = std::chrono::steady_clock::now();
+      BVH_tree.mark_self_intersections(params.num_threads);
+      result.query_time = std::min(result.query_time, get_time_since(start));
+
+      result.num_nodes  = BVH_tree.get_num_nodes();
+      result.num_marked = 0;
+      for (std::size_t ind = 0; ind < triangles.size(); ++ind) {
+        result.num_marked += BVH_tree.is_marked(ind);
+      }
+    }
+
+    return result;
+  }
+};
+
+int main(int argc, char** argv) {
+  cmd_args_t args;
+  try {
+    args = cmd_args::parse(argc, argv);
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << '\n' << cmd_args::kUsage << std::endl;
+    return 1;
+  }
+
+  std::vector<triangle_t<double>> triangles;
+  try {
+    triangles = args.input_path.empty() ? triangles_input::read_triangles<double>(std::cin)
+                                        : triangles_binary::read_file<double>(args.input_path);
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << "triangles: " << triangles.size() << ", threads: " << args.num_threads << '\n'
+            << "  strategy    build, ms    query, ms     nodes    marked\n";
+  const std::pair<BVH_split_strategy_t, const char*> strategies[] = {
+    {BVH_split_strategy_t::MEDIAN,     "median"},
+    {BVH_split_strategy_t::BINNED_SAH, "binned SAH"},
+    {BVH_split_strategy_t::LBVH,       "LBVH"},
+  };
+  for (auto [strategy, name] : strategies) {
+    BVH_build_params_t<double> params;
+    params.strategy    = strategy;
+    params.num_threads = args.num_threads;
+
+    measurement_t result = measure(triangles, params);
+    std::cout << std::fixed << std::setprecision(2)
+              << std::setw(10) << name
+              << std::setw(13) << result.build_time
+              << std::setw(13) << result.query_time
+              << std::setw(10) << result.num_nodes
+              << std::setw(10) << result.num_marked << '\n';
+  }
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "logLib.hpp"
+#include "BVH.hpp"
+#include "cmd_args.hpp"
+#include "triangles_binary.hpp"
+#include "triangles_input.hpp"
+
+/*
+
+Compares BVH_t<double> with double and with float node boxes on the same triangles:
+memory taken by nodes, time of per triangle queries (mark_not_alone_triangles) and of
+self traversal (mark_self_intersections). Both trees must mark the same triangles.
+Triangles are read from stdin or from --input FILE, --threads N is used both for build and query.
+Each measurement is the best of kNumRepeats runs.
+
+*/
+
+namespace {
+  const std::size_t kNumRepeats = 5;
+
+  struct measurement_t {
+    double      per_triangle_time = std::numeric_limits<double>::max();
+    double      self_time         = std::numeric_limits<double>::max();
+    std::size_t nodes_memory      = 0;
+    std::size_t num_marked        = 0;
+  };
+
+  double get_time_since(std::chrono::steady_clock::time_point start) {
+    auto finish = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(finish - start).count();
+  }
+
+  template<typename BVH_tree_t>
+  std::size_t count_marked(const BVH_tree_t& BVH_tree, std::size_t num_triangles) {
+    std::size_t num_marked = 0;
+    for (std::size_t ind = 0; ind < num_triangles; ++ind) {
+      num_marked += BVH_tree.is_marked(ind);
+    }
+    return num_marked;
+  }
+
+  template<typename node_T>
+  measurement_t measure(
+    const std::vector<triangle_t<double>>& triangles,
+    const BVH_build_params_t<double>&      params
+  ) {
+    measurement_t result;
+    for (std::size_t i = 0; i < kNumRepeats; ++i) {
+      BVH_t<double, node_T> per_triangle_tree(triangles, params);
+      auto start = std::chrono::steady_clock::now();
+      per_triangle_tree.mark_not_alone_triangles(params.num_threads);
+      result.per_triangle_time = std::min(result.per_triangle_time, get_time_since(start));
+
+      BVH_t<double, node_T> self_tree(triangles, params);
+      start = std::chrono::steady_clock::now();
+      self_tree.mark_self_intersections(params.num_threads);
+      result.self_time = std::min(result.self_time, get_time_since(start));
+
+      result.nodes_memory = self_tree.get_num_nodes() * self_tree.get_node_size();
+      result.num_marked   = count_marked(self_tree, triangles.size());
+      if (count_marked(per_triangle_tree, triangles.size()) != result.num_marked) {
+        std::cerr << "Error: query modes marked different triangles" << std::endl;
+      }
+    }
+
+    return result;
+  }
+
+  void print_measurement(const char* name, const measurement_t& result) {
+    std::cout << std::fixed << std::setprecision(2)
+              << std::setw(8)  << name
+              << std::setw(13) << result.nodes_memory / 1024
+              << std::setw(19) << result.per_triangle_time
+              << std::setw(11) << result.self_time
+              << std::setw(10) << result.num_marked << '\n';
+  }
+};
+
+int main(int argc, char** argv) {
+  cmd_args_t args;
+  try {
+    args = cmd_args::parse(argc, argv);
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << '\n' << cmd_args::kUsage << std::endl;
+    return 1;
+  }
+
+  std::vector<triangle_t<double>> triangles;
+  try {
+    triangles = args.input_path.empty() ? triangles_input::read_triangles<double>(std::cin)
+                                        : triangles_binary::read_file<double>(args.input_path);
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+
+  BVH_build_params_t<double> params;
+  params.num_threads = args.num_threads;
+
+  std::cout << "triangles: " << triangles.size() << ", threads: " << args.num_threads << '\n'
+            << "   nodes    nodes, KiB    per triangle, ms    self, ms    marked\n";
+  print_measurement("double", measure<double>(triangles, params));
+  print_measurement("float",  measure<float> (triangles, params));
+
+  return 0;
+}
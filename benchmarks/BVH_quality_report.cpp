@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "logLib.hpp"
+#include "BVH.hpp"
+#include "cmd_args.hpp"
+#include "triangles_binary.hpp"
+#include "triangles_input.hpp"
+
+/*
+
+Builds BVH_t with every split strategy on the same triangles and reports quality of each tree
+(BVH_t::get_quality): SAH cost, leaves by the reason they weren't split, leaf sizes and,
+for every level, number of nodes and mean overlap of children boxes.
+Nodes have float boxes, like in solutions. Triangles are read from stdin or from --input FILE,
+--threads N is used for build.
+
+*/
+
+namespace {
+  void print_quality(const char* name, const BVH_quality_t& quality) {
+    std::cout << "\n=== " << name << " ===\n"
+              << std::fixed << std::setprecision(2)
+              << "SAH cost: " << quality.SAH_cost
+              << ", nodes: "  << quality.num_nodes
+              << ", leaves: " << quality.num_leaves
+              << ", max depth: " << quality.max_depth << '\n';
+
+    std::cout << "leaves by reason:";
+    for (std::size_t i = 0; i < kNumBVHLeafReasons; ++i) {
+      std::cout << (i == 0 ? " " : ", ") << get_leaf_reason_name(static_cast<BVH_leaf_reason_t>(i))
+                << " - " << quality.leaves_by_reason[i];
+    }
+    std::cout << '\n';
+
+    // sizes are grouped into ranges [2^k, 2^(k+1))
+    std::cout << "leaf sizes (sizes: leaves):";
+    for (std::size_t range_begin = 1; range_begin < quality.leaf_sizes.size(); range_begin *= 2) {
+      std::size_t range_end  = std::min(2 * range_begin, quality.leaf_sizes.size());
+      std::size_t num_leaves = 0;
+      for (std::size_t size = range_begin; size < range_end; ++size) {
+        num_leaves += quality.leaf_sizes[size];
+      }
+      if (num_leaves != 0) {
+        std::cout << ' ' << range_begin << '-' << 2 * range_begin - 1 << ": " << num_leaves;
+      }
+    }
+    std::cout << '\n';
+
+    std::cout << "   depth    inner    leaves    overlap\n" << std::setprecision(4);
+    for (std::size_t depth = 0; depth < quality.levels.size(); ++depth) {
+      const BVH_quality_t::level_t& level = quality.levels[depth];
+      std::cout << std::setw(8)  << depth
+                << std::setw(9)  << level.num_inner_nodes
+                << std::setw(10) << level.num_leaves
+                << std::setw(11) << level.mean_overlap_ratio << '\n';
+    }
+  }
+};
+
+int main(int argc, char** argv) {
+  cmd_args_t args;
+  try {
+    args = cmd_args::parse(argc, argv);
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << '\n' << cmd_args::kUsage << std::endl;
+    return 1;
+  }
+
+  std::vector<triangle_t<double>> triangles;
+  try {
+    triangles = args.input_path.empty() ? triangles_input::read_triangles<double>(std::cin)
+                                        : triangles_binary::read_file<double>(args.input_path);
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << "triangles: " << triangles.size() << '\n';
+  const std::pair<BVH_split_strategy_t, const char*> strategies[] = {
+    {BVH_split_strategy_t::MEDIAN,     "median"},
+    {BVH_split_strategy_t::BINNED_SAH, "binned SAH"},
+    {BVH_split_strategy_t::LBVH,       "LBVH"},
+  };
+  for (auto [strategy, name] : strategies) {
+    BVH_build_params_t<double> params;
+    params.strategy    = strategy;
+    params.num_threads = args.num_threads;
+
+    BVH_t<double, float> BVH_tree(triangles, params);
+    print_quality(name, BVH_tree.get_quality());
+  }
+
+  return 0;
+}
@@ -0,0 +1,334 @@
+#include <benchmark/benchmark.h>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "logLib.hpp"
+#include "AABB.hpp"
+#include "BVH.hpp"
+#include "plane.hpp"
+#include "segment.hpp"
+#include "solutions_impl.hpp"
+#include "triangle.hpp"
+
+/*
+
+Micro benchmarks of geometric primitives (AABB_t::does_inter, triangle_t::does_intersect,
+segment_t::does_inter, plane_t::intersect_by_segm), of BVH_t build, of its per triangle
+queries in both traversal orders and of full solutions, built on Google Benchmark. Inputs are generated with fixed seeds, so runs are comparable.
+Each primitive benchmark cycles through kNumInputs different inputs, so branch predictor
+can't learn the answer. To keep results for tracking regressions:
+  ./build/benchmarks/micro_benchmarks --benchmark_out=bench.json --benchmark_out_format=json
+
+*/
+
+namespace {
+  const std::size_t kNumInputs = 1024;
+  const unsigned    kSeed      = 21;
+
+  using triangle_pair_t = std::pair<triangle_t<double>, triangle_t<double>>;
+
+  class generator_t {
+   public:
+    explicit generator_t(unsigned seed) : gen_(seed) {}
+
+    double get_coord(double min, double max) {
+      return std::uniform_real_distribution<double>(min, max)(gen_);
+    }
+
+    // point in unit square of plane z = 0
+    point_t<double> get_flat_point() {
+      return {get_coord(0.0, 1.0), get_coord(0.0, 1.0), 0.0};
+    }
+
+    point_t<double> get_point(double min_z, double max_z) {
+      return {get_coord(0.0, 1.0), get_coord(0.0, 1.0), get_coord(min_z, max_z)};
+    }
+
+    triangle_t<double> get_flat_triangle() {
+      return {get_flat_point(), get_flat_point(), get_flat_point()};
+    }
+
+   private:
+    std::mt19937 gen_;
+  };
+
+  enum class triangles_case_t {
+    DISJOINT,
+    TOUCHING,
+    COPLANAR,
+    DEGENERATE
+  };
+
+  // first triangle of each pair lies in plane z = 0
+  std::vector<triangle_pair_t> generate_triangle_pairs(triangles_case_t inters_case) {
+    generator_t generator(kSeed);
+    std::vector<triangle_pair_t> pairs;
+    for (std::size_t i = 0; i < kNumInputs; ++i) {
+      point_t<double> a = generator.get_flat_point(), b = generator.get_flat_point();
+      triangle_t<double> first{a, b, generator.get_flat_point()};
+      triangle_t<double> second;
+
+      switch (inters_case) {
+        case triangles_case_t::DISJOINT:
+          if (i % 2 == 0) {
+            // on one side of plane
+            second = {generator.get_point(0.1, 1.0), generator.get_point(0.1, 1.0), generator.get_point(0.1, 1.0)};
+          } else {
+            // crosses plane, but away from first triangle
+            point_t<double> shift{2.0, 0.0, 0.0};
+            second = {generator.get_point(-1.0, 1.0) + shift, generator.get_point(-1.0, 1.0) + shift,
+                      generator.get_point(0.1, 1.0) + shift};
+          }
+          break;
+        case triangles_case_t::TOUCHING: {
+          // vertex on edge ab, other vertices above plane
+          point_t<double> on_edge = a + (b - a) * generator.get_coord(0.0, 1.0);
+          second = {on_edge, generator.get_point(0.1, 1.0), generator.get_point(0.1, 1.0)};
+          break;
+        }
+        case triangles_case_t::COPLANAR:
+          second = generator.get_flat_triangle();
+          break;
+        case triangles_case_t::DEGENERATE:
+          if (i % 2 == 0) {
+            // segment through plane
+            point_t<double> start = generator.get_point(-1.0, -0.1), finish = generator.get_point(0.1, 1.0);
+            second = {start, finish, (start + finish) * 0.5};
+          } else {
+            // point in plane
+            point_t<double> point = generator.get_flat_point();
+            second = {point, point, point};
+          }
+          break;
+        default:
+          break;
+      }
+      pairs.emplace_back(first, second);
+    }
+
+    return pairs;
+  }
+
+  const char* get_kernel_name(triangle_inters_kernel_t kernel) {
+    switch (kernel) {
+      case triangle_inters_kernel_t::EDGES:       return "edges";
+      case triangle_inters_kernel_t::PLANE_SIDES: return "plane sides";
+      case triangle_inters_kernel_t::EXACT:       return "exact";
+      default:                                    return "unknown";
+    }
+  }
+
+  // triangles of side up to 1 in cube, which volume grows with their number,
+  // so number of intersections per triangle doesn't depend on size
+  std::vector<triangle_t<double>> generate_scene(std::size_t num_triangles) {
+    generator_t generator(kSeed);
+    double scene_side = 2.0 * std::cbrt(static_cast<double>(num_triangles));
+
+    std::vector<triangle_t<double>> triangles;
+    for (std::size_t i = 0; i < num_triangles; ++i) {
+      point_t<double> center{generator.get_coord(0.0, scene_side), generator.get_coord(0.0, scene_side),
+                             generator.get_coord(0.0, scene_side)};
+      std::array<point_t<double>, 3> points;
+      for (auto& point : points) {
+        point = center + point_t<double>{generator.get_coord(-0.5, 0.5), generator.get_coord(-0.5, 0.5),
+                                         generator.get_coord(-0.5, 0.5)};
+      }
+      triangles.emplace_back(points[0], points[1], points[2]);
+    }
+
+    return triangles;
+  }
+
+  enum class query_scene_t {
+    // scene of generate_scene, most queries find nothing
+    SCATTERED,
+    // random vertices in unit square of plane z = 0, long thin triangles cross each other
+    RANDOM_FLAT,
+    // big equilateral triangles around center of unit square, nearly all of them intersect
+    EQUILATERAL
+  };
+
+  std::vector<triangle_t<double>> generate_query_scene(query_scene_t scene, std::size_t num_triangles) {
+    if (scene == query_scene_t::SCATTERED) {
+      return generate_scene(num_triangles);
+    }
+
+    generator_t generator(kSeed);
+    std::vector<triangle_t<double>> triangles;
+    for (std::size_t i = 0; i < num_triangles; ++i) {
+      if (scene == query_scene_t::RANDOM_FLAT) {
+        triangles.push_back(generator.get_flat_triangle());
+        continue;
+      }
+      point_t<double> center{0.5, 0.5, 0.0};
+      double radius = generator.get_coord(0.3, 0.5);
+      double angle  = generator.get_coord(0.0, 2 * M_PI);
+      std::array<point_t<double>, 3> points;
+      for (auto& point : points) {
+        point = center + point_t<double>{radius * std::cos(angle), radius * std::sin(angle), 0.0};
+        angle += 2 * M_PI / 3;
+      }
+      triangles.emplace_back(points[0], points[1], points[2]);
+    }
+
+    return triangles;
+  }
+
+  // ---------------  primitives  ---------------
+
+  void BM_AABB_does_inter(benchmark::State& state) {
+    generator_t generator(kSeed);
+    std::vector<AABB_t<double>> boxes;
+    for (std::size_t i = 0; i < kNumInputs; ++i) {
+      point_t<double> corner = generator.get_point(0.0, 1.0);
+      point_t<double> size{generator.get_coord(0.0, 0.5), generator.get_coord(0.0, 0.5),
+                           generator.get_coord(0.0, 0.5)};
+      boxes.emplace_back(corner, corner + size);
+    }
+
+    std::size_t ind = 0;
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(boxes[ind].does_inter(boxes[(ind + 1) % kNumInputs]));
+      ind = (ind + 1) % kNumInputs;
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+
+  void BM_triangle_does_intersect(benchmark::State& state, triangles_case_t inters_case) {
+    auto kernel = static_cast<triangle_inters_kernel_t>(state.range(0));
+    std::vector<triangle_pair_t> pairs = generate_triangle_pairs(inters_case);
+
+    std::size_t ind = 0;
+    for (auto _ : state) {
+      const auto& [first, second] = pairs[ind];
+      benchmark::DoNotOptimize(first.does_intersect(second, kernel));
+      ind = (ind + 1) % kNumInputs;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(get_kernel_name(kernel));
+  }
+
+  // segments in one plane, so the full test is done, not only skew check
+  void BM_segment_does_inter(benchmark::State& state) {
+    generator_t generator(kSeed);
+    std::vector<segment_t<double>> segments;
+    for (std::size_t i = 0; i < kNumInputs; ++i) {
+      segments.emplace_back(generator.get_flat_point(), generator.get_flat_point());
+    }
+
+    std::size_t ind = 0;
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(segments[ind].does_inter(segments[(ind + 1) % kNumInputs]));
+      ind = (ind + 1) % kNumInputs;
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+
+  void BM_plane_intersect_by_segm(benchmark::State& state) {
+    generator_t generator(kSeed);
+    std::vector<std::pair<plane_t<double>, segment_t<double>>> inputs;
+    for (std::size_t i = 0; i < kNumInputs; ++i) {
+      plane_t<double> plane{generator.get_point(0.0, 1.0), generator.get_point(0.0, 1.0),
+                            generator.get_point(0.0, 1.0)};
+      inputs.emplace_back(plane, segment_t<double>{generator.get_point(0.0, 1.0), generator.get_point(0.0, 1.0)});
+    }
+
+    std::size_t ind = 0;
+    for (auto _ : state) {
+      const auto& [plane, segm] = inputs[ind];
+      benchmark::DoNotOptimize(plane.intersect_by_segm(segm));
+      ind = (ind + 1) % kNumInputs;
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+
+  // ---------------  BVH and solutions  ---------------
+
+  void BM_BVH_build(benchmark::State& state, BVH_split_strategy_t strategy) {
+    std::vector<triangle_t<double>> triangles = generate_scene(static_cast<std::size_t>(state.range(0)));
+    BVH_build_params_t<double> params;
+    params.strategy = strategy;
+
+    for (auto _ : state) {
+      // same node type as solutions use
+      BVH_t<double, float> BVH_tree(triangles, params);
+      benchmark::DoNotOptimize(BVH_tree.get_num_nodes());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  // per triangle queries of mark_not_alone_triangles, state.range(1) is split strategy
+  void BM_BVH_query(benchmark::State& state, query_scene_t scene, BVH_traversal_order_t order) {
+    std::vector<triangle_t<double>> triangles = generate_query_scene(scene, static_cast<std::size_t>(state.range(0)));
+    BVH_build_params_t<double> params;
+    params.strategy        = static_cast<BVH_split_strategy_t>(state.range(1));
+    params.traversal_order = order;
+
+    for (auto _ : state) {
+      // marks of previous iteration would end queries at once
+      state.PauseTiming();
+      BVH_t<double, float> BVH_tree(triangles, params);
+      state.ResumeTiming();
+      BVH_tree.mark_not_alone_triangles(1);
+      benchmark::DoNotOptimize(BVH_tree.is_marked(0));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  template<typename solution_tag>
+  void BM_solve(benchmark::State& state) {
+    std::vector<triangle_t<double>> triangles = generate_scene(static_cast<std::size_t>(state.range(0)));
+
+    std::size_t num_inter = 0;
+    for (auto _ : state) {
+      triangles_inters_solver_t<double, solution_tag> solver(triangles);
+      num_inter = solver.get_inter_triangs_indices().size();
+      benchmark::DoNotOptimize(num_inter);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["intersecting"] = static_cast<double>(num_inter);
+  }
+
+  void add_query_args(benchmark::internal::Benchmark* benchmark) {
+    for (auto strategy : {BVH_split_strategy_t::MEDIAN, BVH_split_strategy_t::BINNED_SAH,
+                          BVH_split_strategy_t::LBVH}) {
+      benchmark->Args({1 << 14, static_cast<std::int64_t>(strategy)});
+    }
+    benchmark->Unit(benchmark::kMillisecond);
+  }
+
+  void add_kernel_args(benchmark::internal::Benchmark* benchmark) {
+    for (auto kernel : {triangle_inters_kernel_t::EDGES, triangle_inters_kernel_t::PLANE_SIDES,
+                        triangle_inters_kernel_t::EXACT}) {
+      benchmark->Arg(static_cast<std::int64_t>(kernel));
+    }
+  }
+};
+
+BENCHMARK(BM_AABB_does_inter);
+BENCHMARK_CAPTURE(BM_triangle_does_intersect, disjoint,   triangles_case_t::DISJOINT)  ->Apply(add_kernel_args);
+BENCHMARK_CAPTURE(BM_triangle_does_intersect, touching,   triangles_case_t::TOUCHING)  ->Apply(add_kernel_args);
+BENCHMARK_CAPTURE(BM_triangle_does_intersect, coplanar,   triangles_case_t::COPLANAR)  ->Apply(add_kernel_args);
+BENCHMARK_CAPTURE(BM_triangle_does_intersect, degenerate, triangles_case_t::DEGENERATE)->Apply(add_kernel_args);
+BENCHMARK(BM_segment_does_inter);
+BENCHMARK(BM_plane_intersect_by_segm);
+
+BENCHMARK_CAPTURE(BM_BVH_build, median,     BVH_split_strategy_t::MEDIAN)    ->RangeMultiplier(8)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_BVH_build, binned_SAH, BVH_split_strategy_t::BINNED_SAH)->RangeMultiplier(8)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_BVH_build, LBVH,       BVH_split_strategy_t::LBVH)      ->RangeMultiplier(8)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(BM_BVH_query, scattered_near_first,   query_scene_t::SCATTERED,   BVH_traversal_order_t::NEAR_FIRST)->Apply(add_query_args);
+BENCHMARK_CAPTURE(BM_BVH_query, scattered_left_first,   query_scene_t::SCATTERED,   BVH_traversal_order_t::LEFT_FIRST)->Apply(add_query_args);
+BENCHMARK_CAPTURE(BM_BVH_query, random_flat_near_first, query_scene_t::RANDOM_FLAT, BVH_traversal_order_t::NEAR_FIRST)->Apply(add_query_args);
+BENCHMARK_CAPTURE(BM_BVH_query, random_flat_left_first, query_scene_t::RANDOM_FLAT, BVH_traversal_order_t::LEFT_FIRST)->Apply(add_query_args);
+BENCHMARK_CAPTURE(BM_BVH_query, equilateral_near_first, query_scene_t::EQUILATERAL, BVH_traversal_order_t::NEAR_FIRST)->Apply(add_query_args);
+BENCHMARK_CAPTURE(BM_BVH_query, equilateral_left_first, query_scene_t::EQUILATERAL, BVH_traversal_order_t::LEFT_FIRST)->Apply(add_query_args);
+
+BENCHMARK_TEMPLATE(BM_solve, opt_bvh_solution_tag)        ->RangeMultiplier(8)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_solve, sweep_and_prune_solution_tag)->RangeMultiplier(8)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_solve, spatial_hash_solution_tag)   ->RangeMultiplier(8)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_solve, auto_solution_tag)           ->RangeMultiplier(8)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
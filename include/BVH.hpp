@@ -1,275 +1,1750 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <limits>
 #include <numeric>
-#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
 
 #include "logLib.hpp"
-#include "triangle_with_box.hpp"
+#include "parallel_for.hpp"
+#include "inflated_AABB.hpp"
+#include "prepared_triangle.hpp"
+#include "radix_sort.hpp"
+#include "stats.hpp"
+#include "triangles_batch.hpp"
+#include "union_find.hpp"
+
+enum class BVH_split_strategy_t {
+  // split by median of triangle centers, best of 3 axes
+  MEDIAN,
+  // binned surface area heuristic
+  BINNED_SAH,
+  // linear BVH: triangles sorted by Morton codes of centers, node is split
+  // by the highest bit, that differs in its codes (T. Karras, "Maximizing
+  // Parallelism in the Construction of BVHs, Octrees, and k-d Trees")
+  LBVH
+};
+
+// order, in which per triangle queries descend into children, see BVH_t::is_triangle_not_alone
+enum class BVH_traversal_order_t {
+  // both children boxes are tested before descending, if both overlap, the child with
+  // nearer center goes first; much less work on scenes of big scattered triangles
+  NEAR_FIRST,
+  // left child goes first, box of the right one is tested only when it's popped;
+  // faster on dense scenes, where most queries hit in their first leaf
+  LEFT_FIRST
+};
 
 template<typename T>
+struct BVH_build_params_t {
+  BVH_split_strategy_t strategy = BVH_split_strategy_t::BINNED_SAH;
+
+  // SAH parameters, ignored by MEDIAN and LBVH strategies
+  std::size_t num_bins          = 16;
+  // cost of one node visit and of one triangle test, only their ratio matters
+  T           traversal_cost    = 1;
+  T           intersection_cost = 2;
+  // leaf is forced to split if it's bigger, even if SAH says otherwise
+  std::size_t max_leaf_size     = 32;
+
+  // subtrees are built in parallel, result doesn't depend on number of threads
+  std::size_t num_threads       = 1;
+
+  // not used by build itself, queries of the tree test triangle pairs with it
+  triangle_inters_kernel_t narrow_phase_kernel = triangle_t<T>::kDefaultInterKernel;
+  // not used by build itself, per triangle queries visit children in this order
+  BVH_traversal_order_t    traversal_order     = BVH_traversal_order_t::NEAR_FIRST;
+};
+
+// why construction made a node a leaf
+enum class BVH_leaf_reason_t {
+  // few triangles, the only reason for LBVH strategy
+  SMALL,
+  // no split separates triangles or, for SAH, leaf is cheaper than any split
+  NO_SPLIT,
+  // MEDIAN strategy: boxes of children overlap too much for their depth
+  OVERLAP,
+  // depth limit of MEDIAN strategy or protection from degenerate recursion
+  DEPTH_LIMIT
+};
+
+constexpr std::size_t kNumBVHLeafReasons = 4;
+
+[[nodiscard]] inline const char* get_leaf_reason_name(BVH_leaf_reason_t reason) {
+  switch (reason) {
+    case BVH_leaf_reason_t::SMALL:       return "small";
+    case BVH_leaf_reason_t::NO_SPLIT:    return "no split";
+    case BVH_leaf_reason_t::OVERLAP:     return "overlap";
+    case BVH_leaf_reason_t::DEPTH_LIMIT: return "depth limit";
+    default:                             return "unknown";
+  }
+}
+
+// metrics of built tree, that show how good it is for queries, see BVH_t::get_quality
+struct BVH_quality_t {
+  struct level_t {
+    std::size_t num_inner_nodes    = 0;
+    std::size_t num_leaves         = 0;
+    // mean over inner nodes of the level: volume of overlap of children boxes / volume of node box
+    double      mean_overlap_ratio = 0;
+  };
+
+  // SAH cost of the tree with costs of build params: traversal_cost for every inner node
+  // and intersection_cost for every triangle of a leaf, weighted by area of node box / area of root box
+  double SAH_cost = 0;
+
+  std::size_t num_nodes  = 0;
+  std::size_t num_leaves = 0;
+  // root has depth 0
+  std::size_t max_depth  = 0;
+
+  // levels[depth], so depth distribution of leaves is levels[depth].num_leaves
+  std::vector<level_t>     levels;
+  // leaf_sizes[n] - number of leaves of n triangles
+  std::vector<std::size_t> leaf_sizes;
+  // number of leaves for each BVH_leaf_reason_t
+  std::array<std::size_t, kNumBVHLeafReasons> leaves_by_reason = {};
+};
+
+// node_T is coordinate type of node boxes. With float boxes for double triangles
+// nodes take 32 bytes instead of 64, boxes are rounded outward, so the tree finds
+// the same triangles, narrow phase still works with double triangles.
+template<typename T, typename node_T = T>
 class BVH_t {
  private:
-  class node_t;
+  struct node_t;
+  using node_box_t   = inflated_AABB_t<node_T>;
+  // 32 bit indices for float boxes, so node is twice smaller too
+  using node_index_t = std::conditional_t<(sizeof(node_T) < sizeof(std::size_t)), std::uint32_t, std::size_t>;
  public:
-  using triangs_list_t = std::vector<triangle_with_box_t<T>>;
+  using triangs_list_t = std::vector<prepared_triangle_t<T>>;
   using indices_list_t = std::vector<std::size_t>;
+  using build_params_t = BVH_build_params_t<T>;
+  // indices of triangles in input list, first < second
+  using index_pair_t   = std::pair<std::size_t, std::size_t>;
+
+  BVH_t(const std::vector<triangle_t<T>>& triangles,
+        const build_params_t& build_params = {})
+      : BVH_t(triangles.data(), triangles.size(), nullptr, build_params) {}
+
+  // Triangles aren't required to live in a vector, e.g. they may be in a mapped file.
+  // boxes may be nullptr, else boxes[i] must be exactly AABB_t of triangles[i].
+  BVH_t(const triangle_t<T>* triangles,
+        std::size_t           num_triangles,
+        const AABB_t<T>*      boxes,
+        const build_params_t& build_params = {})
+      : num_triangles_(num_triangles),
+        build_params_(build_params),
+        triangles_(prepare_triangles(triangles, num_triangles, boxes)),
+        visited_(num_triangles_),
+        free_build_threads_(std::max(build_params.num_threads, std::size_t{1}) - 1) {
+    assert(build_params_.num_bins >= 2);
+    if (num_triangles_ > kMaxNumTriangles) {
+      throw std::invalid_argument("Error: too many triangles for BVH with 32 bit node indices");
+    }
+    if (num_triangles_ == 0) {
+      return;
+    }
+
+    {
+      stats::phase_timer_t timer(&stats::counters_t::tree_time);
+      centers_.reserve(num_triangles_);
+      for (auto& triangle : triangles_) {
+        centers_.push_back(triangle.get_center());
+      }
 
-  BVH_t(const std::vector<triangle_t<T>>& triangles)
-      : num_triangles_(triangles.size()),
-        triangles_(triangles.begin(), triangles.end()),
-        visited_(num_triangles_) {
-    indices_list_t indices(num_triangles_);
-    std::iota(indices.begin(), indices.end(), 0);
-    root_ = construct_BVH_tree(indices, 0);
+      // tree is built by partitioning ranges of this array in place
+      triangle_ids_.resize(num_triangles_);
+      std::iota(triangle_ids_.begin(), triangle_ids_.end(), 0);
+      if (build_params_.strategy == BVH_split_strategy_t::LBVH) {
+        construct_LBVH();
+      } else {
+        build_scratch_t scratch;
+        construct_BVH_tree(0, num_triangles_, 0, nodes_, scratch);
+      }
+    }
+    {
+      stats::phase_timer_t timer(&stats::counters_t::reorder_time);
+      reorder_triangles();
+      centers_ = {};
+    }
+    {
+      stats::phase_timer_t timer(&stats::counters_t::batch_time);
+      triangles_batch_ = triangles_batch_t<T>(triangles_, get_leaf_begins());
+    }
+    if constexpr (stats::kIsEnabled) {
+      stats::update_max_depth(get_max_depth());
+    }
   }
 
+  // can be called from several threads simultaneously,
+  // children are visited in order of build_params.traversal_order
   [[nodiscard]] bool is_triangle_not_alone(
-    const triangle_with_box_t<T>& triangle,
+    const prepared_triangle_t<T>& triangle,
     std::size_t                   triangle_ind
   );
 
+  // Calls is_triangle_not_alone for every triangle of the tree.
+  // Triangles are processed in leaves order, chunks are distributed between threads dynamically.
+  void mark_not_alone_triangles(std::size_t num_threads = 1);
+
+  // Marks every triangle that intersects at least one other triangle.
+  // Traverses tree against itself: each pair of overlapping nodes is visited
+  // once and each candidate pair of triangles is tested once.
+  // With several threads, upper levels of traversal are split into independent tasks.
+  void mark_self_intersections(std::size_t num_threads = 1);
+
+  // Finds every pair of intersecting triangles, sorted. Unlike marking, traversal
+  // doesn't stop at the first hit of a triangle, so it's slower on dense scenes.
+  // Each thread collects pairs into its own buffer, buffers are merged in the end.
+  // max_num_pairs != 0 stops search, when that many pairs are found, then
+  // result has exactly max_num_pairs of them, which ones depends on threads timing.
+  [[nodiscard]] std::vector<index_pair_t> find_intersecting_pairs(
+    std::size_t num_threads   = 1,
+    std::size_t max_num_pairs = 0
+  ) const;
+
+  // Unites sets of every two intersecting triangles, so sets become clusters of
+  // mutually intersecting triangles. Candidate pairs already in one set are not tested,
+  // which skips most of exact tests on dense scenes. components must have a set per triangle.
+  void unite_intersecting_triangles(
+    concurrent_union_find_t& components,
+    std::size_t              num_threads = 1
+  ) const;
+
+  [[nodiscard]] bool is_marked(std::size_t triangle_ind) const {
+    return visited_[triangle_ind].load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::size_t get_num_nodes() const { return nodes_.size(); }
+
+  // bytes taken by one node
+  [[nodiscard]] static constexpr std::size_t get_node_size() { return sizeof(node_t); }
+
+  // walks the whole tree, it's for tuning builders, not for queries
+  [[nodiscard]] BVH_quality_t get_quality() const;
+
+  // Nodes (boxes, offsets, numbers of triangles) and order of triangles in leaves are
+  // exactly the same, it's for checking, that build doesn't depend on number of threads.
+  [[nodiscard]] bool is_same_tree(const BVH_t& other) const;
+
  private:
+  // All build methods work with range [begin, end) of triangle_ids_,
+  // which holds indices of triangles in input list during construction.
+
+  static constexpr std::array<utils::axis_t, 3> kAxes = {utils::axis_t::X, utils::axis_t::Y, utils::axis_t::Z};
+
+  struct SAH_bin_t {
+    AABB_t<T>   box   = {};
+    std::size_t count = 0;
+  };
+
+  // Buffers of one build thread, they are resized, not reallocated, on every node,
+  // so build makes no allocations besides nodes arrays.
+  struct build_scratch_t {
+    std::vector<SAH_bin_t> bins;
+    std::vector<T>         right_areas;
+    std::vector<T>         right_costs;
+  };
+
   AABB_t<T> find_bounding_box4triangs(
-    const indices_list_t& indices
+    std::size_t begin,
+    std::size_t end
   ) const;
 
-  void partition_triangles(
-    const AABB_t<T>&      box,
-    const indices_list_t& indices,
-    indices_list_t&       lhs,
-    indices_list_t&       rhs
+  // Partitions range in place, [begin, mid) goes to left child, [mid, end) to the right.
+  // Returns mid, if mid == begin or mid == end, node should become a leaf.
+  [[nodiscard]] std::size_t partition_triangles(
+    const AABB_t<T>& box,
+    std::size_t      begin,
+    std::size_t      end,
+    build_scratch_t& scratch
   );
 
-  void partition_triangles_by_ort_to_axis(
-    utils::axis_t         axis_name,
-    const AABB_t<T>&      box,
-    const indices_list_t& indices,
-    indices_list_t&       lhs,
-    indices_list_t&       rhs
+  [[nodiscard]] std::size_t partition_triangles_by_median(
+    std::size_t begin,
+    std::size_t end
   );
 
-  [[nodiscard]] std::unique_ptr<node_t> construct_BVH_tree(
-    const indices_list_t& indices,
-    std::size_t           depth
+  [[nodiscard]] std::size_t partition_triangles_by_SAH(
+    const AABB_t<T>& box,
+    std::size_t      begin,
+    std::size_t      end,
+    build_scratch_t& scratch
   );
 
-  [[nodiscard]] bool is_triangle_not_alone_rec(
-    const node_t*                 cur_node,
-    const triangle_with_box_t<T>& triangle,
-    std::size_t                   triangle_ind
+  [[nodiscard]] std::size_t partition_triangles_by_ort_to_axis(
+    utils::axis_t axis_name,
+    std::size_t   begin,
+    std::size_t   end
+  );
+
+  // Appends subtree to nodes, inner nodes refer to right children by indices in nodes.
+  // Big right subtrees are built by another thread into separate array and then appended.
+  void construct_BVH_tree(
+    std::size_t          begin,
+    std::size_t          end,
+    std::size_t          depth,
+    std::vector<node_t>& nodes,
+    build_scratch_t&     scratch
+  );
+
+  static void append_subtree(
+    std::vector<node_t>&       nodes,
+    const std::vector<node_t>& subtree
+  );
+
+  // 30 bit codes for float, 63 bit for double, i.e. 10 or 21 bits per axis
+  using morton_code_t = std::conditional_t<std::is_same_v<T, float>, std::uint32_t, std::uint64_t>;
+  static constexpr unsigned kMortonBitsPerAxis = std::is_same_v<T, float> ? 10 : 21;
+
+  // sorts triangle_ids_ by Morton codes of centers, then builds nodes_ from sorted ranges
+  void construct_LBVH();
+
+  // Same layout as construct_BVH_tree, but range is split, where codes change
+  // the highest differing bit, and boxes are computed bottom-up. Returns box of subtree.
+  AABB_t<T> construct_LBVH_tree(
+    std::size_t                       begin,
+    std::size_t                       end,
+    const std::vector<morton_code_t>& codes,
+    std::vector<node_t>&              nodes
+  );
+
+  // puts bits of coordinate quantized to kMortonBitsPerAxis bits into every third bit
+  [[nodiscard]] static morton_code_t spread_bits(morton_code_t value);
+
+  [[nodiscard]] bool try_take_build_thread();
+
+  // places triangles in leaves order, so each leaf is a contiguous range
+  void reorder_triangles();
+
+  [[nodiscard]] static triangs_list_t prepare_triangles(
+    const triangle_t<T>* triangles,
+    std::size_t          num_triangles,
+    const AABB_t<T>*     boxes
+  );
+
+  // first positions of leaves in triangles_, in increasing order
+  [[nodiscard]] indices_list_t get_leaf_begins() const;
+
+  // depth of the deepest leaf, root has depth 0
+  [[nodiscard]] std::size_t get_max_depth() const;
+
+  void count_leaf(BVH_leaf_reason_t reason) {
+    num_leaves_by_reason_[static_cast<std::size_t>(reason)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // everything one query needs, computed once per query
+  struct triangle_query_t {
+    const prepared_triangle_t<T>&          triangle;
+    std::size_t                            triangle_ind;
+    node_box_t                             box;
+    typename triangles_batch_t<T>::query_t batch_query;
+  };
+
+  // Box of the root is already known to overlap box of the triangle. Both traversals are
+  // iterative, deferred children are kept in a fixed size stack.
+
+  // Both children boxes are tested before descending, if both overlap, the child with
+  // nearer center is visited first, as it's more likely to have a hit, which ends the query.
+  [[nodiscard]] bool traverse_near_first(const triangle_query_t& query);
+
+  // Left child is visited first, right one is deferred untested and its box is tested,
+  // when it's popped, so it's not loaded at all, if left subtree already has a hit.
+  [[nodiscard]] bool traverse_left_first(const triangle_query_t& query);
+
+  // marks both triangles, if leaf has triangle, that intersects query
+  [[nodiscard]] bool test_leaf(
+    const node_t&           leaf,
+    const triangle_query_t& query
+  );
+
+  using node_pair_t = std::pair<std::size_t, std::size_t>;
+
+  // lhs_ind <= rhs_ind, equal indices mean pairs inside one subtree
+  void mark_self_intersections_rec(
+    std::size_t lhs_ind,
+    std::size_t rhs_ind
   );
 
+  // returns false if pair of nodes can't contain new intersections
+  [[nodiscard]] bool is_node_pair_worth_visiting(
+    std::size_t lhs_ind,
+    std::size_t rhs_ind
+  ) const;
+
+  // true if pair can't be split and its triangles should be tested
+  [[nodiscard]] bool is_leaves_pair(
+    std::size_t lhs_ind,
+    std::size_t rhs_ind
+  ) const;
+
+  // Writes pairs of nodes with overlapping boxes to descend into, returns their number.
+  // Pair must not be a pair of leaves.
+  [[nodiscard]] std::size_t split_node_pair(
+    std::size_t                 lhs_ind,
+    std::size_t                 rhs_ind,
+    std::array<node_pair_t, 3>& children
+  ) const;
+
+  // Expands upper levels of self traversal into independent pairs of nodes.
+  // use_marks skips pairs, that can't mark anything new.
+  [[nodiscard]] std::vector<node_pair_t> get_self_traversal_tasks(
+    std::size_t min_num_tasks,
+    bool        use_marks
+  ) const;
+
+  void test_leaves_pair(
+    std::size_t lhs_ind,
+    std::size_t rhs_ind
+  );
+
+  void mark_triangle(std::size_t pos);
+
+  // state of find_intersecting_pairs shared by all threads
+  struct pairs_search_t {
+    std::vector<std::vector<index_pair_t>> thread_pairs;
+    // 0 means no limit
+    std::size_t              max_num_pairs = 0;
+    std::atomic<std::size_t> num_found     = {0};
+
+    [[nodiscard]] bool is_limit_reached() const {
+      return max_num_pairs != 0 && num_found.load(std::memory_order_relaxed) >= max_num_pairs;
+    }
+  };
+
+  // state of unite_intersecting_triangles shared by all threads
+  struct components_search_t {
+    concurrent_union_find_t& components;
+    // first position in triangles_ of subtree of each node
+    indices_list_t           first_pos;
+    // set once all triangles of subtree are known to be in one component,
+    // never reset, as components only grow
+    std::vector<std::atomic<bool>> is_single;
+  };
+
+  // Visitor of self traversal without pruning by marks:
+  //   visit(lhs_ind, rhs_ind, thread_ind) is called for every pair of leaves with overlapping boxes,
+  //   pair of nodes isn't visited nor split, if is_skipped(lhs_ind, rhs_ind) returns true,
+  //   on_self_pair_done(node_ind) is called after all pairs inside subtree are visited,
+  //   except for upper subtrees, split into parallel tasks.
+  template<typename visit_func_t, typename skip_func_t, typename done_func_t>
+  void for_each_leaves_pair(
+    std::size_t  num_threads,
+    visit_func_t visit,
+    skip_func_t  is_skipped,
+    done_func_t  on_self_pair_done
+  ) const;
+
+  template<typename visit_func_t, typename skip_func_t, typename done_func_t>
+  void for_each_leaves_pair_rec(
+    std::size_t   lhs_ind,
+    std::size_t   rhs_ind,
+    visit_func_t& visit,
+    skip_func_t&  is_skipped,
+    done_func_t&  on_self_pair_done,
+    std::size_t   thread_ind
+  ) const;
+
+  // updates and returns is_single flag of node
+  [[nodiscard]] bool is_in_one_component(
+    std::size_t          node_ind,
+    components_search_t& search
+  ) const;
+
+  void find_pairs_in_leaves(
+    std::size_t     lhs_ind,
+    std::size_t     rhs_ind,
+    pairs_search_t& search,
+    std::size_t     thread_ind
+  ) const;
+
+  void unite_in_leaves(
+    std::size_t              lhs_ind,
+    std::size_t              rhs_ind,
+    concurrent_union_find_t& components
+  ) const;
+
  private:
-  class node_t {
-   private:
-    std::unique_ptr<node_t>         left_    = nullptr;
-    std::unique_ptr<node_t>         right_   = nullptr;
-    std::unique_ptr<indices_list_t> indices_ = {};
-
-   public:
-    AABB_t<T> box     = {};
-    bool      is_leaf = false;
-
-    // constructor for NON leaf node
-    node_t(const AABB_t<T>& box_, std::unique_ptr<node_t> left,
-           std::unique_ptr<node_t> right)
-        : box(box_), left_(std::move(left)), right_(std::move(right)) {}
-    // constructor for leaf node
-    node_t(const AABB_t<T>& box, indices_list_t indices)
-        : is_leaf(true), box(box),
-          indices_(std::make_unique<indices_list_t>(std::move(indices))) {}
-
-    const node_t*  left() const { return left_.get(); }
-    const node_t* right() const { return right_.get(); }
-    const indices_list_t& get_indices() const { return *indices_; }
+  [[nodiscard]] static node_box_t get_node_box(const AABB_t<T>& box) {
+    return node_box_t(inflated_AABB_t<T>(box));
+  }
+
+  // Nodes are stored in one array in depth first order, so left child
+  // of a node always goes right after it and only right child is referenced.
+  // Leaf owns range [offset, offset + num_triangles) of triangles_ array.
+  // For double it's exactly 64 bytes, i.e. one cache line, for float - 32 bytes.
+  struct node_t {
+    // inflated by epsilon, so overlap tests are branchless comparisons
+    node_box_t   box           = {};
+    // leaf: index of first triangle in triangles_, inner node: index of right child
+    node_index_t offset        = 0;
+    // 0 for inner nodes
+    node_index_t num_triangles = 0;
+
+    [[nodiscard]] bool is_leaf() const { return num_triangles != 0; }
+
+    [[nodiscard]] std::size_t left(std::size_t self_ind) const { return self_ind + 1; }
+    [[nodiscard]] std::size_t right() const { return offset; }
   };
 
  private:
-  const node_t* get_root() const { return root_.get(); }
+  static constexpr std::size_t kRootInd = 0;
+  // number of nodes is less than twice number of triangles
+  static constexpr std::size_t kMaxNumTriangles = std::numeric_limits<node_index_t>::max() / 2;
 
  private:
   static const std::size_t kLeafNumOfTriangles = 8;
+  // protection from degenerate recursion, SAH strategy has no other depth limit
+  static const std::size_t kMaxDepth           = 64;
+  // Path of traversal defers at most one child per level. LBVH split lowers either
+  // the highest differing bit of codes or halves range of equal codes, so its depth
+  // is less than code bits plus bits of node index, 127 at most.
+  static const std::size_t kTraversalStackSize = 128;
+
+  // number of triangles queried by thread at once in mark_not_alone_triangles
+  static const std::size_t kQueryChunkSize     = 256;
+  // self traversal is split into at least that many tasks per thread
+  static const std::size_t kTasksPerThread     = 32;
+  // smaller subtrees are always built by the thread that started them
+  static const std::size_t kParallelBuildMinTriangles = 4096;
 
  private:
   const std::size_t       num_triangles_;
-  const triangs_list_t    triangles_;
-  std::unique_ptr<node_t> root_ = nullptr;
-  std::vector<int>        visited_;
+  const build_params_t    build_params_;
+  // after construction triangles are stored in leaves order
+  triangs_list_t          triangles_;
+  // the same triangles in the same order, leaves are filtered with it before exact tests
+  triangles_batch_t<T>    triangles_batch_ = {};
+  // triangle_ids_[i] - index of triangles_[i] in the input list
+  indices_list_t          triangle_ids_ = {};
+  std::vector<node_t>     nodes_        = {};
+  // marks are set from several threads, relaxed order is enough, as
+  // they are read only after threads are joined
+  std::vector<std::atomic<bool>> visited_;
+
+  // used only by mark_self_intersections
+  indices_list_t          node_parents_ = {};
+  // number of not marked triangles in subtree of each node
+  std::vector<std::atomic<std::size_t>> num_unmarked_ = {};
+  // leaf_of_pos_[i] - index of leaf containing triangles_[i]
+  indices_list_t          leaf_of_pos_  = {};
+
+  // used only during construction
+  std::vector<point_t<T>>  centers_ = {};
+  std::atomic<std::size_t> free_build_threads_;
+
+  // for get_quality, leaves are counted from all build threads
+  std::array<std::atomic<std::size_t>, kNumBVHLeafReasons> num_leaves_by_reason_ = {};
 };
 
-template <typename T>
-[[nodiscard]] typename std::unique_ptr<typename BVH_t<T>::node_t> BVH_t<T>::construct_BVH_tree(
-  const indices_list_t& indices, std::size_t depth
+template <typename T, typename node_T>
+void BVH_t<T, node_T>::construct_BVH_tree(
+  std::size_t          begin,
+  std::size_t          end,
+  std::size_t          depth,
+  std::vector<node_t>& nodes,
+  build_scratch_t&     scratch
 ) {
-  AABB_t box = find_bounding_box4triangs(indices);
-  bool is_leaf = indices.size() <= kLeafNumOfTriangles;
-  indices_list_t lhs;
-  indices_list_t rhs;
+  AABB_t box = find_bounding_box4triangs(begin, end);
+  bool is_leaf = end - begin <= kLeafNumOfTriangles;
+  BVH_leaf_reason_t leaf_reason = BVH_leaf_reason_t::SMALL;
+  std::size_t mid = begin;
+
+  if (!is_leaf && depth >= kMaxDepth) {
+    is_leaf     = true;
+    leaf_reason = BVH_leaf_reason_t::DEPTH_LIMIT;
+  }
 
   if (!is_leaf) {
-    partition_triangles(box, indices, lhs, rhs);
+    mid = partition_triangles(box, begin, end, scratch);
+    is_leaf     = mid == begin || mid == end;
+    leaf_reason = BVH_leaf_reason_t::NO_SPLIT;
+  }
 
+  if (!is_leaf && build_params_.strategy == BVH_split_strategy_t::MEDIAN) {
     // TODO: redundant aabb search
-    AABB_t left_box  = find_bounding_box4triangs(lhs);
-    AABB_t right_box = find_bounding_box4triangs(rhs);
-    T inter_volume = left_box.get_intersection(right_box).get_volume();
-    if ((lhs.empty() || rhs.empty()) ||
-      (depth >= 8  && inter_volume > static_cast<T>(0.3) * box.get_volume()) ||
-      (depth >= 12 && inter_volume > static_cast<T>(0.1) * box.get_volume()) ||
-       depth >= 14) {
-      is_leaf = true;
+    AABB_t left_box  = find_bounding_box4triangs(begin, mid);
+    AABB_t right_box = find_bounding_box4triangs(mid,   end);
+    T inter_area = left_box.get_intersection(right_box).get_surface_area();
+    if (depth >= 14) {
+      is_leaf     = true;
+      leaf_reason = BVH_leaf_reason_t::DEPTH_LIMIT;
+    } else if ((depth >= 8  && inter_area > static_cast<T>(0.3) * box.get_surface_area()) ||
+               (depth >= 12 && inter_area > static_cast<T>(0.1) * box.get_surface_area())) {
+      is_leaf     = true;
+      leaf_reason = BVH_leaf_reason_t::OVERLAP;
     }
   }
 
+  const std::size_t cur_node_ind = nodes.size();
+  nodes.push_back({get_node_box(box), 0, 0});
   if (is_leaf) {
-    auto cur_node = std::make_unique<node_t>(box, std::move(indices));
-    return cur_node;
+    count_leaf(leaf_reason);
+    nodes[cur_node_ind].offset        = static_cast<node_index_t>(begin);
+    nodes[cur_node_ind].num_triangles = static_cast<node_index_t>(end - begin);
+    return;
+  }
+
+  // nodes may be reallocated by recursive calls, so no references are kept
+  if (end - begin >= kParallelBuildMinTriangles && try_take_build_thread()) {
+    std::vector<node_t> right_nodes;
+    auto right_task = std::async(std::launch::async, [this, mid, end, depth, &right_nodes]() {
+      build_scratch_t right_scratch;
+      construct_BVH_tree(mid, end, depth + 1, right_nodes, right_scratch);
+      free_build_threads_.fetch_add(1, std::memory_order_relaxed);
+    });
+    construct_BVH_tree(begin, mid, depth + 1, nodes, scratch);
+    right_task.get();
+
+    nodes[cur_node_ind].offset = static_cast<node_index_t>(nodes.size());
+    append_subtree(nodes, right_nodes);
+    return;
+  }
+
+  construct_BVH_tree(begin, mid, depth + 1, nodes, scratch);
+  nodes[cur_node_ind].offset = static_cast<node_index_t>(nodes.size());
+  construct_BVH_tree(mid, end, depth + 1, nodes, scratch);
+}
+
+template <typename T, typename node_T>
+void BVH_t<T, node_T>::append_subtree(
+  std::vector<node_t>&       nodes,
+  const std::vector<node_t>& subtree
+) {
+  const std::size_t base = nodes.size();
+  for (node_t node : subtree) {
+    if (!node.is_leaf()) {
+      node.offset += static_cast<node_index_t>(base);
+    }
+    nodes.push_back(node);
+  }
+}
+
+template <typename T, typename node_T>
+void BVH_t<T, node_T>::construct_LBVH() {
+  AABB_t<T> centers_box{centers_.front(), centers_.front()};
+  for (const point_t<T>& center : centers_) {
+    centers_box.unite_with(AABB_t<T>{center, center});
+  }
+
+  // every axis is quantized separately, flat scenes lose no bits on their zero extent
+  constexpr T kMaxQuantized = static_cast<T>((morton_code_t{1} << kMortonBitsPerAxis) - 1);
+  const point_t<T> scene_min = centers_box.get_min_corner();
+  const point_t<T> extent    = centers_box.get_max_corner() - scene_min;
+  auto get_scale = [&](T axis_extent) { return axis_extent > 0 ? kMaxQuantized / axis_extent : 0; };
+  const point_t<T> scale{get_scale(extent.x), get_scale(extent.y), get_scale(extent.z)};
+  auto quantize = [&](T coord, T min_coord, T axis_scale) {
+    T quantized = std::clamp((coord - min_coord) * axis_scale, static_cast<T>(0), kMaxQuantized);
+    return static_cast<morton_code_t>(quantized);
+  };
+
+  struct sort_item_t {
+    morton_code_t code;
+    std::size_t   ind;
+  };
+  std::vector<sort_item_t> items(num_triangles_);
+  const std::size_t num_threads = std::max(build_params_.num_threads, std::size_t{1});
+  parallel::for_each_chunk(num_threads, num_triangles_, kParallelBuildMinTriangles,
+    [&](std::size_t begin, std::size_t end, std::size_t) {
+      for (std::size_t i = begin; i < end; ++i) {
+        const point_t<T>& center = centers_[i];
+        morton_code_t code = spread_bits(quantize(center.x, scene_min.x, scale.x)) << 2 |
+                             spread_bits(quantize(center.y, scene_min.y, scale.y)) << 1 |
+                             spread_bits(quantize(center.z, scene_min.z, scale.z));
+        items[i] = {code, i};
+      }
+    }
+  );
+  radix_sort::sort(items, [](const sort_item_t& item) { return item.code; }, num_threads);
+
+  std::vector<morton_code_t> codes(num_triangles_);
+  for (std::size_t i = 0; i < num_triangles_; ++i) {
+    codes[i]         = items[i].code;
+    triangle_ids_[i] = items[i].ind;
+  }
+
+  static_cast<void>(construct_LBVH_tree(0, num_triangles_, codes, nodes_));
+}
+
+template <typename T, typename node_T>
+AABB_t<T> BVH_t<T, node_T>::construct_LBVH_tree(
+  std::size_t                       begin,
+  std::size_t                       end,
+  const std::vector<morton_code_t>& codes,
+  std::vector<node_t>&              nodes
+) {
+  const std::size_t cur_node_ind = nodes.size();
+  nodes.push_back({});
+  if (end - begin <= kLeafNumOfTriangles) {
+    count_leaf(BVH_leaf_reason_t::SMALL);
+    AABB_t<T> box = find_bounding_box4triangs(begin, end);
+    nodes[cur_node_ind] = {get_node_box(box), static_cast<node_index_t>(begin),
+                           static_cast<node_index_t>(end - begin)};
+    return box;
+  }
+
+  // codes in range share all bits above the highest differing one, left child gets
+  // codes with this bit unset; equal codes are just split in halves
+  std::size_t mid = begin + (end - begin) / 2;
+  morton_code_t differing_bits = codes[begin] ^ codes[end - 1];
+  if (differing_bits != 0) {
+    morton_code_t highest_bit = differing_bits;
+    while ((highest_bit & (highest_bit - 1)) != 0) {
+      highest_bit &= highest_bit - 1;
+    }
+    auto range_begin = codes.begin() + static_cast<std::ptrdiff_t>(begin);
+    auto range_end   = codes.begin() + static_cast<std::ptrdiff_t>(end);
+    mid = static_cast<std::size_t>(std::partition_point(range_begin, range_end,
+      [highest_bit](morton_code_t code) { return (code & highest_bit) == 0; }) - codes.begin());
+  }
+
+  AABB_t<T> box;
+  // nodes may be reallocated by recursive calls, so no references are kept
+  if (end - begin >= kParallelBuildMinTriangles && try_take_build_thread()) {
+    std::vector<node_t> right_nodes;
+    auto right_task = std::async(std::launch::async, [this, mid, end, &codes, &right_nodes]() {
+      AABB_t<T> right_box = construct_LBVH_tree(mid, end, codes, right_nodes);
+      free_build_threads_.fetch_add(1, std::memory_order_relaxed);
+      return right_box;
+    });
+    box = construct_LBVH_tree(begin, mid, codes, nodes);
+    box.unite_with(right_task.get());
+
+    nodes[cur_node_ind].offset = static_cast<node_index_t>(nodes.size());
+    append_subtree(nodes, right_nodes);
+  } else {
+    box = construct_LBVH_tree(begin, mid, codes, nodes);
+    nodes[cur_node_ind].offset = static_cast<node_index_t>(nodes.size());
+    box.unite_with(construct_LBVH_tree(mid, end, codes, nodes));
+  }
+
+  nodes[cur_node_ind].box = get_node_box(box);
+  return box;
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] typename BVH_t<T, node_T>::morton_code_t BVH_t<T, node_T>::spread_bits(morton_code_t value) {
+  if constexpr (sizeof(morton_code_t) == sizeof(std::uint32_t)) {
+    value = (value | (value << 16)) & 0x030000FFu;
+    value = (value | (value <<  8)) & 0x0300F00Fu;
+    value = (value | (value <<  4)) & 0x030C30C3u;
+    value = (value | (value <<  2)) & 0x09249249u;
+  } else {
+    value = (value | (value << 32)) & 0x001F00000000FFFFull;
+    value = (value | (value << 16)) & 0x001F0000FF0000FFull;
+    value = (value | (value <<  8)) & 0x100F00F00F00F00Full;
+    value = (value | (value <<  4)) & 0x10C30C30C30C30C3ull;
+    value = (value | (value <<  2)) & 0x1249249249249249ull;
+  }
+
+  return value;
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] bool BVH_t<T, node_T>::try_take_build_thread() {
+  std::size_t num_free = free_build_threads_.load(std::memory_order_relaxed);
+  while (num_free != 0) {
+    if (free_build_threads_.compare_exchange_weak(num_free, num_free - 1,
+                                                  std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+template <typename T, typename node_T>
+void BVH_t<T, node_T>::reorder_triangles() {
+  assert(triangle_ids_.size() == num_triangles_);
+
+  triangs_list_t reordered;
+  reordered.reserve(num_triangles_);
+  for (auto& id : triangle_ids_) {
+    reordered.push_back(triangles_[id]);
+  }
+  triangles_ = std::move(reordered);
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] typename BVH_t<T, node_T>::triangs_list_t BVH_t<T, node_T>::prepare_triangles(
+  const triangle_t<T>* triangles,
+  std::size_t          num_triangles,
+  const AABB_t<T>*     boxes
+) {
+  stats::phase_timer_t timer(&stats::counters_t::prepare_time);
+  triangs_list_t prepared;
+  prepared.reserve(num_triangles);
+  for (std::size_t i = 0; i < num_triangles; ++i) {
+    if (boxes != nullptr) {
+      prepared.emplace_back(triangles[i], boxes[i]);
+    } else {
+      prepared.emplace_back(triangles[i]);
+    }
+  }
+
+  return prepared;
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] typename BVH_t<T, node_T>::indices_list_t BVH_t<T, node_T>::get_leaf_begins() const {
+  indices_list_t leaf_begins;
+  // depth first order of nodes is the order of their ranges
+  for (const node_t& node : nodes_) {
+    if (node.is_leaf()) {
+      leaf_begins.push_back(node.offset);
+    }
+  }
+  assert(std::is_sorted(leaf_begins.begin(), leaf_begins.end()));
+
+  return leaf_begins;
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] std::size_t BVH_t<T, node_T>::get_max_depth() const {
+  // parents go before their children
+  indices_list_t depths(nodes_.size(), 0);
+  std::size_t max_depth = 0;
+  for (std::size_t node_ind = 0; node_ind < nodes_.size(); ++node_ind) {
+    const node_t& node = nodes_[node_ind];
+    max_depth = std::max(max_depth, depths[node_ind]);
+    if (!node.is_leaf()) {
+      depths[node.left(node_ind)] = depths[node.right()] = depths[node_ind] + 1;
+    }
+  }
+
+  return max_depth;
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] bool BVH_t<T, node_T>::is_same_tree(const BVH_t& other) const {
+  if (triangle_ids_ != other.triangle_ids_ || nodes_.size() != other.nodes_.size()) {
+    return false;
+  }
+
+  // tuples compare coordinates exactly, boxes of the same tree are bitwise equal
+  auto get_coords = [](const node_box_t& box) {
+    point_t<node_T> min = box.get_min_corner();
+    point_t<node_T> max = box.get_max_corner();
+    return std::make_tuple(min.x, min.y, min.z, max.x, max.y, max.z);
+  };
+  return std::equal(nodes_.begin(), nodes_.end(), other.nodes_.begin(),
+    [&](const node_t& lhs, const node_t& rhs) {
+      return lhs.offset == rhs.offset && lhs.num_triangles == rhs.num_triangles &&
+             get_coords(lhs.box) == get_coords(rhs.box);
+    }
+  );
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] BVH_quality_t BVH_t<T, node_T>::get_quality() const {
+  BVH_quality_t quality;
+  quality.num_nodes = nodes_.size();
+  for (std::size_t i = 0; i < kNumBVHLeafReasons; ++i) {
+    quality.leaves_by_reason[i] = num_leaves_by_reason_[i].load(std::memory_order_relaxed);
+  }
+  if (nodes_.empty()) {
+    return quality;
+  }
+
+  auto get_box = [this](std::size_t node_ind) {
+    auto to_double = [](const point_t<node_T>& point) {
+      return point_t<double>{static_cast<double>(point.x), static_cast<double>(point.y),
+                             static_cast<double>(point.z)};
+    };
+    const node_box_t& box = nodes_[node_ind].box;
+    return AABB_t<double>{to_double(box.get_min_corner()), to_double(box.get_max_corner())};
+  };
+
+  const double root_area         = get_box(kRootInd).get_surface_area();
+  const double traversal_cost    = static_cast<double>(build_params_.traversal_cost);
+  const double intersection_cost = static_cast<double>(build_params_.intersection_cost);
+  // parents go before their children
+  indices_list_t depths(nodes_.size(), 0);
+  for (std::size_t node_ind = 0; node_ind < nodes_.size(); ++node_ind) {
+    const node_t& node  = nodes_[node_ind];
+    const std::size_t depth = depths[node_ind];
+    if (quality.levels.size() <= depth) {
+      quality.levels.resize(depth + 1);
+    }
+    BVH_quality_t::level_t& level = quality.levels[depth];
+
+    const AABB_t<double> box = get_box(node_ind);
+    const double area_ratio  = root_area > 0 ? box.get_surface_area() / root_area : 1;
+    if (node.is_leaf()) {
+      const std::size_t size = node.num_triangles;
+      if (quality.leaf_sizes.size() <= size) {
+        quality.leaf_sizes.resize(size + 1);
+      }
+      ++quality.leaf_sizes[size];
+      ++quality.num_leaves;
+      ++level.num_leaves;
+      quality.SAH_cost += intersection_cost * static_cast<double>(size) * area_ratio;
+      continue;
+    }
+
+    std::size_t left_ind  = node.left(node_ind);
+    std::size_t right_ind = node.right();
+    depths[left_ind] = depths[right_ind] = depth + 1;
+    ++level.num_inner_nodes;
+    quality.SAH_cost += traversal_cost * area_ratio;
+    // boxes are inflated, so even nodes of flat scenes have volume
+    const double volume = box.get_volume();
+    if (volume > 0) {
+      level.mean_overlap_ratio += get_box(left_ind).get_intersection(get_box(right_ind)).get_volume() / volume;
+    }
+  }
+
+  for (auto& level : quality.levels) {
+    if (level.num_inner_nodes != 0) {
+      level.mean_overlap_ratio /= static_cast<double>(level.num_inner_nodes);
+    }
   }
+  quality.max_depth = quality.levels.size() - 1;
 
-  std::unique_ptr<node_t> left  = construct_BVH_tree(lhs, depth + 1);
-  std::unique_ptr<node_t> right = construct_BVH_tree(rhs, depth + 1);
-  auto cur_node = std::make_unique<node_t>(box, std::move(left), std::move(right));
-  return cur_node;
+  return quality;
 }
 
-template <typename T>
-[[nodiscard]] bool BVH_t<T>::is_triangle_not_alone(
-  const triangle_with_box_t<T>& triangle,
+template <typename T, typename node_T>
+[[nodiscard]] bool BVH_t<T, node_T>::is_triangle_not_alone(
+  const prepared_triangle_t<T>& triangle,
   std::size_t          triangle_ind
 ) {
-  if (visited_[triangle_ind]) {
+  if (is_marked(triangle_ind)) {
+    stats::add(&stats::counters_t::marked_exits);
     return true;
   }
 
-  bool is_not_alone = is_triangle_not_alone_rec(
-    get_root(), triangle, triangle_ind
+  if (nodes_.empty()) {
+    return false;
+  }
+
+  triangle_query_t query = {
+    triangle,
+    triangle_ind,
+    get_node_box(triangle.get_AABB()),
+    triangles_batch_t<T>::make_query(triangle, build_params_.narrow_phase_kernel)
+  };
+  if (!stats::count_AABB_test(nodes_[kRootInd].box.does_inter(query.box))) {
+    return false;
+  }
+
+  switch (build_params_.traversal_order) {
+    case BVH_traversal_order_t::NEAR_FIRST: return traverse_near_first(query);
+    case BVH_traversal_order_t::LEFT_FIRST: return traverse_left_first(query);
+    default:
+      assert(false && "unknown traversal order");
+      return traverse_near_first(query);
+  }
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] bool BVH_t<T, node_T>::traverse_near_first(const triangle_query_t& query) {
+  static_assert(kTraversalStackSize > kMaxDepth &&
+                kTraversalStackSize >= 3 * kMortonBitsPerAxis + std::numeric_limits<node_index_t>::digits);
+
+  std::array<node_index_t, kTraversalStackSize> stack;
+  std::size_t stack_size = 0;
+  std::size_t node_ind   = kRootInd;
+  while (true) {
+    stats::add(&stats::counters_t::nodes_visited);
+    const node_t& node = nodes_[node_ind];
+    if (node.is_leaf()) {
+      if (test_leaf(node, query)) {
+        return true;
+      }
+    } else {
+      // descends without stack, only the farther child is deferred
+      std::size_t near_ind = node.left(node_ind);
+      std::size_t far_ind  = node.right();
+      const bool is_near_overlapped = stats::count_AABB_test(query.box.does_inter(nodes_[near_ind].box));
+      const bool is_far_overlapped  = stats::count_AABB_test(query.box.does_inter(nodes_[far_ind].box));
+      if (is_near_overlapped && is_far_overlapped) {
+        // on equal distance left child goes first, SAH builder puts bigger child there
+        if (query.box.get_doubled_center_dist(nodes_[far_ind].box) <
+            query.box.get_doubled_center_dist(nodes_[near_ind].box)) {
+          std::swap(near_ind, far_ind);
+        }
+        stack[stack_size++] = static_cast<node_index_t>(far_ind);
+        node_ind = near_ind;
+        continue;
+      }
+      if (is_near_overlapped || is_far_overlapped) {
+        node_ind = is_near_overlapped ? near_ind : far_ind;
+        continue;
+      }
+    }
+
+    // deferred children are already known to overlap query
+    if (stack_size == 0) {
+      return false;
+    }
+    node_ind = stack[--stack_size];
+  }
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] bool BVH_t<T, node_T>::traverse_left_first(const triangle_query_t& query) {
+  std::array<node_index_t, kTraversalStackSize> stack;
+  std::size_t stack_size = 0;
+  std::size_t node_ind   = kRootInd;
+  while (true) {
+    stats::add(&stats::counters_t::nodes_visited);
+    const node_t& node = nodes_[node_ind];
+    if (node.is_leaf()) {
+      if (test_leaf(node, query)) {
+        return true;
+      }
+    } else {
+      // SAH builder puts bigger child to the left
+      stack[stack_size++] = static_cast<node_index_t>(node.right());
+      const std::size_t left_ind = node.left(node_ind);
+      if (stats::count_AABB_test(query.box.does_inter(nodes_[left_ind].box))) {
+        node_ind = left_ind;
+        continue;
+      }
+    }
+
+    // deferred children are tested only now, many of them are never popped
+    do {
+      if (stack_size == 0) {
+        return false;
+      }
+      node_ind = stack[--stack_size];
+    } while (!stats::count_AABB_test(query.box.does_inter(nodes_[node_ind].box)));
+  }
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] bool BVH_t<T, node_T>::test_leaf(
+  const node_t&           leaf,
+  const triangle_query_t& query
+) {
+  const std::size_t leaf_end = leaf.offset + leaf.num_triangles;
+  return triangles_batch_.for_each_candidate(query.batch_query, leaf.offset, leaf_end,
+    [&](std::size_t pos) {
+      // we don't want count triangle intersection with itself
+      std::size_t ind = triangle_ids_[pos];
+      if (ind == query.triangle_ind ||
+          !triangles_[pos].does_intersect(query.triangle, build_params_.narrow_phase_kernel)) {
+        return false;
+      }
+
+      visited_[ind].store(true, std::memory_order_relaxed);
+      visited_[query.triangle_ind].store(true, std::memory_order_relaxed);
+      return true;
+    }
+  );
+}
+
+template <typename T, typename node_T>
+void BVH_t<T, node_T>::mark_not_alone_triangles(std::size_t num_threads) {
+  parallel::for_each_chunk(num_threads, num_triangles_, kQueryChunkSize,
+    [this](std::size_t begin, std::size_t end, std::size_t) {
+      for (std::size_t pos = begin; pos < end; ++pos) {
+        // result is stored in marks
+        static_cast<void>(is_triangle_not_alone(triangles_[pos], triangle_ids_[pos]));
+      }
+    }
   );
+}
+
+template <typename T, typename node_T>
+void BVH_t<T, node_T>::mark_self_intersections(std::size_t num_threads) {
+  if (nodes_.empty()) {
+    return;
+  }
+
+  node_parents_.assign(nodes_.size(), kRootInd);
+  num_unmarked_ = std::vector<std::atomic<std::size_t>>(nodes_.size());
+  leaf_of_pos_.assign(num_triangles_, kRootInd);
+  // children always have bigger indices than their parent
+  for (std::size_t node_ind = nodes_.size(); node_ind-- > 0;) {
+    const node_t& node = nodes_[node_ind];
+    if (node.is_leaf()) {
+      std::size_t num_unmarked = 0;
+      const std::size_t leaf_end = node.offset + node.num_triangles;
+      for (std::size_t pos = node.offset; pos < leaf_end; ++pos) {
+        leaf_of_pos_[pos] = node_ind;
+        if (!is_marked(triangle_ids_[pos])) {
+          ++num_unmarked;
+        }
+      }
+      num_unmarked_[node_ind] = num_unmarked;
+      continue;
+    }
+
+    std::size_t left_ind  = node.left(node_ind);
+    std::size_t right_ind = node.right();
+    node_parents_[left_ind] = node_parents_[right_ind] = node_ind;
+    num_unmarked_[node_ind] = num_unmarked_[left_ind] + num_unmarked_[right_ind];
+  }
+
+  if (num_threads <= 1) {
+    mark_self_intersections_rec(kRootInd, kRootInd);
+    return;
+  }
 
-  return is_not_alone;
+  std::vector<node_pair_t> tasks = get_self_traversal_tasks(num_threads * kTasksPerThread, true);
+  parallel::for_each_chunk(num_threads, tasks.size(), 1,
+    [this, &tasks](std::size_t begin, std::size_t end, std::size_t) {
+      for (std::size_t task_ind = begin; task_ind < end; ++task_ind) {
+        mark_self_intersections_rec(tasks[task_ind].first, tasks[task_ind].second);
+      }
+    }
+  );
 }
 
-template <typename T>
-[[nodiscard]] bool BVH_t<T>::is_triangle_not_alone_rec(
-  const node_t*                 cur_node,
-  const triangle_with_box_t<T>& triangle,
-  std::size_t                   triangle_ind
+template <typename T, typename node_T>
+void BVH_t<T, node_T>::mark_self_intersections_rec(
+  std::size_t lhs_ind,
+  std::size_t rhs_ind
 ) {
-  if (!cur_node->box.does_inter(triangle.get_AABB())) {
-    return false;
+  if (!is_node_pair_worth_visiting(lhs_ind, rhs_ind)) {
+    stats::add(&stats::counters_t::marked_exits);
+    return;
+  }
+
+  stats::add(&stats::counters_t::nodes_visited);
+  if (is_leaves_pair(lhs_ind, rhs_ind)) {
+    test_leaves_pair(lhs_ind, rhs_ind);
+    return;
+  }
+
+  std::array<node_pair_t, 3> children;
+  std::size_t num_children = split_node_pair(lhs_ind, rhs_ind, children);
+  for (std::size_t i = 0; i < num_children; ++i) {
+    mark_self_intersections_rec(children[i].first, children[i].second);
+  }
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] bool BVH_t<T, node_T>::is_node_pair_worth_visiting(
+  std::size_t lhs_ind,
+  std::size_t rhs_ind
+) const {
+  // nothing new can be found, all triangles of both subtrees are already marked
+  return num_unmarked_[lhs_ind].load(std::memory_order_relaxed) != 0 ||
+         num_unmarked_[rhs_ind].load(std::memory_order_relaxed) != 0;
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] bool BVH_t<T, node_T>::is_leaves_pair(
+  std::size_t lhs_ind,
+  std::size_t rhs_ind
+) const {
+  return nodes_[lhs_ind].is_leaf() && nodes_[rhs_ind].is_leaf();
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] std::size_t BVH_t<T, node_T>::split_node_pair(
+  std::size_t                 lhs_ind,
+  std::size_t                 rhs_ind,
+  std::array<node_pair_t, 3>& children
+) const {
+  assert(!is_leaves_pair(lhs_ind, rhs_ind));
+  const node_t& lhs = nodes_[lhs_ind];
+  const node_t& rhs = nodes_[rhs_ind];
+  if (lhs_ind == rhs_ind) {
+    std::size_t left_ind  = lhs.left(lhs_ind);
+    std::size_t right_ind = lhs.right();
+    children[0] = {left_ind,  left_ind};
+    children[1] = {right_ind, right_ind};
+    if (!stats::count_AABB_test(nodes_[left_ind].box.does_inter(nodes_[right_ind].box))) {
+      return 2;
+    }
+
+    children[2] = {left_ind,  right_ind};
+    return 3;
+  }
+
+  // subtrees are disjoint ranges of nodes_, so order of indices is preserved
+  bool split_lhs = rhs.is_leaf() ||
+    (!lhs.is_leaf() && lhs.box.get_surface_area() > rhs.box.get_surface_area());
+  const node_t&     split_node = split_lhs ? lhs     : rhs;
+  const std::size_t split_ind  = split_lhs ? lhs_ind : rhs_ind;
+  const node_t&     other_node = split_lhs ? rhs     : lhs;
+
+  std::array<std::size_t, 2> split_children = {split_node.left(split_ind), split_node.right()};
+  std::uint32_t mask = other_node.box.get_overlap_mask(nodes_[split_children[0]].box,
+                                                       nodes_[split_children[1]].box);
+  stats::add(&stats::counters_t::AABB_tests, 2);
+  stats::add(&stats::counters_t::AABB_hits,  (mask & 1) + ((mask >> 1) & 1));
+  std::size_t num_children = 0;
+  for (std::size_t i = 0; i < split_children.size(); ++i) {
+    if ((mask >> i) & 1) {
+      children[num_children++] = split_lhs ? node_pair_t{split_children[i], rhs_ind}
+                                           : node_pair_t{lhs_ind, split_children[i]};
+    }
   }
 
-  if (cur_node->is_leaf) {
-    for (auto& ind : cur_node->get_indices()) {
-      if (!triangles_[ind].get_AABB().does_inter(triangle.get_AABB())) {
+  return num_children;
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] std::vector<typename BVH_t<T, node_T>::node_pair_t> BVH_t<T, node_T>::get_self_traversal_tasks(
+  std::size_t min_num_tasks,
+  bool        use_marks
+) const {
+  // pairs of leaves can't be split, they are moved to result right away
+  std::vector<node_pair_t> tasks;
+  std::vector<node_pair_t> cur_level = {{kRootInd, kRootInd}};
+  std::vector<node_pair_t> next_level;
+  std::array<node_pair_t, 3> children;
+  while (!cur_level.empty() && tasks.size() + cur_level.size() < min_num_tasks) {
+    next_level.clear();
+    for (auto& [lhs_ind, rhs_ind] : cur_level) {
+      if (use_marks && !is_node_pair_worth_visiting(lhs_ind, rhs_ind)) {
         continue;
       }
 
-      if (triangles_[ind].does_intersect(triangle) && 
-          ind != triangle_ind) {
-        visited_[ind] = visited_[triangle_ind] = true;
-        // we don't want count triangle intersection with itself
+      if (is_leaves_pair(lhs_ind, rhs_ind)) {
+        tasks.emplace_back(lhs_ind, rhs_ind);
+        continue;
+      }
+
+      std::size_t num_children = split_node_pair(lhs_ind, rhs_ind, children);
+      next_level.insert(next_level.end(), children.begin(), children.begin() + num_children);
+    }
+    std::swap(cur_level, next_level);
+  }
+
+  tasks.insert(tasks.end(), cur_level.begin(), cur_level.end());
+  return tasks;
+}
+
+template <typename T, typename node_T>
+void BVH_t<T, node_T>::test_leaves_pair(
+  std::size_t lhs_ind,
+  std::size_t rhs_ind
+) {
+  const node_t& lhs = nodes_[lhs_ind];
+  const node_t& rhs = nodes_[rhs_ind];
+  const std::size_t lhs_end = lhs.offset + lhs.num_triangles;
+  const std::size_t rhs_end = rhs.offset + rhs.num_triangles;
+  for (std::size_t lhs_pos = lhs.offset; lhs_pos < lhs_end; ++lhs_pos) {
+    // marked triangle may only help to mark triangles of the other leaf
+    if (is_marked(triangle_ids_[lhs_pos]) &&
+        num_unmarked_[rhs_ind].load(std::memory_order_relaxed) == 0) {
+      stats::add(&stats::counters_t::marked_exits);
+      continue;
+    }
+
+    const prepared_triangle_t<T>& lhs_triangle = triangles_[lhs_pos];
+    auto query = triangles_batch_t<T>::make_query(lhs_triangle, build_params_.narrow_phase_kernel);
+
+    // inside one leaf every pair is tested once
+    std::size_t rhs_begin = lhs_ind == rhs_ind ? lhs_pos + 1 : rhs.offset;
+    static_cast<void>(triangles_batch_.for_each_candidate(query, rhs_begin, rhs_end,
+      [&](std::size_t rhs_pos) {
+        if (is_marked(triangle_ids_[lhs_pos]) && is_marked(triangle_ids_[rhs_pos])) {
+          stats::add(&stats::counters_t::marked_exits);
+          return false;
+        }
+
+        if (lhs_triangle.does_intersect(triangles_[rhs_pos], build_params_.narrow_phase_kernel)) {
+          mark_triangle(lhs_pos);
+          mark_triangle(rhs_pos);
+        }
+        return false;
+      }
+    ));
+  }
+}
+
+template <typename T, typename node_T>
+void BVH_t<T, node_T>::mark_triangle(std::size_t pos) {
+  // only one thread may decrement counters for the triangle
+  if (visited_[triangle_ids_[pos]].exchange(true, std::memory_order_relaxed)) {
+    return;
+  }
+
+  for (std::size_t node_ind = leaf_of_pos_[pos]; ; node_ind = node_parents_[node_ind]) {
+    num_unmarked_[node_ind].fetch_sub(1, std::memory_order_relaxed);
+    if (node_ind == kRootInd) {
+      break;
+    }
+  }
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] std::vector<typename BVH_t<T, node_T>::index_pair_t> BVH_t<T, node_T>::find_intersecting_pairs(
+  std::size_t num_threads,
+  std::size_t max_num_pairs
+) const {
+  if (nodes_.empty()) {
+    return {};
+  }
+
+  num_threads = std::max(num_threads, std::size_t{1});
+  pairs_search_t search;
+  search.thread_pairs.resize(num_threads);
+  search.max_num_pairs = max_num_pairs;
+  for_each_leaves_pair(num_threads,
+    [this, &search](std::size_t lhs_ind, std::size_t rhs_ind, std::size_t thread_ind) {
+      find_pairs_in_leaves(lhs_ind, rhs_ind, search, thread_ind);
+    },
+    [&search](std::size_t, std::size_t) { return search.is_limit_reached(); },
+    [](std::size_t) {}
+  );
+
+  std::size_t num_pairs = 0;
+  for (const auto& pairs : search.thread_pairs) {
+    num_pairs += pairs.size();
+  }
+
+  std::vector<index_pair_t> result;
+  result.reserve(num_pairs);
+  for (auto& pairs : search.thread_pairs) {
+    result.insert(result.end(), pairs.begin(), pairs.end());
+    pairs = {};
+  }
+  std::sort(result.begin(), result.end());
+  // threads may overshoot the limit a little, before they see it's reached
+  if (max_num_pairs != 0 && result.size() > max_num_pairs) {
+    result.resize(max_num_pairs);
+  }
+
+  return result;
+}
+
+template <typename T, typename node_T>
+void BVH_t<T, node_T>::unite_intersecting_triangles(
+  concurrent_union_find_t& components,
+  std::size_t              num_threads
+) const {
+  assert(components.get_size() == num_triangles_);
+  if (nodes_.empty()) {
+    return;
+  }
+
+  components_search_t search = {components, indices_list_t(nodes_.size()),
+                                 std::vector<std::atomic<bool>>(nodes_.size())};
+  // children always have bigger indices than their parent
+  for (std::size_t node_ind = nodes_.size(); node_ind-- > 0;) {
+    const node_t& node = nodes_[node_ind];
+    search.first_pos[node_ind] = node.is_leaf() ? node.offset
+                                                : search.first_pos[node.left(node_ind)];
+  }
+
+  // Pair of subtrees, that are already in one component, can't change components,
+  // so it's skipped as a whole. On dense scenes most of pairs are skipped this way.
+  for_each_leaves_pair(std::max(num_threads, std::size_t{1}),
+    [this, &components](std::size_t lhs_ind, std::size_t rhs_ind, std::size_t) {
+      unite_in_leaves(lhs_ind, rhs_ind, components);
+    },
+    [this, &search](std::size_t lhs_ind, std::size_t rhs_ind) {
+      if (!is_in_one_component(lhs_ind, search)) {
+        return false;
+      }
+      if (lhs_ind == rhs_ind) {
         return true;
       }
+
+      return is_in_one_component(rhs_ind, search) &&
+             search.components.is_same(triangle_ids_[search.first_pos[lhs_ind]],
+                                       triangle_ids_[search.first_pos[rhs_ind]]);
+    },
+    [this, &search](std::size_t node_ind) {
+      static_cast<void>(is_in_one_component(node_ind, search));
     }
+  );
+}
 
-    return false;
+template <typename T, typename node_T>
+[[nodiscard]] bool BVH_t<T, node_T>::is_in_one_component(
+  std::size_t          node_ind,
+  components_search_t& search
+) const {
+  if (search.is_single[node_ind].load(std::memory_order_relaxed)) {
+    return true;
+  }
+
+  const node_t& node = nodes_[node_ind];
+  const std::size_t first_id = triangle_ids_[search.first_pos[node_ind]];
+  bool is_single = true;
+  if (node.is_leaf()) {
+    const std::size_t leaf_end = node.offset + node.num_triangles;
+    for (std::size_t pos = node.offset + 1; pos < leaf_end && is_single; ++pos) {
+      is_single = search.components.is_same(first_id, triangle_ids_[pos]);
+    }
+  } else {
+    // only flags of children are checked, so the cost is constant
+    std::size_t left_ind  = node.left(node_ind);
+    std::size_t right_ind = node.right();
+    is_single = search.is_single[left_ind].load(std::memory_order_relaxed) &&
+                search.is_single[right_ind].load(std::memory_order_relaxed) &&
+                search.components.is_same(first_id, triangle_ids_[search.first_pos[right_ind]]);
   }
 
-  bool is_inter = is_triangle_not_alone_rec(cur_node->left(), triangle, triangle_ind);
-  if (!is_inter) {
-    is_inter = is_triangle_not_alone_rec(cur_node->right(), triangle, triangle_ind);
+  if (is_single) {
+    search.is_single[node_ind].store(true, std::memory_order_relaxed);
+  }
+  return is_single;
+}
+
+template <typename T, typename node_T>
+template <typename visit_func_t, typename skip_func_t, typename done_func_t>
+void BVH_t<T, node_T>::for_each_leaves_pair(
+  std::size_t  num_threads,
+  visit_func_t visit,
+  skip_func_t  is_skipped,
+  done_func_t  on_self_pair_done
+) const {
+  if (num_threads <= 1) {
+    for_each_leaves_pair_rec(kRootInd, kRootInd, visit, is_skipped, on_self_pair_done, 0);
+    return;
+  }
+
+  std::vector<node_pair_t> tasks = get_self_traversal_tasks(num_threads * kTasksPerThread, false);
+  parallel::for_each_chunk(num_threads, tasks.size(), 1,
+    [&](std::size_t begin, std::size_t end, std::size_t thread_ind) {
+      for (std::size_t task_ind = begin; task_ind < end; ++task_ind) {
+        for_each_leaves_pair_rec(tasks[task_ind].first, tasks[task_ind].second,
+                                 visit, is_skipped, on_self_pair_done, thread_ind);
+      }
+    }
+  );
+}
+
+template <typename T, typename node_T>
+template <typename visit_func_t, typename skip_func_t, typename done_func_t>
+void BVH_t<T, node_T>::for_each_leaves_pair_rec(
+  std::size_t   lhs_ind,
+  std::size_t   rhs_ind,
+  visit_func_t& visit,
+  skip_func_t&  is_skipped,
+  done_func_t&  on_self_pair_done,
+  std::size_t   thread_ind
+) const {
+  if (is_skipped(lhs_ind, rhs_ind)) {
+    return;
+  }
+
+  stats::add(&stats::counters_t::nodes_visited);
+  if (is_leaves_pair(lhs_ind, rhs_ind)) {
+    visit(lhs_ind, rhs_ind, thread_ind);
+  } else {
+    std::array<node_pair_t, 3> children;
+    std::size_t num_children = split_node_pair(lhs_ind, rhs_ind, children);
+    for (std::size_t i = 0; i < num_children; ++i) {
+      for_each_leaves_pair_rec(children[i].first, children[i].second,
+                               visit, is_skipped, on_self_pair_done, thread_ind);
+    }
   }
 
-  return is_inter;
+  if (lhs_ind == rhs_ind) {
+    on_self_pair_done(lhs_ind);
+  }
 }
 
-template <typename T>
-[[nodiscard]] AABB_t<T> BVH_t<T>::find_bounding_box4triangs(
-  const indices_list_t& indices
+template <typename T, typename node_T>
+void BVH_t<T, node_T>::find_pairs_in_leaves(
+  std::size_t     lhs_ind,
+  std::size_t     rhs_ind,
+  pairs_search_t& search,
+  std::size_t     thread_ind
+) const {
+  const node_t& lhs = nodes_[lhs_ind];
+  const node_t& rhs = nodes_[rhs_ind];
+  const std::size_t lhs_end = lhs.offset + lhs.num_triangles;
+  const std::size_t rhs_end = rhs.offset + rhs.num_triangles;
+  std::vector<index_pair_t>& pairs = search.thread_pairs[thread_ind];
+  for (std::size_t lhs_pos = lhs.offset; lhs_pos < lhs_end; ++lhs_pos) {
+    const prepared_triangle_t<T>& lhs_triangle = triangles_[lhs_pos];
+    auto query = triangles_batch_t<T>::make_query(lhs_triangle, build_params_.narrow_phase_kernel);
+
+    // inside one leaf every pair is tested once
+    std::size_t rhs_begin = lhs_ind == rhs_ind ? lhs_pos + 1 : rhs.offset;
+    bool is_stopped = triangles_batch_.for_each_candidate(query, rhs_begin, rhs_end,
+      [&](std::size_t rhs_pos) {
+        if (!lhs_triangle.does_intersect(triangles_[rhs_pos], build_params_.narrow_phase_kernel)) {
+          return false;
+        }
+
+        std::size_t lhs_id = triangle_ids_[lhs_pos];
+        std::size_t rhs_id = triangle_ids_[rhs_pos];
+        pairs.emplace_back(std::min(lhs_id, rhs_id), std::max(lhs_id, rhs_id));
+        if (search.max_num_pairs == 0) {
+          return false;
+        }
+
+        return search.num_found.fetch_add(1, std::memory_order_relaxed) + 1 >= search.max_num_pairs;
+      }
+    );
+
+    if (is_stopped || search.is_limit_reached()) {
+      return;
+    }
+  }
+}
+
+template <typename T, typename node_T>
+void BVH_t<T, node_T>::unite_in_leaves(
+  std::size_t              lhs_ind,
+  std::size_t              rhs_ind,
+  concurrent_union_find_t& components
+) const {
+  const node_t& lhs = nodes_[lhs_ind];
+  const node_t& rhs = nodes_[rhs_ind];
+  const std::size_t lhs_end = lhs.offset + lhs.num_triangles;
+  const std::size_t rhs_end = rhs.offset + rhs.num_triangles;
+  for (std::size_t lhs_pos = lhs.offset; lhs_pos < lhs_end; ++lhs_pos) {
+    const prepared_triangle_t<T>& lhs_triangle = triangles_[lhs_pos];
+    const std::size_t lhs_id = triangle_ids_[lhs_pos];
+    auto query = triangles_batch_t<T>::make_query(lhs_triangle, build_params_.narrow_phase_kernel);
+
+    // inside one leaf every pair is tested once
+    std::size_t rhs_begin = lhs_ind == rhs_ind ? lhs_pos + 1 : rhs.offset;
+    static_cast<void>(triangles_batch_.for_each_candidate(query, rhs_begin, rhs_end,
+      [&](std::size_t rhs_pos) {
+        // exact test is much more expensive than lookup in union find
+        const std::size_t rhs_id = triangle_ids_[rhs_pos];
+        if (!components.is_same(lhs_id, rhs_id) &&
+            lhs_triangle.does_intersect(triangles_[rhs_pos], build_params_.narrow_phase_kernel)) {
+          components.unite(lhs_id, rhs_id);
+        }
+        return false;
+      }
+    ));
+  }
+}
+
+template <typename T, typename node_T>
+[[nodiscard]] AABB_t<T> BVH_t<T, node_T>::find_bounding_box4triangs(
+  std::size_t begin,
+  std::size_t end
 ) const {
   AABB_t<T> box;
-  if (indices.empty()) {
+  if (begin == end) {
     return box;
   }
 
-  box = triangles_[indices.front()].get_AABB();
-  for (std::size_t i = 1; i < indices.size(); ++i) {
-    box.unite_with(triangles_[indices[i]].get_AABB());
+  box = triangles_[triangle_ids_[begin]].get_AABB();
+  for (std::size_t i = begin + 1; i < end; ++i) {
+    box.unite_with(triangles_[triangle_ids_[i]].get_AABB());
   }
 
   return box;
 }
 
-template <typename U>
-inline void BVH_t<U>::partition_triangles(
-  const AABB_t<U>&      box,
-  const indices_list_t& indices,
-  indices_list_t&       lhs,
-  indices_list_t&       rhs
+template <typename U, typename node_T>
+[[nodiscard]] inline std::size_t BVH_t<U, node_T>::partition_triangles(
+  const AABB_t<U>& box,
+  std::size_t      begin,
+  std::size_t      end,
+  build_scratch_t& scratch
 ) {
-  const std::vector<utils::axis_t> axes = {
-    utils::axis_t::X,
-    utils::axis_t::Y,
-    utils::axis_t::Z
-  };
+  switch (build_params_.strategy) {
+    case BVH_split_strategy_t::MEDIAN:
+      return partition_triangles_by_median(begin, end);
+    case BVH_split_strategy_t::BINNED_SAH:
+      return partition_triangles_by_SAH(box, begin, end, scratch);
+    case BVH_split_strategy_t::LBVH:
+      // LBVH is built by construct_LBVH, it splits ranges by Morton codes
+      assert(false && "LBVH doesn't partition triangles");
+      return begin;
+    default:
+      assert(false);
+      return begin;
+  }
+}
 
-  indices_list_t lhs2;
-  indices_list_t rhs2;
+template <typename U, typename node_T>
+[[nodiscard]] inline std::size_t BVH_t<U, node_T>::partition_triangles_by_median(
+  std::size_t begin,
+  std::size_t end
+) {
   U best_cost = std::numeric_limits<U>::max();
-  for (auto axis : axes) {
-    partition_triangles_by_ort_to_axis(
-      axis, box, indices, lhs2, rhs2
-    );
+  utils::axis_t best_axis = kAxes.front();
+  for (auto axis : kAxes) {
+    std::size_t mid = partition_triangles_by_ort_to_axis(axis, begin, end);
 
-    AABB_t left_box  = find_bounding_box4triangs(lhs2);
-    AABB_t right_box = find_bounding_box4triangs(rhs2);
-    U cost = left_box.get_volume() * lhs2.size() + right_box.get_volume() * rhs2.size();
+    AABB_t left_box  = find_bounding_box4triangs(begin, mid);
+    AABB_t right_box = find_bounding_box4triangs(mid,   end);
+    U cost = left_box.get_surface_area()  * static_cast<U>(mid - begin) +
+             right_box.get_surface_area() * static_cast<U>(end - mid);
     if (cost < best_cost) {
       best_cost = cost;
-      std::swap(lhs, lhs2);
-      std::swap(rhs, rhs2);
+      best_axis = axis;
     }
   }
+
+  return partition_triangles_by_ort_to_axis(best_axis, begin, end);
 }
 
-template <typename U>
-inline void BVH_t<U>::partition_triangles_by_ort_to_axis(
-  utils::axis_t         axis_name,
-  const AABB_t<U>&      box,
-  const indices_list_t& indices,
-  indices_list_t&       lhs,
-  indices_list_t&       rhs
+template <typename U, typename node_T>
+[[nodiscard]] inline std::size_t BVH_t<U, node_T>::partition_triangles_by_ort_to_axis(
+  utils::axis_t axis_name,
+  std::size_t   begin,
+  std::size_t   end
 ) {
-  // setLoggingLevel(DEBUG);
-  // utils::axis_t longest_axis_ind = box.get_longest_axis_ind();
-  // LOG_DEBUG_VARS(static_cast<std::size_t>(longest_axis_ind));
-  // std::cerr << "axis : "  << static_cast<std::size_t>(longest_axis_ind) << std::endl;
+  auto get_coord = [this, axis_name](std::size_t ind) {
+    return centers_[ind].get_coord_by_axis_name(axis_name);
+  };
+  auto cmp_by_coord = [&get_coord](std::size_t lhs, std::size_t rhs) {
+    return utils::sign(get_coord(lhs) - get_coord(rhs)) < utils::signs_t::ZERO;
+  };
 
-  using proj_pair_t = std::pair<U, std::size_t>;
-  std::vector<proj_pair_t> projection_pairs;
-  for (auto& ind : indices) {
-    U coord = triangles_[ind].get_center().get_coord_by_axis_name(axis_name);
-    projection_pairs.emplace_back(coord, ind);
+  auto range_begin = triangle_ids_.begin() + static_cast<std::ptrdiff_t>(begin);
+  auto range_end   = triangle_ids_.begin() + static_cast<std::ptrdiff_t>(end);
+  auto range_mid   = range_begin + static_cast<std::ptrdiff_t>((end - begin) / 2);
+  std::nth_element(range_begin, range_mid, range_end, cmp_by_coord);
+  U partition_coord = get_coord(*range_mid);
+
+  auto left_end = std::partition(range_begin, range_end,
+    [&get_coord, partition_coord](std::size_t ind) {
+      return utils::sign(get_coord(ind) - partition_coord) <= utils::signs_t::ZERO;
+    }
+  );
+
+  return static_cast<std::size_t>(left_end - triangle_ids_.begin());
+}
+
+// Binned SAH (I. Wald, "On fast Construction of SAH-based Bounding Volume Hierarchies").
+// Triangle centers are distributed into num_bins equal bins along each axis,
+// split candidates are bins borders. Cost of the split:
+//   traversal_cost + intersection_cost * (S_l * N_l + S_r * N_r) / S
+// where S - surface area of the box, N - number of triangles.
+template <typename U, typename node_T>
+[[nodiscard]] std::size_t BVH_t<U, node_T>::partition_triangles_by_SAH(
+  const AABB_t<U>& box,
+  std::size_t      begin,
+  std::size_t      end,
+  build_scratch_t& scratch
+) {
+  const std::size_t num_bins      = build_params_.num_bins;
+  const std::size_t num_triangles = end - begin;
+
+  point_t<U> centers_min = centers_[triangle_ids_[begin]];
+  point_t<U> centers_max = centers_min;
+  for (std::size_t i = begin; i < end; ++i) {
+    const point_t<U>& center = centers_[triangle_ids_[i]];
+    centers_min = vec_ops::get_min_of_2_points(centers_min, center);
+    centers_max = vec_ops::get_max_of_2_points(centers_max, center);
   }
 
-  auto cmp_proj_pairs = [](const proj_pair_t& lhs, const proj_pair_t& rhs){
-    return utils::sign(lhs.first - rhs.first) < utils::signs_t::ZERO;
+  auto get_bin_ind = [num_bins](U coord, U min_coord, U extent) {
+    U pos = (coord - min_coord) / extent * static_cast<U>(num_bins);
+    if (pos < 0) {
+      return std::size_t{0};
+    }
+
+    return std::min(static_cast<std::size_t>(pos), num_bins - 1);
   };
-  const std::size_t mid_ind = indices.size() / 2;
-  std::nth_element(projection_pairs.begin(),
-                   projection_pairs.begin() + mid_ind,
-                   projection_pairs.end(),
-                   cmp_proj_pairs);
-  U partition_coord = projection_pairs[mid_ind].first;
-
-  lhs.clear();
-  rhs.clear();
-  for (auto& [proj_coord, ind] : projection_pairs) {
-    if (utils::sign(proj_coord - partition_coord) <= utils::signs_t::ZERO) {
-      lhs.emplace_back(ind);
-    } else {
-      rhs.emplace_back(ind);
+
+  // all costs are multiplied by box surface area, so flat boxes don't cause division by zero
+  const U box_area = box.get_surface_area();
+  U best_cost = std::numeric_limits<U>::max();
+  std::size_t   best_split_bin  = 0;
+  utils::axis_t best_axis       = utils::axis_t::X;
+  bool          is_split_found  = false;
+  bool          is_left_bigger  = true;
+
+  std::vector<SAH_bin_t>& bins        = scratch.bins;
+  std::vector<U>&         right_areas = scratch.right_areas;
+  std::vector<U>&         right_costs = scratch.right_costs;
+  bins.resize(num_bins);
+  right_areas.resize(num_bins);
+  right_costs.resize(num_bins);
+  for (auto axis : kAxes) {
+    U min_coord = centers_min.get_coord_by_axis_name(axis);
+    U extent    = centers_max.get_coord_by_axis_name(axis) - min_coord;
+    if (utils::sign(extent) == utils::signs_t::ZERO) {
+      continue;
     }
+
+    std::fill(bins.begin(), bins.end(), SAH_bin_t{});
+    for (std::size_t i = begin; i < end; ++i) {
+      std::size_t ind = triangle_ids_[i];
+      U coord = centers_[ind].get_coord_by_axis_name(axis);
+      SAH_bin_t& bin = bins[get_bin_ind(coord, min_coord, extent)];
+      if (bin.count == 0) {
+        bin.box = triangles_[ind].get_AABB();
+      } else {
+        bin.box.unite_with(triangles_[ind].get_AABB());
+      }
+      ++bin.count;
+    }
+
+    // right_costs[i] - cost of right part, made of bins [i, num_bins)
+    AABB_t<U>   accum_box   = {};
+    std::size_t accum_count = 0;
+    for (std::size_t i = num_bins - 1; i > 0; --i) {
+      if (bins[i].count != 0) {
+        if (accum_count == 0) {
+          accum_box = bins[i].box;
+        } else {
+          accum_box.unite_with(bins[i].box);
+        }
+        accum_count += bins[i].count;
+      }
+      right_areas[i] = accum_box.get_surface_area();
+      right_costs[i] = right_areas[i] * static_cast<U>(accum_count);
+    }
+
+    accum_box   = {};
+    accum_count = 0;
+    for (std::size_t split_bin = 1; split_bin < num_bins; ++split_bin) {
+      const SAH_bin_t& bin = bins[split_bin - 1];
+      if (bin.count != 0) {
+        if (accum_count == 0) {
+          accum_box = bin.box;
+        } else {
+          accum_box.unite_with(bin.box);
+        }
+        accum_count += bin.count;
+      }
+
+      if (accum_count == 0 || accum_count == num_triangles) {
+        continue;
+      }
+
+      U left_area = accum_box.get_surface_area();
+      U cost = left_area * static_cast<U>(accum_count) + right_costs[split_bin];
+      if (cost < best_cost) {
+        best_cost      = cost;
+        best_split_bin = split_bin;
+        best_axis      = axis;
+        is_split_found = true;
+        is_left_bigger = !(left_area < right_areas[split_bin]);
+      }
+    }
+  }
+
+  if (!is_split_found) {
+    // all centers coincide, there is no way to separate triangles
+    return begin;
   }
+
+  best_cost = build_params_.traversal_cost * box_area +
+              build_params_.intersection_cost * best_cost;
+  U leaf_cost = build_params_.intersection_cost * box_area *
+                static_cast<U>(num_triangles);
+  if (best_cost >= leaf_cost && num_triangles <= build_params_.max_leaf_size) {
+    return begin;
+  }
+
+  // queries stop at first found intersection and descend into left child first (near first
+  // ones do so for equally near children), so bigger child, which is more likely to contain
+  // intersection, goes to the left
+  U min_coord = centers_min.get_coord_by_axis_name(best_axis);
+  U extent    = centers_max.get_coord_by_axis_name(best_axis) - min_coord;
+  auto left_end = std::partition(
+    triangle_ids_.begin() + static_cast<std::ptrdiff_t>(begin),
+    triangle_ids_.begin() + static_cast<std::ptrdiff_t>(end),
+    [&](std::size_t ind) {
+      U coord = centers_[ind].get_coord_by_axis_name(best_axis);
+      bool is_in_lower_bins = get_bin_ind(coord, min_coord, extent) < best_split_bin;
+      return is_in_lower_bins == is_left_bigger;
+    }
+  );
+
+  return static_cast<std::size_t>(left_end - triangle_ids_.begin());
 }
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "parallel_for.hpp"
+#include "result_sink.hpp"
+
+// command line options of usecase targets
+struct cmd_args_t {
+  std::size_t num_threads = 1;
+  // empty means text from stdin
+  std::string input_path;
+  result_sink::format_t output_format = result_sink::format_t::TEXT;
+  // output every intersecting pair instead of intersecting triangles
+  bool        find_pairs    = false;
+  // 0 means no limit
+  std::size_t max_num_pairs = 0;
+  // output component id of every triangle instead of intersecting triangles
+  bool        find_components = false;
+  // narrow phase with exact predicates instead of epsilon ones
+  bool        exact_predicates = false;
+  // write counters of broad and narrow phase to stderr as JSON
+  bool        print_stats      = false;
+};
+
+namespace cmd_args {
+  const std::string kUsage =
+    "options:\n"
+    "  --threads N     number of threads for solving, 0 - all hardware threads (default 1)\n"
+    "  --input FILE    read triangles from FILE, text or binary triangles file (default stdin)\n"
+    "  --output FMT    format of found indices: text, binary (uint64 each) or bitmap (default text)\n"
+    "  --pairs         output every intersecting pair \"i j\", i < j, instead of triangles\n"
+    "  --max-pairs N   same as --pairs, but stop after N pairs, 0 - no limit\n"
+    "  --components    output id of cluster of intersecting triangles for every triangle,\n"
+    "                  id is the smallest index in cluster, statistics go to stderr\n"
+    "  --exact         exact intersection tests, no epsilon for touching and coplanar triangles\n"
+    "  --stats         write traversal and narrow phase counters to stderr as JSON,\n"
+    "                  they are collected only if built with -DCOLLECT_STATS=ON";
+
+  [[nodiscard]] inline std::size_t parse_size(std::string_view option, std::string_view value) {
+    std::size_t result = 0;
+    auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+    if (error != std::errc{} || end != value.data() + value.size()) {
+      throw std::invalid_argument(
+        "Error: option " + std::string(option) + " expects non negative integer, got \"" +
+        std::string(value) + "\"");
+    }
+
+    return result;
+  }
+
+  // throws std::invalid_argument on unknown or malformed options
+  [[nodiscard]] inline cmd_args_t parse(int argc, const char* const* argv) {
+    cmd_args_t args;
+    for (int i = 1; i < argc; ++i) {
+      std::string_view option = argv[i];
+      if (option == "--threads") {
+        if (i + 1 == argc) {
+          throw std::invalid_argument("Error: option --threads expects a value");
+        }
+        args.num_threads = parallel::get_num_threads(parse_size(option, argv[++i]));
+      } else if (option == "--input") {
+        if (i + 1 == argc) {
+          throw std::invalid_argument("Error: option --input expects a value");
+        }
+        args.input_path = argv[++i];
+      } else if (option == "--output") {
+        if (i + 1 == argc) {
+          throw std::invalid_argument("Error: option --output expects a value");
+        }
+        args.output_format = result_sink::parse_format(argv[++i]);
+      } else if (option == "--pairs") {
+        args.find_pairs = true;
+      } else if (option == "--components") {
+        args.find_components = true;
+      } else if (option == "--exact") {
+        args.exact_predicates = true;
+      } else if (option == "--stats") {
+        args.print_stats = true;
+      } else if (option == "--max-pairs") {
+        if (i + 1 == argc) {
+          throw std::invalid_argument("Error: option --max-pairs expects a value");
+        }
+        args.find_pairs    = true;
+        args.max_num_pairs = parse_size(option, argv[++i]);
+      } else {
+        throw std::invalid_argument("Error: unknown option \"" + std::string(option) + "\"");
+      }
+    }
+
+    if (args.find_pairs && args.find_components) {
+      throw std::invalid_argument("Error: options --pairs and --components can't be used together");
+    }
+    if ((args.find_pairs || args.find_components) &&
+        args.output_format == result_sink::format_t::BITMAP) {
+      throw std::invalid_argument("Error: only set of triangles can be written as bitmap");
+    }
+
+    return args;
+  }
+};
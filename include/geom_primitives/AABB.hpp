@@ -20,12 +20,12 @@ class AABB_t {
 
   [[nodiscard]] utils::axis_t get_longest_axis_ind() const;
 
+  [[nodiscard]] T get_surface_area() const;
+
   [[nodiscard]] T get_volume() const;
 
+  // empty box, i.e. AABB_t{}, if boxes don't overlap
   [[nodiscard]] AABB_t get_intersection(const AABB_t& other) const;
-  
- private:
-  [[nodiscard]] bool is_point_inside(const point_t<T>& point) const;
 
  private:
   point_t<T> corner_min_;
@@ -93,20 +93,20 @@ template<typename T>
   return utils::axis_t::Z;
 }
 
-// TODO: rename to surface area
 template <typename T>
-[[nodiscard]] T AABB_t<T>::get_volume() const {
+[[nodiscard]] T AABB_t<T>::get_surface_area() const {
   T len_x = corner_max_.x - corner_min_.x;
   T len_y = corner_max_.y - corner_min_.y;
   T len_z = corner_max_.z - corner_min_.z;
 
-  T volume = 2 * (len_x * len_y + len_x * len_z + len_y * len_z);
-  return volume;
+  T area = 2 * (len_x * len_y + len_x * len_z + len_y * len_z);
+  return area;
 }
 
 template <typename T>
-[[nodiscard]] bool AABB_t<T>::is_point_inside(const point_t<T>& point) const {
-  return does_inter({point, point});
+[[nodiscard]] T AABB_t<T>::get_volume() const {
+  point_t<T> sizes = corner_max_ - corner_min_;
+  return sizes.x * sizes.y * sizes.z;
 }
 
 template <typename T>
@@ -115,9 +115,8 @@ template <typename T>
     return {};
   }
 
-  if (is_point_inside(other.get_min_corner())) {
-    return {other.get_min_corner(), get_max_corner()};
-  } else {
-    return {get_min_corner(), other.get_max_corner()};
-  }
+  // boxes, that only touch within epsilon, give flat box, not inverted one
+  point_t<T> corner_min = vec_ops::get_max_of_2_points(corner_min_, other.corner_min_);
+  point_t<T> corner_max = vec_ops::get_min_of_2_points(corner_max_, other.corner_max_);
+  return {corner_min, vec_ops::get_max_of_2_points(corner_min, corner_max)};
 }
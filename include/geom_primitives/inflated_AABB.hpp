@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "AABB.hpp"
+
+// AABB_t, inflated by epsilon on every side once, when it's constructed.
+// Overlap test is then six plain comparisons, without epsilon and utils::sign.
+// Boxes, that overlap by AABB_t::does_inter, always overlap after inflation,
+// so it's safe to cull with them, they only may be a bit more permissive.
+template<typename T=double>
+class inflated_AABB_t {
+ public:
+  inflated_AABB_t() = default;
+  explicit inflated_AABB_t(const AABB_t<T>& box);
+
+  // box of other precision, rounded outward, so it still contains the source box
+  template<typename U>
+  explicit inflated_AABB_t(const inflated_AABB_t<U>& box);
+
+  [[nodiscard]] bool does_inter(const inflated_AABB_t& other) const;
+
+  // Bit 0 is set if box overlaps first, bit 1 - if it overlaps second.
+  // Both children of a node are tested by one call, when both are needed.
+  [[nodiscard]] std::uint32_t get_overlap_mask(
+    const inflated_AABB_t& first,
+    const inflated_AABB_t& second
+  ) const;
+
+  // Manhattan distance between centers of boxes, doubled,
+  // it's only for comparing, which of boxes is nearer to this one.
+  [[nodiscard]] T get_doubled_center_dist(const inflated_AABB_t& other) const;
+
+  [[nodiscard]] point_t<T> get_min_corner() const { return corner_min_; }
+  [[nodiscard]] point_t<T> get_max_corner() const { return corner_max_; }
+
+  [[nodiscard]] T get_surface_area() const;
+
+ private:
+  static constexpr T kInflation = utils::float_traits<T>::kEPS;
+
+  // value of T, that is not bigger than value and is at most two steps below it
+  template<typename U>
+  [[nodiscard]] static T round_down(U value);
+
+ private:
+  point_t<T> corner_min_;
+  point_t<T> corner_max_;
+};
+
+template<typename T>
+inflated_AABB_t<T>::inflated_AABB_t(const AABB_t<T>& box)
+  : corner_min_(box.get_min_corner() - point_t<T>{kInflation, kInflation, kInflation}),
+    corner_max_(box.get_max_corner() + point_t<T>{kInflation, kInflation, kInflation}) {}
+
+template<typename T>
+template<typename U>
+inflated_AABB_t<T>::inflated_AABB_t(const inflated_AABB_t<U>& box) {
+  point_t<U> min = box.get_min_corner();
+  point_t<U> max = box.get_max_corner();
+  corner_min_ = { round_down( min.x),  round_down( min.y),  round_down( min.z)};
+  corner_max_ = {-round_down(-max.x), -round_down(-max.y), -round_down(-max.z)};
+}
+
+template<typename T>
+template<typename U>
+[[nodiscard]] T inflated_AABB_t<T>::round_down(U value) {
+  if constexpr (sizeof(T) >= sizeof(U)) {
+    return static_cast<T>(value);
+  } else {
+    // Conversion rounds to nearest, so result is at most one step above the value.
+    // Step down by more than one ulp is branchless, unlike nextafter.
+    constexpr U kMax = static_cast<U>(std::numeric_limits<T>::max());
+    T result = static_cast<T>(std::clamp(value, -kMax, kMax));
+    return result - (std::fabs(result) * std::numeric_limits<T>::epsilon() +
+                     std::numeric_limits<T>::denorm_min());
+  }
+}
+
+template<typename T>
+[[nodiscard]] inline bool inflated_AABB_t<T>::does_inter(const inflated_AABB_t<T>& other) const {
+  // short-circuit is kept on purpose: most of the boxes are rejected by the first
+  // axes, and it measured faster than branchless & and than SSE2 compares
+  return (corner_min_.x <= other.corner_max_.x) && (other.corner_min_.x <= corner_max_.x) &&
+         (corner_min_.y <= other.corner_max_.y) && (other.corner_min_.y <= corner_max_.y) &&
+         (corner_min_.z <= other.corner_max_.z) && (other.corner_min_.z <= corner_max_.z);
+}
+
+template<typename T>
+[[nodiscard]] inline std::uint32_t inflated_AABB_t<T>::get_overlap_mask(
+  const inflated_AABB_t<T>& first,
+  const inflated_AABB_t<T>& second
+) const {
+  return static_cast<std::uint32_t>(does_inter(first)) |
+         static_cast<std::uint32_t>(does_inter(second)) << 1;
+}
+
+template<typename T>
+[[nodiscard]] inline T inflated_AABB_t<T>::get_doubled_center_dist(const inflated_AABB_t<T>& other) const {
+  point_t<T> diff = (corner_min_ + corner_max_) - (other.corner_min_ + other.corner_max_);
+  return std::abs(diff.x) + std::abs(diff.y) + std::abs(diff.z);
+}
+
+template<typename T>
+[[nodiscard]] T inflated_AABB_t<T>::get_surface_area() const {
+  return AABB_t<T>{corner_min_, corner_max_}.get_surface_area();
+}
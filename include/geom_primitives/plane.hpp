@@ -36,6 +36,15 @@ class plane_t {
     return plane;
   }
 
+  // norm must be non zero, no cross product is computed
+  static plane_t<T> construct_from_norm(const point_t<T>& base, const vector_t<T>& norm) {
+    plane_t<T> plane;
+    plane.base_ = base;
+    plane.norm_ = norm;
+    assert(plane.is_valid_plane());
+    return plane;
+  }
+
   vector_t<T> get_norm_vec() const { return norm_; }
 
   [[nodiscard]] bool is_point_on_plane(const point_t<T>& point) const;
@@ -0,0 +1,443 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+
+#include "point.hpp"
+#include "utils.hpp"
+
+// Orientation predicates, whose signs are exact for any float or double coordinates
+// (J. R. Shewchuk, "Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric Predicates").
+// Determinant is computed in doubles first and its sign is returned, if the value is bigger
+// than the worst rounding error. Only the rest is recomputed exactly in expansion arithmetic.
+// Overflow and underflow are not handled, as in the paper.
+namespace predicates {
+  // Expansion arithmetic drops only exact zeros, comparison with epsilon would lose
+  // exactness, so -Wfloat-equal is silenced for this one comparison.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+  [[nodiscard]] inline bool is_exact_zero(double value) {
+    return value == 0;
+  }
+#pragma GCC diagnostic pop
+
+  // number, that is exactly the sum of its components;
+  // components are nonzero, nonoverlapping and go in increasing magnitude order
+  template<std::size_t kCapacity>
+  struct expansion_t {
+    std::array<double, kCapacity> components = {};
+    std::size_t                   size       = 0;
+
+    void push(double component) {
+      if (!is_exact_zero(component)) {
+        components[size++] = component;
+      }
+    }
+  };
+
+  constexpr double kEpsilon = std::numeric_limits<double>::epsilon() / 2;
+  // error bounds of fast paths, from the paper
+  constexpr double kOrient2dBound = (3 + 16 * kEpsilon) * kEpsilon;
+  constexpr double kOrient3dBound = (7 + 56 * kEpsilon) * kEpsilon;
+
+  // a + b == x + err exactly
+  inline void two_sum(double a, double b, double& x, double& err) {
+    x = a + b;
+    double b_virtual = x - a;
+    double a_virtual = x - b_virtual;
+    err = (a - a_virtual) + (b - b_virtual);
+  }
+
+  // a - b == x + err exactly
+  inline void two_diff(double a, double b, double& x, double& err) {
+    x = a - b;
+    double b_virtual = a - x;
+    double a_virtual = x + b_virtual;
+    err = (a - a_virtual) + (b_virtual - b);
+  }
+
+  // a * b == x + err exactly, fma rounds only once
+  inline void two_product(double a, double b, double& x, double& err) {
+    x = a * b;
+    err = std::fma(a, b, -x);
+  }
+
+  // same as two_sum, if |a| >= |b| or a == 0
+  inline void fast_two_sum(double a, double b, double& x, double& err) {
+    x = a + b;
+    err = b - (x - a);
+  }
+
+  [[nodiscard]] inline expansion_t<2> diff(double a, double b) {
+    expansion_t<2> result;
+    double value = 0;
+    double err   = 0;
+    two_diff(a, b, value, err);
+    result.push(err);
+    result.push(value);
+    return result;
+  }
+
+  template<std::size_t kCapacity1, std::size_t kCapacity2>
+  [[nodiscard]] expansion_t<kCapacity1 + kCapacity2> sum(
+    const expansion_t<kCapacity1>& e,
+    const expansion_t<kCapacity2>& f
+  ) {
+    expansion_t<kCapacity1 + kCapacity2> result;
+    for (std::size_t i = 0; i < e.size; ++i) {
+      result.components[i] = e.components[i];
+    }
+    result.size = e.size;
+
+    // adds components one by one, GROW-EXPANSION with zero elimination
+    for (std::size_t i = 0; i < f.size; ++i) {
+      double q = f.components[i];
+      std::size_t size = 0;
+      for (std::size_t j = 0; j < result.size; ++j) {
+        double err = 0;
+        two_sum(q, result.components[j], q, err);
+        if (!is_exact_zero(err)) {
+          result.components[size++] = err;
+        }
+      }
+      result.size = size;
+      result.push(q);
+    }
+
+    return result;
+  }
+
+  template<std::size_t kCapacity>
+  [[nodiscard]] expansion_t<kCapacity> negate(expansion_t<kCapacity> e) {
+    for (std::size_t i = 0; i < e.size; ++i) {
+      e.components[i] = -e.components[i];
+    }
+    return e;
+  }
+
+  // multiplies expansion by number, SCALE-EXPANSION with zero elimination
+  template<std::size_t kCapacity>
+  [[nodiscard]] expansion_t<2 * kCapacity> scale(const expansion_t<kCapacity>& e, double b) {
+    expansion_t<2 * kCapacity> result;
+    if (e.size == 0) {
+      return result;
+    }
+
+    double q   = 0;
+    double err = 0;
+    two_product(e.components[0], b, q, err);
+    result.push(err);
+    for (std::size_t i = 1; i < e.size; ++i) {
+      double product     = 0;
+      double product_err = 0;
+      double partial     = 0;
+      two_product(e.components[i], b, product, product_err);
+      two_sum(q, product_err, partial, err);
+      result.push(err);
+      fast_two_sum(product, partial, q, err);
+      result.push(err);
+    }
+    result.push(q);
+    return result;
+  }
+
+  template<std::size_t kCapacity1, std::size_t kCapacity2>
+  [[nodiscard]] expansion_t<2 * kCapacity1 * kCapacity2> product(
+    const expansion_t<kCapacity1>& e,
+    const expansion_t<kCapacity2>& f
+  ) {
+    expansion_t<2 * kCapacity1 * kCapacity2> result;
+    for (std::size_t i = 0; i < f.size; ++i) {
+      auto scaled = scale(e, f.components[i]);
+      auto total  = sum(result, scaled);
+      for (std::size_t j = 0; j < total.size; ++j) {
+        result.components[j] = total.components[j];
+      }
+      result.size = total.size;
+    }
+    return result;
+  }
+
+  // the biggest component has the sign of the whole sum
+  template<std::size_t kCapacity>
+  [[nodiscard]] utils::signs_t get_sign(const expansion_t<kCapacity>& e) {
+    if (e.size == 0) {
+      return utils::signs_t::ZERO;
+    }
+    return e.components[e.size - 1] > 0 ? utils::signs_t::POS : utils::signs_t::NEG;
+  }
+
+  [[nodiscard]] inline utils::signs_t get_sign(double value) {
+    if (is_exact_zero(value)) {
+      return utils::signs_t::ZERO;
+    }
+    return value > 0 ? utils::signs_t::POS : utils::signs_t::NEG;
+  }
+
+  [[nodiscard]] inline utils::signs_t orient2d_exact(
+    double ax, double ay, double bx, double by, double cx, double cy
+  ) {
+    auto left  = product(diff(bx, ax), diff(cy, ay));
+    auto right = product(diff(by, ay), diff(cx, ax));
+    return get_sign(sum(left, negate(right)));
+  }
+
+  // x * y - z * w
+  [[nodiscard]] inline expansion_t<16> get_minor(
+    const expansion_t<2>& x, const expansion_t<2>& y,
+    const expansion_t<2>& z, const expansion_t<2>& w
+  ) {
+    return sum(product(x, y), negate(product(z, w)));
+  }
+
+  [[nodiscard]] inline utils::signs_t orient3d_exact(
+    const point_t<double>& a, const point_t<double>& b,
+    const point_t<double>& c, const point_t<double>& d
+  ) {
+    std::array<expansion_t<2>, 3> u = {diff(b.x, a.x), diff(b.y, a.y), diff(b.z, a.z)};
+    std::array<expansion_t<2>, 3> v = {diff(c.x, a.x), diff(c.y, a.y), diff(c.z, a.z)};
+    std::array<expansion_t<2>, 3> w = {diff(d.x, a.x), diff(d.y, a.y), diff(d.z, a.z)};
+
+    auto x_term = product(u[0], get_minor(v[1], w[2], v[2], w[1]));
+    auto y_term = product(u[1], get_minor(v[2], w[0], v[0], w[2]));
+    auto z_term = product(u[2], get_minor(v[0], w[1], v[1], w[0]));
+    return get_sign(sum(sum(x_term, y_term), z_term));
+  }
+
+  template<typename T>
+  [[nodiscard]] point_t<double> to_double(const point_t<T>& point) {
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>,
+                  "exact predicates support only float and double coordinates");
+    return {static_cast<double>(point.x), static_cast<double>(point.y), static_cast<double>(point.z)};
+  }
+
+  using point2_t = std::array<double, 2>;
+
+  // sign of cross(b - a, c - a): POS if a, b, c go counterclockwise
+  [[nodiscard]] inline utils::signs_t orient2d(const point2_t& a, const point2_t& b, const point2_t& c) {
+    double left  = (b[0] - a[0]) * (c[1] - a[1]);
+    double right = (b[1] - a[1]) * (c[0] - a[0]);
+    double det   = left - right;
+    double bound = kOrient2dBound * (std::fabs(left) + std::fabs(right));
+    if (det > bound || -det > bound) {
+      return get_sign(det);
+    }
+
+    return orient2d_exact(a[0], a[1], b[0], b[1], c[0], c[1]);
+  }
+
+  // sign of dot(d - a, cross(b - a, c - a)): POS if d is on the side, where normal of abc points
+  template<typename T>
+  [[nodiscard]] utils::signs_t orient3d(
+    const point_t<T>& a_in, const point_t<T>& b_in, const point_t<T>& c_in, const point_t<T>& d_in
+  ) {
+    point_t<double> a = to_double(a_in);
+    point_t<double> b = to_double(b_in);
+    point_t<double> c = to_double(c_in);
+    point_t<double> d = to_double(d_in);
+
+    vector_t<double> u = b - a;
+    vector_t<double> v = c - a;
+    vector_t<double> w = d - a;
+    double minor_x1 = v.y * w.z, minor_x2 = v.z * w.y;
+    double minor_y1 = v.z * w.x, minor_y2 = v.x * w.z;
+    double minor_z1 = v.x * w.y, minor_z2 = v.y * w.x;
+    double det = u.x * (minor_x1 - minor_x2) +
+                 u.y * (minor_y1 - minor_y2) +
+                 u.z * (minor_z1 - minor_z2);
+    double permanent = std::fabs(u.x) * (std::fabs(minor_x1) + std::fabs(minor_x2)) +
+                       std::fabs(u.y) * (std::fabs(minor_y1) + std::fabs(minor_y2)) +
+                       std::fabs(u.z) * (std::fabs(minor_z1) + std::fabs(minor_z2));
+    double bound = kOrient3dBound * permanent;
+    if (det > bound || -det > bound) {
+      return get_sign(det);
+    }
+
+    return orient3d_exact(a, b, c, d);
+  }
+
+  // point without coordinate along dropped axis
+  template<typename T>
+  [[nodiscard]] point2_t project(const point_t<T>& point, utils::axis_t dropped) {
+    point_t<double> p = to_double(point);
+    switch (dropped) {
+      case utils::axis_t::X: return {p.y, p.z};
+      case utils::axis_t::Y: return {p.x, p.z};
+      case utils::axis_t::Z: return {p.x, p.y};
+      default:
+        assert(false && "unknown axis");
+        return {p.x, p.y};
+    }
+  }
+
+  // a, b, c lie on one line (or coincide)
+  template<typename T>
+  [[nodiscard]] bool is_collinear(const point_t<T>& a, const point_t<T>& b, const point_t<T>& c) {
+    for (utils::axis_t axis : {utils::axis_t::X, utils::axis_t::Y, utils::axis_t::Z}) {
+      if (orient2d(project(a, axis), project(b, axis), project(c, axis)) != utils::signs_t::ZERO) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // axis, dropping which keeps non collinear a, b, c a proper triangle
+  template<typename T>
+  [[nodiscard]] utils::axis_t get_projection_axis(
+    const point_t<T>& a, const point_t<T>& b, const point_t<T>& c
+  ) {
+    for (utils::axis_t axis : {utils::axis_t::X, utils::axis_t::Y}) {
+      if (orient2d(project(a, axis), project(b, axis), project(c, axis)) != utils::signs_t::ZERO) {
+        return axis;
+      }
+    }
+    return utils::axis_t::Z;
+  }
+
+  // point lies in the box of segment pq, it is on the line of pq already
+  [[nodiscard]] inline bool is_in_segment_box(const point2_t& p, const point2_t& q, const point2_t& point) {
+    for (std::size_t i = 0; i < 2; ++i) {
+      if (point[i] < std::fmin(p[i], q[i]) || point[i] > std::fmax(p[i], q[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // closed segments, any of them may be a point
+  [[nodiscard]] inline bool do_segments_intersect(
+    const point2_t& p1, const point2_t& q1, const point2_t& p2, const point2_t& q2
+  ) {
+    using utils::signs_t;
+    signs_t side_p2 = orient2d(p1, q1, p2);
+    signs_t side_q2 = orient2d(p1, q1, q2);
+    signs_t side_p1 = orient2d(p2, q2, p1);
+    signs_t side_q1 = orient2d(p2, q2, q1);
+    bool is_proper_cross = side_p2 != signs_t::ZERO && side_q2 != signs_t::ZERO && side_p2 != side_q2 &&
+                           side_p1 != signs_t::ZERO && side_q1 != signs_t::ZERO && side_p1 != side_q1;
+    if (is_proper_cross) {
+      return true;
+    }
+
+    return (side_p2 == signs_t::ZERO && is_in_segment_box(p1, q1, p2)) ||
+           (side_q2 == signs_t::ZERO && is_in_segment_box(p1, q1, q2)) ||
+           (side_p1 == signs_t::ZERO && is_in_segment_box(p2, q2, p1)) ||
+           (side_q1 == signs_t::ZERO && is_in_segment_box(p2, q2, q1));
+  }
+
+  // closed triangle abc, it's not degenerate
+  [[nodiscard]] inline bool is_point_inside_triangle(
+    const point2_t& point, const point2_t& a, const point2_t& b, const point2_t& c
+  ) {
+    using utils::signs_t;
+    signs_t side_ab = orient2d(a, b, point);
+    signs_t side_bc = orient2d(b, c, point);
+    signs_t side_ca = orient2d(c, a, point);
+    bool has_neg = side_ab == signs_t::NEG || side_bc == signs_t::NEG || side_ca == signs_t::NEG;
+    bool has_pos = side_ab == signs_t::POS || side_bc == signs_t::POS || side_ca == signs_t::POS;
+    return !(has_neg && has_pos);
+  }
+
+  [[nodiscard]] inline bool does_segment_intersect_triangle(
+    const point2_t& p, const point2_t& q,
+    const point2_t& a, const point2_t& b, const point2_t& c
+  ) {
+    return is_point_inside_triangle(p, a, b, c) ||
+           do_segments_intersect(p, q, a, b) ||
+           do_segments_intersect(p, q, b, c) ||
+           do_segments_intersect(p, q, c, a);
+  }
+
+  // closed segments in space, any of them may be a point
+  template<typename T>
+  [[nodiscard]] bool do_segments_intersect(
+    const point_t<T>& p1, const point_t<T>& q1, const point_t<T>& p2, const point_t<T>& q2
+  ) {
+    if (orient3d(p1, q1, p2, q2) != utils::signs_t::ZERO) {
+      return false;
+    }
+
+    // segments in one plane intersect iff all their projections do
+    for (utils::axis_t axis : {utils::axis_t::X, utils::axis_t::Y, utils::axis_t::Z}) {
+      if (!do_segments_intersect(project(p1, axis), project(q1, axis),
+                                 project(p2, axis), project(q2, axis))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // closed segment pq, that may be a point, against not degenerate triangle abc
+  template<typename T>
+  [[nodiscard]] bool does_segment_intersect_triangle(
+    const point_t<T>& p, const point_t<T>& q,
+    const point_t<T>& a, const point_t<T>& b, const point_t<T>& c
+  ) {
+    using utils::signs_t;
+    signs_t side_p = orient3d(a, b, c, p);
+    signs_t side_q = orient3d(a, b, c, q);
+    if (side_p != signs_t::ZERO && side_p == side_q) {
+      return false;
+    }
+
+    if (side_p == signs_t::ZERO && side_q == signs_t::ZERO) {
+      utils::axis_t axis = get_projection_axis(a, b, c);
+      return does_segment_intersect_triangle(project(p, axis), project(q, axis),
+                                             project(a, axis), project(b, axis), project(c, axis));
+    }
+
+    // segment meets the plane at one point, it's inside if line pq passes by all edges the same way
+    signs_t side_ab = orient3d(p, q, a, b);
+    signs_t side_bc = orient3d(p, q, b, c);
+    signs_t side_ca = orient3d(p, q, c, a);
+    bool has_neg = side_ab == signs_t::NEG || side_bc == signs_t::NEG || side_ca == signs_t::NEG;
+    bool has_pos = side_ab == signs_t::POS || side_bc == signs_t::POS || side_ca == signs_t::POS;
+    return !(has_neg && has_pos);
+  }
+
+  // Policies of triangle_t::does_intersect.
+  // epsilon_predicates_t treats values within utils::sign's kEPS as zero,
+  // exact_predicates_t gives exact answer for input coordinates.
+  struct epsilon_predicates_t {
+    static constexpr bool kIsExact = false;
+
+    template<typename T>
+    [[nodiscard]] static utils::signs_t orient3d(
+      const point_t<T>& a, const point_t<T>& b, const point_t<T>& c, const point_t<T>& d
+    ) {
+      return utils::sign(vec_ops::dot(d - a, vec_ops::cross(b - a, c - a)));
+    }
+
+    // norm is cross(b - a, c - a)
+    template<typename T>
+    [[nodiscard]] static utils::signs_t plane_side(
+      const point_t<T>& a, const point_t<T>&, const point_t<T>&,
+      const vector_t<T>& norm, const point_t<T>& point
+    ) {
+      return utils::sign(vec_ops::dot(point - a, norm));
+    }
+  };
+
+  struct exact_predicates_t {
+    static constexpr bool kIsExact = true;
+
+    template<typename T>
+    [[nodiscard]] static utils::signs_t orient3d(
+      const point_t<T>& a, const point_t<T>& b, const point_t<T>& c, const point_t<T>& d
+    ) {
+      return predicates::orient3d(a, b, c, d);
+    }
+
+    template<typename T>
+    [[nodiscard]] static utils::signs_t plane_side(
+      const point_t<T>& a, const point_t<T>& b, const point_t<T>& c,
+      const vector_t<T>&, const point_t<T>& point
+    ) {
+      return predicates::orient3d(a, b, c, point);
+    }
+  };
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "stats.hpp"
+#include "triangle.hpp"
+#include "triangle_with_box.hpp"
+
+// Triangle with box, that also keeps its props (normal, degeneracy class and so on),
+// so pair tests don't recompute them. Gives exactly the same answers as triangle_t.
+template<typename T>
+class prepared_triangle_t : public triangle_with_box_t<T> {
+ public:
+  prepared_triangle_t(const point_t<T>& a, const point_t<T>& b, const point_t<T>& c)
+    : prepared_triangle_t(triangle_t<T>{a, b, c}) {}
+
+  prepared_triangle_t(const triangle_t<T>& triangle)
+    : triangle_with_box_t<T>(triangle), props_(triangle.get_props()) {}
+
+  // box must be exactly AABB_t of triangle, e.g. precomputed one
+  prepared_triangle_t(const triangle_t<T>& triangle, const AABB_t<T>& box)
+    : triangle_with_box_t<T>(triangle, box), props_(triangle.get_props()) {}
+
+  [[nodiscard]] const triangle_props_t<T>& get_props() const {
+    return props_;
+  }
+
+  [[nodiscard]] bool does_intersect(
+    const prepared_triangle_t& other,
+    triangle_inters_kernel_t   kernel = triangle_t<T>::kDefaultInterKernel
+  ) const {
+    // every solution tests pairs through here, so narrow phase is counted once for all of them
+    return stats::count_triangle_test(
+      this->get_triangle().does_intersect(props_, other.get_triangle(), other.props_, kernel));
+  }
+
+ private:
+  triangle_props_t<T> props_;
+};
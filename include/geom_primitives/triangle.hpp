@@ -1,12 +1,45 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
 #include <iostream>
 #include <string_view>
+#include <tuple>
 #include <vector>
 
 #include "plane.hpp"
 #include "point.hpp"
+#include "predicates.hpp"
+
+enum class degeneracy_t {
+  NONE,    // proper triangle
+  SEGMENT, // all points lie on one line
+  POINT,   // all points coincide
+};
+
+// Everything intersection test needs to know about one triangle, that does not depend on the other one.
+// triangle_t computes it on each test, prepared_triangle_t computes it once.
+template<typename T>
+struct triangle_props_t {
+  vector_t<T>  norm       = {}; // cross(b - a, c - a), plane base is a
+  degeneracy_t degeneracy = degeneracy_t::NONE;
+  // for degenerate triangle: indices of points, that form segment covering the triangle
+  std::uint8_t deg_segm_start  = 0;
+  std::uint8_t deg_segm_finish = 0;
+
+  [[nodiscard]] bool is_degenerate() const { return degeneracy != degeneracy_t::NONE; }
+};
+
+enum class triangle_inters_kernel_t {
+  // every edge of one triangle against the other triangle, both ways
+  EDGES,
+  // rejection by signs of vertices relative to planes, then orientation tests
+  // (Guigue-Devillers), coplanar triangles are checked edge by edge
+  PLANE_SIDES,
+  // PLANE_SIDES with exact predicates, no epsilon
+  EXACT
+};
 
 template<typename T>
 class triangle_t {
@@ -16,7 +49,26 @@ class triangle_t {
   triangle_t(const point_t<T>& a, const point_t<T>& b, const point_t<T>& c)
     : a_(a), b_(b), c_(c) {}
 
-  [[nodiscard]] bool does_intersect(const triangle_t& other) const;
+  static constexpr triangle_inters_kernel_t kDefaultInterKernel = triangle_inters_kernel_t::PLANE_SIDES;
+
+  // predicates_t is predicates::epsilon_predicates_t or predicates::exact_predicates_t,
+  // with exact ones kernel is ignored, it's always EXACT
+  template<typename predicates_t = predicates::epsilon_predicates_t>
+  [[nodiscard]] bool does_intersect(
+    const triangle_t&        other,
+    triangle_inters_kernel_t kernel = kDefaultInterKernel
+  ) const;
+
+  // same as above, but props of both triangles are already known
+  template<typename predicates_t = predicates::epsilon_predicates_t>
+  [[nodiscard]] bool does_intersect(
+    const triangle_props_t<T>& props,
+    const triangle_t&          other,
+    const triangle_props_t<T>& other_props,
+    triangle_inters_kernel_t   kernel = kDefaultInterKernel
+  ) const;
+
+  [[nodiscard]] triangle_props_t<T> get_props() const;
 
   [[nodiscard]] std::array<point_t<T>, 3> get_points() const;
 
@@ -24,25 +76,73 @@ class triangle_t {
 
   [[nodiscard]] bool is_intersected_by_segm(const segment_t<T>& segm) const;
 
- private:
-  static constexpr std::string_view kPlaneCtorError =
-    "Error: plane_t can not be constructed from given points, plane is degenerate";
-
  private:
   [[nodiscard]] std::array<segment_t<T>, 3> get_segments() const;
 
-  [[nodiscard]] plane_t<T> get_plane() const;
+  [[nodiscard]] const point_t<T>& get_point(std::uint8_t ind) const;
 
-  [[nodiscard]] bool is_triangle_degenerate() const;
+  [[nodiscard]] plane_t<T> get_plane(const triangle_props_t<T>& props) const;
 
-  [[nodiscard]] segment_t<T> get_deg_triang_case_segm() const;
+  [[nodiscard]] segment_t<T> get_deg_triang_case_segm(const triangle_props_t<T>& props) const;
 
   // return 1, if B is A, rotated counterclockwise
   // return -1 if rotation is clockwise, 0 if they are collinear
-  [[nodiscard]] utils::signs_t rotation_sign(
-    const point_t<T>& p, const point_t<T>& a, const point_t<T>& b) const;
-
-  [[nodiscard]] bool does_intersect_helper(const triangle_t& other) const;
+  [[nodiscard]] static utils::signs_t rotation_sign(
+    const vector_t<T>& norm, const point_t<T>& p, const point_t<T>& a, const point_t<T>& b);
+
+  [[nodiscard]] bool is_point_inside_triang(
+    const triangle_props_t<T>& props, const point_t<T>& point) const;
+
+  [[nodiscard]] bool is_intersected_by_segm(
+    const triangle_props_t<T>& props, const segment_t<T>& segm) const;
+
+  [[nodiscard]] bool does_intersect_helper(
+    const triangle_props_t<T>& props, const triangle_t& other) const;
+
+  [[nodiscard]] bool does_intersect_by_edges(
+    const triangle_props_t<T>& props,
+    const triangle_t&          other,
+    const triangle_props_t<T>& other_props
+  ) const;
+
+  template<typename predicates_t>
+  [[nodiscard]] bool does_intersect_by_plane_sides(
+    const triangle_props_t<T>& props,
+    const triangle_t&          other,
+    const triangle_props_t<T>& other_props
+  ) const;
+
+  // both triangles are non degenerate and lie in one plane
+  [[nodiscard]] bool does_intersect_coplanar(
+    const triangle_props_t<T>& props,
+    const triangle_t&          other,
+    const triangle_props_t<T>& other_props
+  ) const;
+
+  // exact versions of the cases, that epsilon version checks edge by edge
+  [[nodiscard]] bool does_intersect_coplanar_exactly(const triangle_t& other) const;
+
+  [[nodiscard]] bool does_intersect_degenerate_exactly(
+    const triangle_t& other, bool is_degenerate, bool is_other_degenerate) const;
+
+  // two farthest points of degenerate triangle
+  [[nodiscard]] std::array<point_t<T>, 2> get_extreme_points() const;
+
+  // p1 is alone on its side of the second triangle's plane,
+  // second triangle is oriented so that p1 is above it
+  template<typename predicates_t>
+  [[nodiscard]] static bool does_intersect_oriented(
+    const point_t<T>& p1, const point_t<T>& q1, const point_t<T>& r1,
+    const point_t<T>& p2, const point_t<T>& q2, const point_t<T>& r2,
+    utils::signs_t    side_p2, utils::signs_t side_q2, utils::signs_t side_r2
+  );
+
+  // checks that segments, cut from both triangles by the line of planes intersection, overlap
+  template<typename predicates_t>
+  [[nodiscard]] static bool check_min_max(
+    const point_t<T>& p1, const point_t<T>& q1, const point_t<T>& r1,
+    const point_t<T>& p2, const point_t<T>& q2, const point_t<T>& r2
+  );
 
  private:
   point_t<T> a_;
@@ -60,56 +160,101 @@ template<typename U>
 }
 
 template <typename U>
-[[nodiscard]] bool triangle_t<U>::is_triangle_degenerate() const {
-  return !plane_t<U>::is_valid_plane(a_, b_, c_);
+[[nodiscard]] inline const point_t<U>& triangle_t<U>::get_point(std::uint8_t ind) const {
+  assert(ind < 3);
+  switch (ind) {
+    case 0:  return a_;
+    case 1:  return b_;
+    default: return c_;
+  }
 }
 
 template <typename U>
-[[nodiscard]] plane_t<U> triangle_t<U>::get_plane() const {
-  assert(!is_triangle_degenerate());
+[[nodiscard]] triangle_props_t<U> triangle_t<U>::get_props() const {
+  triangle_props_t<U> props;
+  props.norm = vec_ops::cross(b_ - a_, c_ - a_);
+  if (!props.norm.is_zero()) {
+    return props;
+  }
 
-  try {
-    return {a_, b_, c_};
-  } catch(const std::invalid_argument&) {
-    assert(false && static_cast<const char*>(kPlaneCtorError.data()));
+  props.degeneracy = degeneracy_t::SEGMENT;
+  if (a_ == b_) {
+    props.deg_segm_start  = 0;
+    props.deg_segm_finish = 2;
+    if (a_ == c_) {
+      props.degeneracy = degeneracy_t::POINT;
+    }
+  } else if (a_ == c_) {
+    props.deg_segm_start  = 1;
+    props.deg_segm_finish = 2;
+  } else {
+    // two farthest points, the third one lies between them
+    U len_ab = (b_ - a_).get_len_sq();
+    U len_bc = (c_ - b_).get_len_sq();
+    U len_ca = (a_ - c_).get_len_sq();
+    if (len_ab >= len_bc && len_ab >= len_ca) {
+      props.deg_segm_start  = 0;
+      props.deg_segm_finish = 1;
+    } else if (len_bc >= len_ca) {
+      props.deg_segm_start  = 1;
+      props.deg_segm_finish = 2;
+    } else {
+      props.deg_segm_start  = 2;
+      props.deg_segm_finish = 0;
+    }
   }
+
+  return props;
 }
 
 template <typename U>
-[[nodiscard]] segment_t<U> triangle_t<U>::get_deg_triang_case_segm() const {
-  assert(is_triangle_degenerate());
+[[nodiscard]] plane_t<U> triangle_t<U>::get_plane(const triangle_props_t<U>& props) const {
+  assert(!props.is_degenerate());
+  return plane_t<U>::construct_from_norm(a_, props.norm);
+}
 
-       if (a_ == b_) return {a_, c_};
-  else if (a_ == c_) return {b_, c_};
-  else               return {a_, b_};
+template <typename U>
+[[nodiscard]] segment_t<U> triangle_t<U>::get_deg_triang_case_segm(
+  const triangle_props_t<U>& props
+) const {
+  assert(props.is_degenerate());
+  return {get_point(props.deg_segm_start), get_point(props.deg_segm_finish)};
 }
 
 // return 1, if PB is PA, rotated counterclockwise
 // return -1 if rotation is clockwise, 0 if they are collinear
 template<typename U>
 [[nodiscard]] inline utils::signs_t triangle_t<U>::rotation_sign(
-  const point_t<U>& p,
-  const point_t<U>& a,
-  const point_t<U>& b
-) const {
-  plane_t plane = get_plane();
-  return utils::sign(vec_ops::dot(vec_ops::cross(a - p, b - p), plane.get_norm_vec()));
+  const vector_t<U>& norm,
+  const point_t<U>&  p,
+  const point_t<U>&  a,
+  const point_t<U>&  b
+) {
+  return utils::sign(vec_ops::dot(vec_ops::cross(a - p, b - p), norm));
 }
 
 template<typename U>
 inline bool triangle_t<U>::is_point_inside_triang(const point_t<U>& point) const {
-  if (is_triangle_degenerate()) {
-    return get_deg_triang_case_segm().does_contain_point(point);
+  return is_point_inside_triang(get_props(), point);
+}
+
+template<typename U>
+inline bool triangle_t<U>::is_point_inside_triang(
+  const triangle_props_t<U>& props,
+  const point_t<U>&          point
+) const {
+  if (props.is_degenerate()) {
+    return get_deg_triang_case_segm(props).does_contain_point(point);
   }
 
   // additional check, even though we call it only from method where point is already on the plane
-  if (!get_plane().is_point_on_plane(point)) {
+  if (!get_plane(props).is_point_on_plane(point)) {
     return false;
   }
 
-  utils::signs_t sign1 = rotation_sign(point, a_, b_);
-  utils::signs_t sign2 = rotation_sign(point, b_, c_);
-  utils::signs_t sign3 = rotation_sign(point, c_, a_);
+  utils::signs_t sign1 = rotation_sign(props.norm, point, a_, b_);
+  utils::signs_t sign2 = rotation_sign(props.norm, point, b_, c_);
+  utils::signs_t sign3 = rotation_sign(props.norm, point, c_, a_);
 
   bool all_non_neg = sign1 >= utils::signs_t::ZERO &&
                      sign2 >= utils::signs_t::ZERO &&
@@ -122,11 +267,19 @@ inline bool triangle_t<U>::is_point_inside_triang(const point_t<U>& point) const
 
 template<typename U>
 inline bool triangle_t<U>::is_intersected_by_segm(const segment_t<U>& segm) const {
-  if (is_triangle_degenerate()) {
-    return get_deg_triang_case_segm().does_inter(segm);
+  return is_intersected_by_segm(get_props(), segm);
+}
+
+template<typename U>
+inline bool triangle_t<U>::is_intersected_by_segm(
+  const triangle_props_t<U>& props,
+  const segment_t<U>&        segm
+) const {
+  if (props.is_degenerate()) {
+    return get_deg_triang_case_segm(props).does_inter(segm);
   }
 
-  plane_t plane = get_plane();
+  plane_t plane = get_plane(props);
   if (plane.is_segment_on_plane(segm)) {
     std::array<segment_t<U>, 3> triang_segms = get_segments();
     for (const auto& triang_segm : triang_segms) {
@@ -135,8 +288,8 @@ inline bool triangle_t<U>::is_intersected_by_segm(const segment_t<U>& segm) cons
       }
     }
 
-    return is_point_inside_triang(segm.get_start()) ||
-           is_point_inside_triang(segm.get_finish());
+    return is_point_inside_triang(props, segm.get_start()) ||
+           is_point_inside_triang(props, segm.get_finish());
   }
 
   auto [inter, is_inter] = plane.intersect_by_segm(segm);
@@ -144,14 +297,17 @@ inline bool triangle_t<U>::is_intersected_by_segm(const segment_t<U>& segm) cons
     return false;
   }
 
-  return is_point_inside_triang(inter);
+  return is_point_inside_triang(props, inter);
 }
 
 template<typename U>
-inline bool triangle_t<U>::does_intersect_helper(const triangle_t<U>& other) const {
+inline bool triangle_t<U>::does_intersect_helper(
+  const triangle_props_t<U>& props,
+  const triangle_t<U>&       other
+) const {
   std::array<segment_t<U>, 3> segms = other.get_segments();
   for (const auto& segm : segms) {
-    if (is_intersected_by_segm(segm)) {
+    if (is_intersected_by_segm(props, segm)) {
       return true;
     }
   }
@@ -160,9 +316,269 @@ inline bool triangle_t<U>::does_intersect_helper(const triangle_t<U>& other) con
 }
 
 template<typename U>
-inline bool triangle_t<U>::does_intersect(const triangle_t<U>& other) const {
-  return does_intersect_helper(other) ||
-   other.does_intersect_helper(*this);
+inline bool triangle_t<U>::does_intersect_by_edges(
+  const triangle_props_t<U>& props,
+  const triangle_t<U>&       other,
+  const triangle_props_t<U>& other_props
+) const {
+  return       does_intersect_helper(props,       other) ||
+         other.does_intersect_helper(other_props, *this);
+}
+
+template<typename U>
+inline bool triangle_t<U>::does_intersect_coplanar(
+  const triangle_props_t<U>& props,
+  const triangle_t<U>&       other,
+  const triangle_props_t<U>& other_props
+) const {
+  std::array<segment_t<U>, 3> segms       = get_segments();
+  std::array<segment_t<U>, 3> other_segms = other.get_segments();
+  for (const auto& segm : segms) {
+    for (const auto& other_segm : other_segms) {
+      if (segm.does_inter(other_segm)) {
+        return true;
+      }
+    }
+  }
+
+  // edges don't cross, so triangles intersect only if one contains the other
+  return       is_point_inside_triang(props,       other.a_) ||
+         other.is_point_inside_triang(other_props, a_);
+}
+
+template<typename U>
+inline bool triangle_t<U>::does_intersect_coplanar_exactly(const triangle_t<U>& other) const {
+  utils::axis_t axis = predicates::get_projection_axis(a_, b_, c_);
+  std::array<predicates::point2_t, 3> points = {
+    predicates::project(a_, axis), predicates::project(b_, axis), predicates::project(c_, axis)
+  };
+  std::array<predicates::point2_t, 3> other_points = {
+    predicates::project(other.a_, axis), predicates::project(other.b_, axis), predicates::project(other.c_, axis)
+  };
+
+  for (std::size_t i = 0; i < 3; ++i) {
+    for (std::size_t j = 0; j < 3; ++j) {
+      if (predicates::do_segments_intersect(points[i],       points[(i + 1) % 3],
+                                            other_points[j], other_points[(j + 1) % 3])) {
+        return true;
+      }
+    }
+  }
+
+  return predicates::is_point_inside_triangle(other_points[0], points[0], points[1], points[2]) ||
+         predicates::is_point_inside_triangle(points[0], other_points[0], other_points[1], other_points[2]);
+}
+
+template<typename U>
+inline std::array<point_t<U>, 2> triangle_t<U>::get_extreme_points() const {
+  // points lie on one line, lexicographic order is the order along it
+  auto is_less = [](const point_t<U>& lhs, const point_t<U>& rhs) {
+    return std::tie(lhs.x, lhs.y, lhs.z) < std::tie(rhs.x, rhs.y, rhs.z);
+  };
+
+  std::array<point_t<U>, 3> points = {a_, b_, c_};
+  auto [min, max] = std::minmax_element(points.begin(), points.end(), is_less);
+  return {*min, *max};
+}
+
+template<typename U>
+inline bool triangle_t<U>::does_intersect_degenerate_exactly(
+  const triangle_t<U>& other,
+  bool                 is_degenerate,
+  bool                 is_other_degenerate
+) const {
+  if (is_degenerate && is_other_degenerate) {
+    auto [p1, q1] = get_extreme_points();
+    auto [p2, q2] = other.get_extreme_points();
+    return predicates::do_segments_intersect(p1, q1, p2, q2);
+  }
+
+  const triangle_t<U>& segment_triangle = is_degenerate ? *this : other;
+  const triangle_t<U>& proper_triangle  = is_degenerate ? other : *this;
+  auto [p, q] = segment_triangle.get_extreme_points();
+  return predicates::does_segment_intersect_triangle(
+    p, q, proper_triangle.a_, proper_triangle.b_, proper_triangle.c_);
+}
+
+template<typename U>
+template<typename predicates_t>
+inline bool triangle_t<U>::check_min_max(
+  const point_t<U>& p1, const point_t<U>& q1, const point_t<U>& r1,
+  const point_t<U>& p2, const point_t<U>& q2, const point_t<U>& r2
+) {
+  if (predicates_t::orient3d(q1, p2, p1, q2) == utils::signs_t::POS) {
+    return false;
+  }
+
+  return predicates_t::orient3d(p1, p2, r1, r2) != utils::signs_t::POS;
+}
+
+template<typename U>
+template<typename predicates_t>
+inline bool triangle_t<U>::does_intersect_oriented(
+  const point_t<U>& p1, const point_t<U>& q1, const point_t<U>& r1,
+  const point_t<U>& p2, const point_t<U>& q2, const point_t<U>& r2,
+  utils::signs_t    side_p2, utils::signs_t side_q2, utils::signs_t side_r2
+) {
+  using utils::signs_t;
+
+  // permute second triangle, so p2 is alone on its side of the first triangle's plane
+  if (side_p2 == signs_t::POS) {
+    if (side_q2 == signs_t::POS) return check_min_max<predicates_t>(p1, r1, q1, r2, p2, q2);
+    if (side_r2 == signs_t::POS) return check_min_max<predicates_t>(p1, r1, q1, q2, r2, p2);
+    return check_min_max<predicates_t>(p1, q1, r1, p2, q2, r2);
+  }
+
+  if (side_p2 == signs_t::NEG) {
+    if (side_q2 == signs_t::NEG) return check_min_max<predicates_t>(p1, q1, r1, r2, p2, q2);
+    if (side_r2 == signs_t::NEG) return check_min_max<predicates_t>(p1, q1, r1, q2, r2, p2);
+    return check_min_max<predicates_t>(p1, r1, q1, p2, q2, r2);
+  }
+
+  if (side_q2 == signs_t::NEG) {
+    if (side_r2 != signs_t::NEG) return check_min_max<predicates_t>(p1, r1, q1, q2, r2, p2);
+    return check_min_max<predicates_t>(p1, q1, r1, p2, q2, r2);
+  }
+
+  if (side_q2 == signs_t::POS) {
+    if (side_r2 == signs_t::POS) return check_min_max<predicates_t>(p1, r1, q1, p2, q2, r2);
+    return check_min_max<predicates_t>(p1, q1, r1, q2, r2, p2);
+  }
+
+  // coplanar triangles are handled before
+  assert(side_r2 != signs_t::ZERO);
+  if (side_r2 == signs_t::POS) return check_min_max<predicates_t>(p1, q1, r1, r2, p2, q2);
+  return check_min_max<predicates_t>(p1, r1, q1, r2, p2, q2);
+}
+
+template<typename U>
+template<typename predicates_t>
+inline bool triangle_t<U>::does_intersect_by_plane_sides(
+  const triangle_props_t<U>& props,
+  const triangle_t<U>&       other,
+  const triangle_props_t<U>& other_props
+) const {
+  using utils::signs_t;
+
+  if constexpr (predicates_t::kIsExact) {
+    // props are computed with epsilon, so degeneracy is checked once more
+    bool is_degenerate       = predicates::is_collinear(a_, b_, c_);
+    bool is_other_degenerate = predicates::is_collinear(other.a_, other.b_, other.c_);
+    if (is_degenerate || is_other_degenerate) {
+      return does_intersect_degenerate_exactly(other, is_degenerate, is_other_degenerate);
+    }
+  } else if (props.is_degenerate() || other_props.is_degenerate()) {
+    return does_intersect_by_edges(props, other, other_props);
+  }
+
+  // sides of this triangle's vertices relative to other's plane
+  const vector_t<U>& other_norm = other_props.norm;
+  signs_t side_a = predicates_t::plane_side(other.a_, other.b_, other.c_, other_norm, a_);
+  signs_t side_b = predicates_t::plane_side(other.a_, other.b_, other.c_, other_norm, b_);
+  signs_t side_c = predicates_t::plane_side(other.a_, other.b_, other.c_, other_norm, c_);
+  if (side_a != signs_t::ZERO && side_a == side_b && side_a == side_c) {
+    return false;
+  }
+
+  // and vice versa
+  signs_t other_side_a = predicates_t::plane_side(a_, b_, c_, props.norm, other.a_);
+  signs_t other_side_b = predicates_t::plane_side(a_, b_, c_, props.norm, other.b_);
+  signs_t other_side_c = predicates_t::plane_side(a_, b_, c_, props.norm, other.c_);
+  if (other_side_a != signs_t::ZERO && other_side_a == other_side_b && other_side_a == other_side_c) {
+    return false;
+  }
+
+  bool is_coplanar = (side_a == signs_t::ZERO &&
+                      side_b == signs_t::ZERO &&
+                      side_c == signs_t::ZERO) ||
+                     (other_side_a == signs_t::ZERO &&
+                      other_side_b == signs_t::ZERO &&
+                      other_side_c == signs_t::ZERO);
+  if (is_coplanar) {
+    if constexpr (predicates_t::kIsExact) {
+      return does_intersect_coplanar_exactly(other);
+    }
+    return does_intersect_coplanar(props, other, other_props);
+  }
+
+  const point_t<U>& p2 = other.a_;
+  const point_t<U>& q2 = other.b_;
+  const point_t<U>& r2 = other.c_;
+
+  // permute this triangle, so its first vertex is alone on its side,
+  // other triangle's orientation is flipped if this vertex is below other's plane
+  if (side_a == signs_t::POS) {
+    if (side_b == signs_t::POS) {
+      return does_intersect_oriented<predicates_t>(c_, a_, b_, p2, r2, q2, other_side_a, other_side_c, other_side_b);
+    }
+    if (side_c == signs_t::POS) {
+      return does_intersect_oriented<predicates_t>(b_, c_, a_, p2, r2, q2, other_side_a, other_side_c, other_side_b);
+    }
+    return does_intersect_oriented<predicates_t>(a_, b_, c_, p2, q2, r2, other_side_a, other_side_b, other_side_c);
+  }
+
+  if (side_a == signs_t::NEG) {
+    if (side_b == signs_t::NEG) {
+      return does_intersect_oriented<predicates_t>(c_, a_, b_, p2, q2, r2, other_side_a, other_side_b, other_side_c);
+    }
+    if (side_c == signs_t::NEG) {
+      return does_intersect_oriented<predicates_t>(b_, c_, a_, p2, q2, r2, other_side_a, other_side_b, other_side_c);
+    }
+    return does_intersect_oriented<predicates_t>(a_, b_, c_, p2, r2, q2, other_side_a, other_side_c, other_side_b);
+  }
+
+  if (side_b == signs_t::NEG) {
+    if (side_c != signs_t::NEG) {
+      return does_intersect_oriented<predicates_t>(b_, c_, a_, p2, r2, q2, other_side_a, other_side_c, other_side_b);
+    }
+    return does_intersect_oriented<predicates_t>(a_, b_, c_, p2, q2, r2, other_side_a, other_side_b, other_side_c);
+  }
+
+  if (side_b == signs_t::POS) {
+    if (side_c == signs_t::POS) {
+      return does_intersect_oriented<predicates_t>(a_, b_, c_, p2, r2, q2, other_side_a, other_side_c, other_side_b);
+    }
+    return does_intersect_oriented<predicates_t>(b_, c_, a_, p2, q2, r2, other_side_a, other_side_b, other_side_c);
+  }
+
+  if (side_c == signs_t::POS) {
+    return does_intersect_oriented<predicates_t>(c_, a_, b_, p2, q2, r2, other_side_a, other_side_b, other_side_c);
+  }
+  return does_intersect_oriented<predicates_t>(c_, a_, b_, p2, r2, q2, other_side_a, other_side_c, other_side_b);
+}
+
+template<typename U>
+template<typename predicates_t>
+inline bool triangle_t<U>::does_intersect(
+  const triangle_t<U>&     other,
+  triangle_inters_kernel_t kernel
+) const {
+  return does_intersect<predicates_t>(get_props(), other, other.get_props(), kernel);
+}
+
+template<typename U>
+template<typename predicates_t>
+inline bool triangle_t<U>::does_intersect(
+  const triangle_props_t<U>& props,
+  const triangle_t<U>&       other,
+  const triangle_props_t<U>& other_props,
+  triangle_inters_kernel_t   kernel
+) const {
+  if constexpr (predicates_t::kIsExact) {
+    return does_intersect_by_plane_sides<predicates_t>(props, other, other_props);
+  }
+
+  switch (kernel) {
+    case triangle_inters_kernel_t::EDGES:
+      return does_intersect_by_edges(props, other, other_props);
+    case triangle_inters_kernel_t::PLANE_SIDES:
+      return does_intersect_by_plane_sides<predicates_t>(props, other, other_props);
+    case triangle_inters_kernel_t::EXACT:
+      return does_intersect_by_plane_sides<predicates::exact_predicates_t>(props, other, other_props);
+    default:
+      assert(false && "unknown triangle intersection kernel");
+      return false;
+  }
 }
 
 template <typename U>
@@ -7,6 +7,7 @@
 
 #include "plane.hpp"
 #include "point.hpp"
+#include "triangle.hpp"
 #include "AABB.hpp"
 
 template<typename T>
@@ -18,6 +19,14 @@ class triangle_with_box_t {
   triangle_with_box_t(const triangle_t<T>& triangle)
     : triangle_(triangle), bounding_box_(triangle) {}
 
+  // box must be exactly AABB_t of triangle, e.g. precomputed one
+  triangle_with_box_t(const triangle_t<T>& triangle, const AABB_t<T>& box)
+    : triangle_(triangle), bounding_box_(box) {}
+
+  [[nodiscard]] const triangle_t<T>& get_triangle() const {
+    return triangle_;
+  }
+
   [[nodiscard]] AABB_t<T> get_AABB() const {
     return bounding_box_;
   }
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+  // 0 means "as many threads as hardware supports"
+  [[nodiscard]] inline std::size_t get_num_threads(std::size_t requested) {
+    if (requested != 0) {
+      return requested;
+    }
+
+    return std::max(std::size_t{1}, static_cast<std::size_t>(std::thread::hardware_concurrency()));
+  }
+
+  // Splits [0, num_items) into chunks of chunk_size items. Threads take chunks one
+  // by one from shared counter, so cost of chunks may be very different.
+  // func(begin, end, thread_ind) is called for every chunk, thread_ind < num_threads.
+  // Calling thread is one of the workers.
+  template<typename func_t>
+  void for_each_chunk(
+    std::size_t num_threads,
+    std::size_t num_items,
+    std::size_t chunk_size,
+    func_t      func
+  ) {
+    if (num_threads <= 1 || num_items <= chunk_size) {
+      func(std::size_t{0}, num_items, std::size_t{0});
+      return;
+    }
+
+    std::atomic<std::size_t> next_chunk_begin{0};
+    auto worker = [&](std::size_t thread_ind) {
+      while (true) {
+        std::size_t begin = next_chunk_begin.fetch_add(chunk_size, std::memory_order_relaxed);
+        if (begin >= num_items) {
+          break;
+        }
+
+        func(begin, std::min(begin + chunk_size, num_items), thread_ind);
+      }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (std::size_t thread_ind = 1; thread_ind < num_threads; ++thread_ind) {
+      threads.emplace_back(worker, thread_ind);
+    }
+    worker(0);
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+};
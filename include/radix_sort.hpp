@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "parallel_for.hpp"
+
+// LSD radix sort by unsigned integer keys, a byte per pass. Stable, so items
+// with equal keys keep their order. Passes, where all keys have the same byte, are skipped.
+// With several threads items are split into a block per thread: blocks count their
+// histograms and scatter their items in parallel, each to its own part of every bucket.
+namespace radix_sort {
+  // Maps float to uint32, so that unsigned order of results is the order of floats.
+  // -0 goes right before +0, NaNs go to the ends.
+  [[nodiscard]] inline std::uint32_t to_sortable_bits(float value) {
+    std::uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    // negative floats are in reversed order, positive ones only need to go after them
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+  }
+
+  // get_key(item) must return unsigned integer, that is the same for the same item
+  template<typename item_t, typename key_func_t>
+  void sort(std::vector<item_t>& items, key_func_t get_key, std::size_t num_threads = 1) {
+    using key_t = std::decay_t<decltype(get_key(items.front()))>;
+    static_assert(std::is_unsigned_v<key_t>, "radix sort keys must be unsigned integers");
+    constexpr std::size_t kNumPasses  = sizeof(key_t);
+    constexpr std::size_t kNumBuckets = 256;
+    using histogram_t = std::array<std::size_t, kNumBuckets>;
+
+    const std::size_t num_items = items.size();
+    if (num_items <= 1) {
+      return;
+    }
+
+    num_threads = std::clamp(num_threads, std::size_t{1}, num_items);
+    const std::size_t block_size = (num_items + num_threads - 1) / num_threads;
+    const std::size_t num_blocks = (num_items + block_size - 1) / block_size;
+    auto for_each_block = [&](auto func) {
+      parallel::for_each_chunk(num_threads, num_items, block_size,
+        [&](std::size_t begin, std::size_t end, std::size_t) { func(begin / block_size, begin, end); });
+    };
+
+    std::vector<key_t> keys(num_items);
+    // histograms of the whole array are the same for every order, so they're counted once
+    std::vector<std::array<histogram_t, kNumPasses>> block_totals(num_blocks);
+    for_each_block([&](std::size_t block, std::size_t begin, std::size_t end) {
+      auto& totals = block_totals[block];
+      for (auto& pass_counts : totals) {
+        pass_counts.fill(0);
+      }
+      for (std::size_t i = begin; i < end; ++i) {
+        keys[i] = get_key(items[i]);
+        for (std::size_t pass = 0; pass < kNumPasses; ++pass) {
+          ++totals[pass][(keys[i] >> (8 * pass)) & 0xFF];
+        }
+      }
+    });
+
+    std::vector<item_t>      sorted_items(num_items);
+    std::vector<key_t>       sorted_keys(num_items);
+    std::vector<histogram_t> block_offsets(num_blocks);
+    for (std::size_t pass = 0; pass < kNumPasses; ++pass) {
+      const std::size_t shift = 8 * pass;
+      std::size_t first_bucket_size = 0;
+      for (const auto& totals : block_totals) {
+        first_bucket_size += totals[pass][(keys.front() >> shift) & 0xFF];
+      }
+      if (first_bucket_size == num_items) {
+        continue;
+      }
+
+      // block histograms of this pass depend on order left by previous passes
+      if (num_blocks == 1) {
+        block_offsets[0] = block_totals[0][pass];
+      } else {
+        for_each_block([&](std::size_t block, std::size_t begin, std::size_t end) {
+          histogram_t& counts = block_offsets[block];
+          counts.fill(0);
+          for (std::size_t i = begin; i < end; ++i) {
+            ++counts[(keys[i] >> shift) & 0xFF];
+          }
+        });
+      }
+
+      // bucket by bucket, inside bucket block by block, so sort stays stable
+      std::size_t offset = 0;
+      for (std::size_t bucket = 0; bucket < kNumBuckets; ++bucket) {
+        for (auto& counts : block_offsets) {
+          std::size_t count = counts[bucket];
+          counts[bucket] = offset;
+          offset += count;
+        }
+      }
+
+      for_each_block([&](std::size_t block, std::size_t begin, std::size_t end) {
+        histogram_t& offsets = block_offsets[block];
+        for (std::size_t i = begin; i < end; ++i) {
+          std::size_t dst = offsets[(keys[i] >> shift) & 0xFF]++;
+          sorted_items[dst] = items[i];
+          sorted_keys[dst]  = keys[i];
+        }
+      });
+      items.swap(sorted_items);
+      keys.swap(sorted_keys);
+    }
+  }
+};
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Sinks of indices of intersecting triangles. Solver calls add(ind) for every found
+// index in increasing order and finish() once after the last one.
+// Text and binary sinks also take pairs of intersecting triangles by add_pair.
+namespace result_sink {
+  enum class format_t {
+    // one decimal index per line, or two separated by space for pairs
+    TEXT,
+    // every index as little-endian uint64, without header, pairs are two in a row
+    BINARY,
+    // bit i of byte i / 8 is set if triangle i intersects, ceil(n / 8) bytes
+    BITMAP
+  };
+
+  // throws std::invalid_argument on unknown name
+  [[nodiscard]] inline format_t parse_format(std::string_view name) {
+    if (name == "text") {
+      return format_t::TEXT;
+    }
+    if (name == "binary") {
+      return format_t::BINARY;
+    }
+    if (name == "bitmap") {
+      return format_t::BITMAP;
+    }
+
+    throw std::invalid_argument(
+      "Error: unknown output format \"" + std::string(name) + "\", expected text, binary or bitmap");
+  }
+
+  // Collects bytes in a big buffer and writes it to stream by whole blocks.
+  // Whatever is left is written by flush() or by destructor.
+  class buffered_writer_t {
+   public:
+    static constexpr std::size_t kBufferSize = 1 << 20;
+
+    explicit buffered_writer_t(std::ostream& out_stream)
+      : out_stream_(out_stream), buffer_(kBufferSize) {}
+
+    buffered_writer_t(const buffered_writer_t& other) = delete;
+    buffered_writer_t& operator=(const buffered_writer_t& other) = delete;
+
+    ~buffered_writer_t() { flush(); }
+
+    // pointer to at least size free bytes, size must not exceed kBufferSize
+    [[nodiscard]] char* reserve(std::size_t size) {
+      if (buffer_.size() - used_ < size) {
+        write_buffer();
+      }
+      return buffer_.data() + used_;
+    }
+
+    void commit(std::size_t size) { used_ += size; }
+
+    void flush() {
+      write_buffer();
+      out_stream_.flush();
+    }
+
+   private:
+    void write_buffer() {
+      out_stream_.write(buffer_.data(), static_cast<std::streamsize>(used_));
+      used_ = 0;
+    }
+
+   private:
+    std::ostream&     out_stream_;
+    std::vector<char> buffer_;
+    std::size_t       used_ = 0;
+  };
+
+  // one decimal index per line, printed with std::to_chars
+  class text_sink_t {
+   public:
+    explicit text_sink_t(std::ostream& out_stream) : writer_(out_stream) {}
+
+    void add(std::size_t ind) {
+      char* begin = writer_.reserve(kMaxLineLen);
+      char* end   = std::to_chars(begin, begin + kMaxLineLen, ind).ptr;
+      *end = '\n';
+      writer_.commit(static_cast<std::size_t>(end - begin) + 1);
+    }
+
+    void add_pair(std::size_t first, std::size_t second) {
+      char* begin = writer_.reserve(2 * kMaxLineLen);
+      char* end   = std::to_chars(begin, begin + kMaxLineLen, first).ptr;
+      *end++ = ' ';
+      end = std::to_chars(end, end + kMaxLineLen, second).ptr;
+      *end = '\n';
+      writer_.commit(static_cast<std::size_t>(end - begin) + 1);
+    }
+
+    void finish() { writer_.flush(); }
+
+   private:
+    static constexpr std::size_t kMaxLineLen = std::numeric_limits<std::size_t>::digits10 + 2;
+
+   private:
+    buffered_writer_t writer_;
+  };
+
+  // every index as little-endian uint64
+  class binary_sink_t {
+   public:
+    explicit binary_sink_t(std::ostream& out_stream) : writer_(out_stream) {}
+
+    void add(std::size_t ind) {
+      std::uint64_t value = ind;
+      char* bytes = writer_.reserve(sizeof(value));
+      for (std::size_t i = 0; i < sizeof(value); ++i) {
+        bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+      }
+      writer_.commit(sizeof(value));
+    }
+
+    void add_pair(std::size_t first, std::size_t second) {
+      add(first);
+      add(second);
+    }
+
+    void finish() { writer_.flush(); }
+
+   private:
+    buffered_writer_t writer_;
+  };
+
+  // bit per triangle, the whole bitmap is written by finish()
+  class bitmap_sink_t {
+   public:
+    bitmap_sink_t(std::ostream& out_stream, std::size_t num_triangles)
+      : out_stream_(out_stream), bits_((num_triangles + 7) / 8, 0) {}
+
+    void add(std::size_t ind) {
+      bits_[ind / 8] = static_cast<std::uint8_t>(bits_[ind / 8] | (1u << (ind % 8)));
+    }
+
+    void finish() {
+      out_stream_.write(reinterpret_cast<const char*>(bits_.data()),
+                        static_cast<std::streamsize>(bits_.size()));
+      out_stream_.flush();
+    }
+
+   private:
+    std::ostream&             out_stream_;
+    std::vector<std::uint8_t> bits_;
+  };
+
+  // Calls write(sink) with sink of given format, that writes to out_stream.
+  // Lets format be chosen at runtime, while solver code is generated for each sink.
+  template<typename write_func_t>
+  void write_in_format(
+    format_t       format,
+    std::ostream&  out_stream,
+    std::size_t    num_triangles,
+    write_func_t&& write
+  ) {
+    switch (format) {
+      case format_t::TEXT: {
+        text_sink_t sink(out_stream);
+        write(sink);
+        break;
+      }
+      case format_t::BINARY: {
+        binary_sink_t sink(out_stream);
+        write(sink);
+        break;
+      }
+      case format_t::BITMAP: {
+        bitmap_sink_t sink(out_stream, num_triangles);
+        write(sink);
+        break;
+      }
+      default:
+        throw std::invalid_argument("Error: unknown output format");
+    }
+  }
+
+  // Same as write_in_format for outputs, that aren't sets of triangles,
+  // like pairs or component ids. Throws std::invalid_argument for bitmap.
+  template<typename write_func_t>
+  void write_list_in_format(
+    format_t       format,
+    std::ostream&  out_stream,
+    write_func_t&& write
+  ) {
+    switch (format) {
+      case format_t::TEXT: {
+        text_sink_t sink(out_stream);
+        write(sink);
+        break;
+      }
+      case format_t::BINARY: {
+        binary_sink_t sink(out_stream);
+        write(sink);
+        break;
+      }
+      case format_t::BITMAP:
+        throw std::invalid_argument("Error: only set of triangles can be written as bitmap");
+      default:
+        throw std::invalid_argument("Error: unknown output format");
+    }
+  }
+
+  // keeps indices in memory, for those who need them as a list
+  class vector_sink_t {
+   public:
+    void add(std::size_t ind) { indices_.push_back(ind); }
+
+    void finish() {}
+
+    [[nodiscard]] std::vector<std::size_t>& get_indices() { return indices_; }
+
+   private:
+    std::vector<std::size_t> indices_;
+  };
+};
@@ -1,10 +1,53 @@
 #pragma once
 
+#include <optional>
+
 #include "triangle.hpp"
+#include "prepared_triangle.hpp"
 #include "BVH.hpp"
+#include "result_sink.hpp"
+#include "solver_selection.hpp"
+#include "spatial_hash.hpp"
+#include "sweep_and_prune.hpp"
+#include "triangles_binary.hpp"
+#include "triangles_input.hpp"
+#include "union_find.hpp"
 
 struct naive_solution_tag {};
 struct opt_bvh_solution_tag {};
+struct sweep_and_prune_solution_tag {};
+struct spatial_hash_solution_tag {};
+// one of the solutions above, chosen by statistics of input, see solver_selection.hpp
+struct auto_solution_tag {};
+
+enum class BVH_query_mode_t {
+  // independent query from the root for each triangle
+  PER_TRIANGLE,
+  // one traversal of the tree against itself
+  DUAL_TREE
+};
+
+// settings of solutions, each solution uses only its own part
+template<typename T>
+struct solver_params_t {
+  BVH_build_params_t<T>    BVH_build_params    = {};
+  BVH_query_mode_t         BVH_query_mode      = BVH_query_mode_t::DUAL_TREE;
+  std::size_t              num_threads         = 1;
+  // used by every solution for triangle pair tests
+  triangle_inters_kernel_t narrow_phase_kernel = triangle_t<T>::kDefaultInterKernel;
+};
+
+// clusters of mutually intersecting triangles
+struct components_t {
+  // ids[i] - smallest index of triangle in component of triangle i
+  std::vector<std::size_t> ids;
+  std::size_t num_components = 0;
+  // components of at least two triangles
+  std::size_t num_clusters   = 0;
+  std::size_t max_size       = 0;
+  // triangles, that intersect something, i.e. belong to clusters
+  std::size_t num_clustered  = 0;
+};
 
 template<typename T, typename solution_tag>
 class triangles_inters_solver_t {
@@ -14,74 +57,356 @@ class triangles_inters_solver_t {
  public:
   triangles_inters_solver_t() = default;
 
-  triangles_inters_solver_t(const triangs_list_t& triangs)
-      : num_triangs_(triangs.size()), triangs_(triangs) {}
+  explicit triangles_inters_solver_t(const solver_params_t<T>& params)
+      : params_(params) {}
+
+  triangles_inters_solver_t(const triangs_list_t& triangs,
+                            const solver_params_t<T>& params = {})
+      : num_triangs_(triangs.size()), triangs_(triangs),
+        triangs_data_(triangs_.data()), params_(params) {}
+
+  [[nodiscard]] std::size_t get_num_triangles() const { return num_triangs_; }
 
   std::vector<std::size_t> get_inter_triangs_indices() {
-    return solve_impl(solution_tag{});
+    result_sink::vector_sink_t sink;
+    write_inter_triangs_indices(sink);
+    return std::move(sink.get_indices());
   }
 
-  void input() {
-    std::cin >> num_triangs_;
-    triangs_.resize(num_triangs_);
-    for (auto& triangle : triangs_) {
-      std::cin >> triangle;
+  // Every pair of intersecting triangles (i, j), i < j, sorted.
+  // max_num_pairs != 0 limits number of pairs, see BVH_t::find_intersecting_pairs.
+  std::vector<std::pair<std::size_t, std::size_t>> get_inter_triangs_pairs(
+    std::size_t max_num_pairs = 0
+  ) {
+    return find_pairs_impl(solution_tag{}, max_num_pairs);
+  }
+
+  // writes pairs by sink.add_pair, see get_inter_triangs_pairs
+  template<typename sink_t>
+  void write_inter_triangs_pairs(sink_t& sink, std::size_t max_num_pairs = 0) {
+    for (const auto& [first, second] : get_inter_triangs_pairs(max_num_pairs)) {
+      sink.add_pair(first, second);
+    }
+    sink.finish();
+  }
+
+  // Triangles are in one component, if they are connected by a chain of intersections.
+  components_t get_components() {
+    concurrent_union_find_t union_find(num_triangs_);
+    unite_impl(solution_tag{}, union_find);
+
+    components_t components;
+    components.ids = union_find.get_set_ids();
+    std::vector<std::size_t> sizes(num_triangs_, 0);
+    for (std::size_t id : components.ids) {
+      ++sizes[id];
     }
+    for (std::size_t size : sizes) {
+      if (size == 0) {
+        continue;
+      }
+
+      ++components.num_components;
+      components.max_size = std::max(components.max_size, size);
+      if (size > 1) {
+        ++components.num_clusters;
+        components.num_clustered += size;
+      }
+    }
+
+    return components;
   }
 
-  // prevent from copying and assigning
+  // Streams indices of intersecting triangles into sink in increasing order,
+  // as soon as each is known, see result_sink.hpp.
+  template<typename sink_t>
+  void write_inter_triangs_indices(sink_t& sink) {
+    solve_impl(solution_tag{}, sink);
+    sink.finish();
+  }
+
+  // reads whole stream at once, throws std::invalid_argument on malformed input
+  void input(std::istream& in_stream = std::cin) {
+    triangs_ = triangles_input::read_triangles<T>(in_stream);
+    use_own_triangles();
+  }
+
+  // Binary triangles file of scalar type T is used in place, without copying,
+  // binary file of other scalar type is converted, any other file is parsed as text.
+  // Throws std::invalid_argument on malformed input.
+  void input_file(const std::string& path) {
+    triangles_binary::mapped_file_t file(path);
+    std::string_view data = file.get_data();
+    triangles_binary::header_t header;
+    triangles_binary::view_t<T> view;
+    if (triangles_binary::has_magic(data)) {
+      view = triangles_binary::get_view<T>(data, header);
+    }
+
+    if (view.triangles == nullptr) {
+      triangs_ = triangles_binary::read_file<T>(path);
+      use_own_triangles();
+      return;
+    }
+
+    triangs_.clear();
+    num_triangs_  = view.num_triangles;
+    triangs_data_ = view.triangles;
+    boxes_        = view.boxes;
+    mapped_file_  = std::move(file);
+    scene_stats_  = std::nullopt;
+  }
+
+  // sampled statistics of input, that auto solution chooses by, computed once per input
+  const solver_selection::scene_stats_t& get_scene_stats() {
+    if (!scene_stats_) {
+      scene_stats_ = solver_selection::collect_scene_stats(triangs_data_, num_triangs_, boxes_);
+    }
+    return *scene_stats_;
+  }
+
+  solver_selection::solver_kind_t get_selected_solver() {
+    return solver_selection::choose_solver(get_scene_stats());
+  }
+
+  // prevent from copying and assigning, triangs_data_ may point to own data
   triangles_inters_solver_t(const triangles_inters_solver_t& other) = delete;
   triangles_inters_solver_t& operator=(const triangles_inters_solver_t& other) = delete;
 
  private:
+  // node boxes are rounded outward to float, so the tree finds the same triangles
+  // with half of memory traffic, while narrow phase works with triangles in T
+  using BVH_tree_t = BVH_t<T, float>;
+
   // naive solution
-  std::vector<std::size_t> solve_impl(
-    naive_solution_tag
+  template<typename sink_t>
+  void solve_impl(
+    naive_solution_tag,
+    sink_t& sink
   ) {
-    std::vector<std::size_t> result;
     std::vector<bool> is_marked(num_triangs_);
+    // props of each triangle are computed once, not on every pair test
+    std::vector<prepared_triangle_t<T>> prepared(triangs_data_, triangs_data_ + num_triangs_);
     for (std::size_t cur_ind = 0; cur_ind < num_triangs_; ++cur_ind) {
       if (is_marked[cur_ind]) {
-        result.emplace_back(cur_ind);
+        sink.add(cur_ind);
         continue;
       }
 
       bool is_inter = false;
-      const auto& cur = triangs_[cur_ind];
+      const auto& cur = prepared[cur_ind];
       for (std::size_t other_ind = 0; other_ind < num_triangs_; ++other_ind) {
         if (other_ind == cur_ind) {
           continue;
         }
 
-        if (cur.does_intersect(triangs_[other_ind])) {
-          result.emplace_back(cur_ind);
+        if (cur.does_intersect(prepared[other_ind], params_.narrow_phase_kernel)) {
+          sink.add(cur_ind);
           is_marked[other_ind] = true;
           is_inter = true;
           break;
         }
       }
     }
+  }
+
+  std::vector<std::pair<std::size_t, std::size_t>> find_pairs_impl(
+    naive_solution_tag,
+    std::size_t max_num_pairs
+  ) {
+    std::vector<std::pair<std::size_t, std::size_t>> result;
+    std::vector<prepared_triangle_t<T>> prepared(triangs_data_, triangs_data_ + num_triangs_);
+    for (std::size_t first = 0; first < num_triangs_; ++first) {
+      for (std::size_t second = first + 1; second < num_triangs_; ++second) {
+        if (!prepared[first].does_intersect(prepared[second], params_.narrow_phase_kernel)) {
+          continue;
+        }
+
+        result.emplace_back(first, second);
+        if (result.size() == max_num_pairs) {
+          return result;
+        }
+      }
+    }
 
     return result;
   }
 
+  void unite_impl(
+    naive_solution_tag,
+    concurrent_union_find_t& union_find
+  ) {
+    std::vector<prepared_triangle_t<T>> prepared(triangs_data_, triangs_data_ + num_triangs_);
+    for (std::size_t first = 0; first < num_triangs_; ++first) {
+      for (std::size_t second = first + 1; second < num_triangs_; ++second) {
+        if (!union_find.is_same(first, second) &&
+            prepared[first].does_intersect(prepared[second], params_.narrow_phase_kernel)) {
+          union_find.unite(first, second);
+        }
+      }
+    }
+  }
+
   // fast solution, naive optimized with BVH tree
-  std::vector<std::size_t> solve_impl(
-    opt_bvh_solution_tag
+  template<typename sink_t>
+  void solve_impl(
+    opt_bvh_solution_tag,
+    sink_t& sink
   ) {
-    BVH_t BVH_tree(triangs_);
-    std::vector<std::size_t> result;
+    BVH_tree_t BVH_tree(triangs_data_, num_triangs_, boxes_, get_BVH_build_params());
+    if (params_.BVH_query_mode == BVH_query_mode_t::DUAL_TREE) {
+      BVH_tree.mark_self_intersections(params_.num_threads);
+    } else {
+      BVH_tree.mark_not_alone_triangles(params_.num_threads);
+    }
+
     for (std::size_t cur_ind = 0; cur_ind < num_triangs_; ++cur_ind) {
-      if (BVH_tree.is_triangle_not_alone(
-          triangs_[cur_ind], cur_ind)) {
-        result.emplace_back(cur_ind);
+      if (BVH_tree.is_marked(cur_ind)) {
+        sink.add(cur_ind);
       }
     }
+  }
 
-    return result;
+  std::vector<std::pair<std::size_t, std::size_t>> find_pairs_impl(
+    opt_bvh_solution_tag,
+    std::size_t max_num_pairs
+  ) {
+    BVH_tree_t BVH_tree(triangs_data_, num_triangs_, boxes_, get_BVH_build_params());
+    return BVH_tree.find_intersecting_pairs(params_.num_threads, max_num_pairs);
+  }
+
+  void unite_impl(
+    opt_bvh_solution_tag,
+    concurrent_union_find_t& union_find
+  ) {
+    BVH_tree_t BVH_tree(triangs_data_, num_triangs_, boxes_, get_BVH_build_params());
+    BVH_tree.unite_intersecting_triangles(union_find, params_.num_threads);
+  }
+
+  // sort-and-sweep along the axis of the greatest spread, no tree at all
+  template<typename sink_t>
+  void solve_impl(
+    sweep_and_prune_solution_tag,
+    sink_t& sink
+  ) {
+    sweep_and_prune_t<T> sweep(triangs_data_, num_triangs_, boxes_, params_.narrow_phase_kernel);
+    sweep.mark_self_intersections(params_.num_threads);
+
+    for (std::size_t cur_ind = 0; cur_ind < num_triangs_; ++cur_ind) {
+      if (sweep.is_marked(cur_ind)) {
+        sink.add(cur_ind);
+      }
+    }
+  }
+
+  std::vector<std::pair<std::size_t, std::size_t>> find_pairs_impl(
+    sweep_and_prune_solution_tag,
+    std::size_t max_num_pairs
+  ) {
+    sweep_and_prune_t<T> sweep(triangs_data_, num_triangs_, boxes_, params_.narrow_phase_kernel);
+    return sweep.find_intersecting_pairs(params_.num_threads, max_num_pairs);
+  }
+
+  void unite_impl(
+    sweep_and_prune_solution_tag,
+    concurrent_union_find_t& union_find
+  ) {
+    sweep_and_prune_t<T> sweep(triangs_data_, num_triangs_, boxes_, params_.narrow_phase_kernel);
+    sweep.unite_intersecting_triangles(union_find, params_.num_threads);
+  }
+
+  // hashed uniform grid with cell size chosen by boxes of triangles
+  template<typename sink_t>
+  void solve_impl(
+    spatial_hash_solution_tag,
+    sink_t& sink
+  ) {
+    spatial_hash_t<T> grid(triangs_data_, num_triangs_, boxes_, params_.narrow_phase_kernel);
+    grid.mark_self_intersections(params_.num_threads);
+
+    for (std::size_t cur_ind = 0; cur_ind < num_triangs_; ++cur_ind) {
+      if (grid.is_marked(cur_ind)) {
+        sink.add(cur_ind);
+      }
+    }
+  }
+
+  std::vector<std::pair<std::size_t, std::size_t>> find_pairs_impl(
+    spatial_hash_solution_tag,
+    std::size_t max_num_pairs
+  ) {
+    spatial_hash_t<T> grid(triangs_data_, num_triangs_, boxes_, params_.narrow_phase_kernel);
+    return grid.find_intersecting_pairs(params_.num_threads, max_num_pairs);
+  }
+
+  void unite_impl(
+    spatial_hash_solution_tag,
+    concurrent_union_find_t& union_find
+  ) {
+    spatial_hash_t<T> grid(triangs_data_, num_triangs_, boxes_, params_.narrow_phase_kernel);
+    grid.unite_intersecting_triangles(union_find, params_.num_threads);
+  }
+
+  // the same calls, redirected to selected solution
+  template<typename sink_t>
+  void solve_impl(
+    auto_solution_tag,
+    sink_t& sink
+  ) {
+    with_selected_solution([&](auto tag) { solve_impl(tag, sink); });
+  }
+
+  std::vector<std::pair<std::size_t, std::size_t>> find_pairs_impl(
+    auto_solution_tag,
+    std::size_t max_num_pairs
+  ) {
+    return with_selected_solution([&](auto tag) { return find_pairs_impl(tag, max_num_pairs); });
+  }
+
+  void unite_impl(
+    auto_solution_tag,
+    concurrent_union_find_t& union_find
+  ) {
+    with_selected_solution([&](auto tag) { unite_impl(tag, union_find); });
+  }
+
+  // calls func with tag of selected solution
+  template<typename func_t>
+  decltype(auto) with_selected_solution(func_t func) {
+    switch (get_selected_solver()) {
+      case solver_selection::solver_kind_t::NAIVE:           return func(naive_solution_tag{});
+      case solver_selection::solver_kind_t::BVH:             return func(opt_bvh_solution_tag{});
+      case solver_selection::solver_kind_t::SWEEP_AND_PRUNE: return func(sweep_and_prune_solution_tag{});
+      case solver_selection::solver_kind_t::SPATIAL_HASH:    return func(spatial_hash_solution_tag{});
+      default:                                               return func(opt_bvh_solution_tag{});
+    }
+  }
+
+  [[nodiscard]] BVH_build_params_t<T> get_BVH_build_params() const {
+    BVH_build_params_t<T> build_params = params_.BVH_build_params;
+    build_params.num_threads         = params_.num_threads;
+    build_params.narrow_phase_kernel = params_.narrow_phase_kernel;
+    return build_params;
+  }
+
+ private:
+  void use_own_triangles() {
+    num_triangs_  = triangs_.size();
+    triangs_data_ = triangs_.data();
+    boxes_        = nullptr;
+    mapped_file_  = {};
+    scene_stats_  = std::nullopt;
   }
 
  private:
-  std::size_t num_triangs_;
+  std::size_t num_triangs_ = 0;
   std::vector<triangle_t<T>> triangs_;
+  // triangles used by solutions: data of triangs_ or of mapped binary file
+  const triangle_t<T>* triangs_data_ = nullptr;
+  // precomputed boxes of mapped binary file, nullptr if there are none
+  const AABB_t<T>* boxes_ = nullptr;
+  triangles_binary::mapped_file_t mapped_file_;
+  solver_params_t<T> params_ = {};
+  // filled by get_scene_stats on demand
+  std::optional<solver_selection::scene_stats_t> scene_stats_;
 };
\ No newline at end of file
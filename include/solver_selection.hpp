@@ -0,0 +1,287 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "AABB.hpp"
+#include "triangle.hpp"
+
+// Chooses broad phase for a scene by statistics of a small random sample of triangles.
+// Each solution gets an estimated cost by a model of its build and of pairs it has
+// to look at, the cheapest one wins. Constants are fitted to single thread timings.
+namespace solver_selection {
+  enum class solver_kind_t {
+    NAIVE,
+    BVH,
+    SWEEP_AND_PRUNE,
+    SPATIAL_HASH
+  };
+
+  [[nodiscard]] inline const char* get_solver_name(solver_kind_t solver) {
+    switch (solver) {
+      case solver_kind_t::NAIVE:           return "naive";
+      case solver_kind_t::BVH:             return "BVH";
+      case solver_kind_t::SWEEP_AND_PRUNE: return "sweep and prune";
+      case solver_kind_t::SPATIAL_HASH:    return "spatial hash";
+      default:                             return "";
+    }
+  }
+
+  // triangles in random sample, pairs of the sample give overlap estimates
+  const std::size_t kSampleSize = 512;
+  // below it all pairs are tested at once, nothing is built and nothing is sampled
+  const std::size_t kMaxNaiveTriangles = 16;
+  // sampled pairs with overlapping boxes, that are tested by narrow phase
+  const std::size_t kMaxHitTests = 1024;
+
+  struct scene_stats_t {
+    std::size_t num_triangles = 0;
+    // 0 if scene is too small to be sampled
+    std::size_t sample_size   = 0;
+    // fraction of sampled pairs of triangles, that lie in one plane,
+    // narrow phase of such pairs is many times slower
+    double planarity          = 0;
+    // mean of the largest box extents, relative to the widest extent of scene
+    double mean_size          = 0;
+    // the largest box extent divided by mean of them, big for mixed sizes
+    double size_spread        = 0;
+    // fractions of sampled pairs, whose boxes overlap: in 3D, along the axis
+    // of sweep and prune and in cells of the spatial hash
+    double box_overlap        = 0;
+    double sweep_overlap      = 0;
+    double cell_overlap       = 0;
+    // mean number of spatial hash cells, covered by a box
+    double cells_per_triangle = 0;
+    // fraction of tested pairs with overlapping boxes, that really intersect
+    double hit_ratio          = 0;
+  };
+
+  // estimated time of each solution, in nanoseconds of a single thread
+  struct costs_t {
+    double naive           = 0;
+    double BVH             = 0;
+    double sweep_and_prune = 0;
+    double spatial_hash    = 0;
+  };
+
+  // boxes may be nullptr, else boxes[i] must be exactly AABB_t of triangles[i]
+  template<typename T>
+  [[nodiscard]] scene_stats_t collect_scene_stats(
+    const triangle_t<T>* triangles,
+    std::size_t          num_triangles,
+    const AABB_t<T>*     boxes
+  ) {
+    using bounds_t = std::array<double, 3>;
+
+    scene_stats_t stats;
+    stats.num_triangles = num_triangles;
+    if (num_triangles <= kMaxNaiveTriangles) {
+      return stats;
+    }
+
+    // Small scenes are taken whole, big ones are sampled without repetitions by Floyd's
+    // algorithm, a repeated triangle would make a pair with itself, that overlaps and hits.
+    // Fixed seed keeps the choice the same for the same input.
+    const std::size_t sample_size = std::min(num_triangles, kSampleSize);
+    std::mt19937_64 gen(num_triangles);
+    std::set<std::size_t> sample_inds;
+    for (std::size_t top = num_triangles - sample_size; top < num_triangles; ++top) {
+      std::size_t ind = std::uniform_int_distribution<std::size_t>(0, top)(gen);
+      if (!sample_inds.insert(ind).second) {
+        sample_inds.insert(top);
+      }
+    }
+
+    std::vector<bounds_t> mins(sample_size), maxs(sample_size);
+    std::vector<const triangle_t<T>*> sample(sample_size);
+    std::size_t pos = 0;
+    for (std::size_t ind : sample_inds) {
+      sample[pos] = triangles + ind;
+      AABB_t<T> box = boxes ? boxes[ind] : AABB_t<T>(triangles[ind]);
+      point_t<T> min_corner = box.get_min_corner(), max_corner = box.get_max_corner();
+      mins[pos] = {static_cast<double>(min_corner.x), static_cast<double>(min_corner.y),
+                   static_cast<double>(min_corner.z)};
+      maxs[pos] = {static_cast<double>(max_corner.x), static_cast<double>(max_corner.y),
+                   static_cast<double>(max_corner.z)};
+      ++pos;
+    }
+    stats.sample_size = sample_size;
+
+    const double num_sampled = static_cast<double>(sample_size);
+    bounds_t scene_min = mins.front(), scene_max = maxs.front();
+    bounds_t center_sums{}, center_squares{};
+    double sizes_sum = 0, max_size = 0;
+    for (std::size_t i = 0; i < sample_size; ++i) {
+      double size = 0;
+      for (std::size_t axis = 0; axis < 3; ++axis) {
+        scene_min[axis] = std::min(scene_min[axis], mins[i][axis]);
+        scene_max[axis] = std::max(scene_max[axis], maxs[i][axis]);
+        double center = (mins[i][axis] + maxs[i][axis]) / 2;
+        center_sums[axis]    += center;
+        center_squares[axis] += center * center;
+        size = std::max(size, maxs[i][axis] - mins[i][axis]);
+      }
+      sizes_sum += size;
+      max_size   = std::max(max_size, size);
+    }
+
+    // axis of the greatest variance of centers, as sweep_and_prune_t chooses it
+    std::size_t sweep_axis = 0;
+    double widest = 0, max_variance = -1;
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+      widest = std::max(widest, scene_max[axis] - scene_min[axis]);
+      double mean     = center_sums[axis] / num_sampled;
+      double variance = center_squares[axis] / num_sampled - mean * mean;
+      if (variance > max_variance) {
+        max_variance = variance;
+        sweep_axis   = axis;
+      }
+    }
+
+    double mean_size = sizes_sum / num_sampled;
+    stats.mean_size   = widest > 0 ? mean_size / widest : 0;
+    stats.size_spread = mean_size > 0 ? max_size / mean_size : 1;
+
+    // cell edge as spatial_hash_t chooses it, including doubling for too many entries
+    double cell_size = mean_size > 0 ? mean_size : (widest > 0 ? widest : 1);
+    std::vector<std::array<std::int64_t, 6>> cells(sample_size);
+    for (;;) {
+      double num_cells = 0;
+      for (std::size_t i = 0; i < sample_size; ++i) {
+        double covered = 1;
+        for (std::size_t axis = 0; axis < 3; ++axis) {
+          cells[i][axis]     = static_cast<std::int64_t>(std::floor(mins[i][axis] / cell_size));
+          cells[i][axis + 3] = static_cast<std::int64_t>(std::floor(maxs[i][axis] / cell_size));
+          covered *= static_cast<double>(cells[i][axis + 3] - cells[i][axis] + 1);
+        }
+        num_cells += covered;
+      }
+
+      stats.cells_per_triangle = num_cells / num_sampled;
+      if (stats.cells_per_triangle <= 16) {
+        break;
+      }
+      cell_size *= 2;
+    }
+
+    // planes of sampled triangles in doubles, degenerate triangles get zero normal
+    auto to_double = [](const point_t<T>& point) {
+      return point_t<double>{static_cast<double>(point.x), static_cast<double>(point.y),
+                             static_cast<double>(point.z)};
+    };
+    struct sample_plane_t {
+      point_t<double> normal;
+      double          offset        = 0;
+      bool            is_degenerate = true;
+    };
+    std::vector<sample_plane_t> planes(sample_size);
+    for (std::size_t i = 0; i < sample_size; ++i) {
+      auto points = sample[i]->get_points();
+      point_t<double> origin = to_double(points[0]);
+      point_t<double> normal = vec_ops::cross(to_double(points[1]) - origin,
+                                              to_double(points[2]) - origin);
+      double length = normal.get_len();
+      normal = length > 0 ? normal * (1 / length) : point_t<double>{0, 0, 0};
+      planes[i] = {normal, vec_ops::dot(normal, origin), !(length > 0)};
+    }
+    const double kCoplanarEps = 1e-9 * std::max(widest, 1.0);
+    auto is_on_plane = [&](std::size_t plane_ind, std::size_t triangle_ind) {
+      const auto& [normal, offset, is_degenerate] = planes[plane_ind];
+      if (is_degenerate) {
+        return false;
+      }
+      for (const point_t<T>& point : sample[triangle_ind]->get_points()) {
+        if (std::abs(vec_ops::dot(normal, to_double(point)) - offset) > kCoplanarEps) {
+          return false;
+        }
+      }
+      return true;
+    };
+
+    std::size_t num_box_overlaps = 0, num_sweep_overlaps = 0, num_cell_overlaps = 0;
+    std::size_t num_coplanar = 0, num_hit_tests = 0, num_hits = 0;
+    for (std::size_t lhs = 0; lhs < sample_size; ++lhs) {
+      for (std::size_t rhs = lhs + 1; rhs < sample_size; ++rhs) {
+        num_coplanar += is_on_plane(lhs, rhs);
+        bool does_box_overlap  = true;
+        bool does_cell_overlap = true;
+        for (std::size_t axis = 0; axis < 3; ++axis) {
+          does_box_overlap  &= mins[lhs][axis] <= maxs[rhs][axis] &&
+                               mins[rhs][axis] <= maxs[lhs][axis];
+          does_cell_overlap &= cells[lhs][axis] <= cells[rhs][axis + 3] &&
+                               cells[rhs][axis] <= cells[lhs][axis + 3];
+        }
+        num_box_overlaps   += does_box_overlap;
+        if (does_box_overlap && num_hit_tests < kMaxHitTests) {
+          ++num_hit_tests;
+          num_hits += sample[lhs]->does_intersect(*sample[rhs]);
+        }
+        num_cell_overlaps  += does_cell_overlap;
+        num_sweep_overlaps += mins[lhs][sweep_axis] <= maxs[rhs][sweep_axis] &&
+                              mins[rhs][sweep_axis] <= maxs[lhs][sweep_axis];
+      }
+    }
+
+    const double num_pairs = num_sampled * (num_sampled - 1) / 2;
+    stats.box_overlap   = static_cast<double>(num_box_overlaps)   / num_pairs;
+    stats.sweep_overlap = static_cast<double>(num_sweep_overlaps) / num_pairs;
+    stats.cell_overlap  = static_cast<double>(num_cell_overlaps)  / num_pairs;
+    stats.planarity     = static_cast<double>(num_coplanar)       / num_pairs;
+    stats.hit_ratio     = num_hit_tests == 0 ? 0 :
+                          static_cast<double>(num_hits) / static_cast<double>(num_hit_tests);
+    return stats;
+  }
+
+  [[nodiscard]] inline costs_t estimate_costs(const scene_stats_t& stats) {
+    // nanoseconds per triangle, per entry or per pair, fitted to single thread runs
+    // on random, flat, clustered and mixed size scenes of 100 - 200000 triangles
+    const double kPairTestCost     = 40;
+    const double kCoplanarTestCost = 1700;
+    const double kBVHNodeCost      = 180;
+    const double kSortCost         = 300;
+    const double kSweepStepCost    = 10;
+    const double kEntryCost        = 130;
+    const double kCellPairCost     = 12;
+
+    const double num_triangles = static_cast<double>(stats.num_triangles);
+    const double num_pairs     = num_triangles * (num_triangles - 1) / 2;
+    const double log_triangles = std::log2(std::max(num_triangles, 2.0));
+    // Triangle is marked by its first hit, marked ones are skipped, so a triangle looks at
+    // about 1 / hit_ratio of its candidates at most. Dense scenes are cheap for everyone.
+    const double num_candidates = stats.box_overlap * (num_triangles - 1) / 2;
+    const double pairs_part     = stats.hit_ratio * num_candidates > 1 ?
+                                  1 / (stats.hit_ratio * num_candidates) : 1;
+    // every candidate pair is tested by narrow phase in any structure
+    const double box_pairs_cost = stats.box_overlap * num_pairs * pairs_part * kPairTestCost;
+
+    costs_t costs;
+    costs.naive           = num_pairs * (kPairTestCost + stats.planarity * kCoplanarTestCost);
+    costs.BVH             = num_triangles * log_triangles * kBVHNodeCost + box_pairs_cost;
+    costs.sweep_and_prune = num_triangles * kSortCost + box_pairs_cost +
+                            stats.sweep_overlap * num_pairs * pairs_part * kSweepStepCost;
+    costs.spatial_hash    = num_triangles * stats.cells_per_triangle * kEntryCost + box_pairs_cost +
+                            stats.cell_overlap * num_pairs * pairs_part * kCellPairCost;
+    return costs;
+  }
+
+  [[nodiscard]] inline solver_kind_t choose_solver(const scene_stats_t& stats) {
+    if (stats.sample_size == 0) {
+      return solver_kind_t::NAIVE;
+    }
+
+    costs_t costs = estimate_costs(stats);
+    std::array<std::pair<double, solver_kind_t>, 4> candidates{{
+      {costs.naive,           solver_kind_t::NAIVE},
+      {costs.BVH,             solver_kind_t::BVH},
+      {costs.sweep_and_prune, solver_kind_t::SWEEP_AND_PRUNE},
+      {costs.spatial_hash,    solver_kind_t::SPATIAL_HASH},
+    }};
+    return std::min_element(candidates.begin(), candidates.end(),
+      [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; })->second;
+  }
+};
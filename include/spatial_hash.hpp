@@ -0,0 +1,460 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "logLib.hpp"
+#include "parallel_for.hpp"
+#include "inflated_AABB.hpp"
+#include "prepared_triangle.hpp"
+#include "stats.hpp"
+#include "union_find.hpp"
+
+// Uniform grid of cubic cells, hashed into a table of buckets, so empty cells cost nothing.
+// Every triangle is put into each bucket of cells, that its box covers. Buckets are
+// ranges of one array, laid out by counting sort. Pair is tested only in the bucket
+// of its canonical cell - the lowest cell, covered by both boxes, so it's tested once,
+// even if triangles share many cells or several cells share a bucket.
+template<typename T>
+class spatial_hash_t {
+ public:
+  using triangs_list_t = std::vector<prepared_triangle_t<T>>;
+  using indices_list_t = std::vector<std::size_t>;
+  // indices of triangles in input list, first < second
+  using index_pair_t   = std::pair<std::size_t, std::size_t>;
+
+  spatial_hash_t(const std::vector<triangle_t<T>>& triangles,
+                 triangle_inters_kernel_t kernel = triangle_t<T>::kDefaultInterKernel)
+      : spatial_hash_t(triangles.data(), triangles.size(), nullptr, kernel) {}
+
+  // boxes may be nullptr, else boxes[i] must be exactly AABB_t of triangles[i]
+  spatial_hash_t(const triangle_t<T>*     triangles,
+                 std::size_t              num_triangles,
+                 const AABB_t<T>*         boxes,
+                 triangle_inters_kernel_t kernel = triangle_t<T>::kDefaultInterKernel);
+
+  // Marks every triangle that intersects at least one other triangle.
+  // Buckets are split into chunks, that threads take dynamically.
+  void mark_self_intersections(std::size_t num_threads = 1);
+
+  // same contract as BVH_t::find_intersecting_pairs
+  [[nodiscard]] std::vector<index_pair_t> find_intersecting_pairs(
+    std::size_t num_threads   = 1,
+    std::size_t max_num_pairs = 0
+  ) const;
+
+  // same contract as BVH_t::unite_intersecting_triangles
+  void unite_intersecting_triangles(
+    concurrent_union_find_t& components,
+    std::size_t              num_threads = 1
+  ) const;
+
+  [[nodiscard]] bool is_marked(std::size_t triangle_ind) const {
+    return visited_[triangle_ind].load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] T get_cell_size() const { return cell_size_; }
+
+  [[nodiscard]] std::size_t get_num_buckets() const { return bucket_begins_.size() - 1; }
+
+  // number of (triangle, bucket) entries
+  [[nodiscard]] std::size_t get_num_entries() const { return entries_.size(); }
+
+ private:
+  using cell_t = std::array<std::int64_t, 3>;
+
+  // cells covered by box of triangle, bounds are inclusive
+  struct cell_range_t {
+    cell_t min_cell;
+    cell_t max_cell;
+  };
+
+  [[nodiscard]] cell_range_t get_cell_range(const inflated_AABB_t<T>& box) const;
+
+  [[nodiscard]] std::size_t get_bucket(const cell_t& cell) const;
+
+  // Cell edge is the mean of the largest box extents, so a typical triangle covers
+  // up to 2 cells along each axis. It's doubled, while big triangles make too many entries.
+  // Fills cell_ranges_ for the chosen size.
+  void choose_cell_size();
+
+  // counted in T, as product of cells along axes may not fit in std::size_t
+  [[nodiscard]] T count_entries() const;
+
+  // calls func(bucket) for every distinct bucket of cells covered by triangle
+  template<typename func_t>
+  void for_each_bucket_of(std::size_t triangle_ind, std::vector<std::size_t>& last_triangle,
+                          func_t func) const;
+
+  // Calls func(lhs_ind, rhs_ind, thread_ind) for every pair of triangles with overlapping boxes
+  // once, lhs_ind < rhs_ind. Entries of bucket after lhs_pos are visited from
+  // get_next(lhs_pos, pos) - the first entry >= pos, that may give something new.
+  // Buckets are skipped as a whole once is_stopped().
+  template<typename func_t, typename next_func_t, typename stop_func_t>
+  void for_each_overlapping_pair(
+    std::size_t num_threads,
+    func_t      func,
+    next_func_t get_next,
+    stop_func_t is_stopped
+  ) const;
+
+  // Returns the first entry position >= pos, for which is_skipped(position) is false.
+  // is_skipped must never change from true back to false. jumps[p] == q means, that all of
+  // [p, q) are skipped, they are shortened by path splitting, like in union find.
+  template<typename skip_func_t>
+  [[nodiscard]] std::size_t skip_entries(
+    std::size_t                            pos,
+    std::vector<std::atomic<std::size_t>>& jumps,
+    skip_func_t                            is_skipped
+  ) const;
+
+  // jumps of skip_entries, each entry is skipped alone at start
+  [[nodiscard]] std::vector<std::atomic<std::size_t>> make_jumps() const;
+
+ private:
+  // entries per triangle, above which cells are made bigger
+  static constexpr std::size_t kMaxMeanEntries = 16;
+  // cells per axis are limited, so their coordinates never overflow
+  static constexpr T kMaxCellsPerAxis = static_cast<T>(1 << 30);
+  // number of buckets taken by thread at once
+  static const std::size_t kChunkSize = 1024;
+
+ private:
+  const std::size_t               num_triangles_;
+  const triangle_inters_kernel_t  kernel_;
+  triangs_list_t                  triangles_;
+  std::vector<inflated_AABB_t<T>> boxes_;
+  std::vector<cell_range_t>       cell_ranges_;
+
+  point_t<T>                      origin_;
+  T                               cell_size_ = 1;
+  // number of buckets is a power of 2
+  unsigned                        bucket_bits_ = 0;
+  // triangles of bucket b are entries_[bucket_begins_[b], bucket_begins_[b + 1])
+  indices_list_t                  bucket_begins_;
+  indices_list_t                  entries_;
+
+  // marks are set from several threads
+  std::vector<std::atomic<bool>>  visited_;
+};
+
+template <typename T>
+spatial_hash_t<T>::spatial_hash_t(
+  const triangle_t<T>*     triangles,
+  std::size_t              num_triangles,
+  const AABB_t<T>*         boxes,
+  triangle_inters_kernel_t kernel
+) : num_triangles_(num_triangles), kernel_(kernel), visited_(num_triangles) {
+  triangles_.reserve(num_triangles_);
+  boxes_.reserve(num_triangles_);
+  for (std::size_t i = 0; i < num_triangles_; ++i) {
+    if (boxes != nullptr) {
+      triangles_.emplace_back(triangles[i], boxes[i]);
+    } else {
+      triangles_.emplace_back(triangles[i]);
+    }
+    boxes_.emplace_back(triangles_.back().get_AABB());
+  }
+
+  choose_cell_size();
+
+  std::size_t num_buckets = 1;
+  for (T num_entries = count_entries(); static_cast<T>(num_buckets) < num_entries; num_buckets *= 2) {
+    ++bucket_bits_;
+  }
+
+  // counting sort: sizes of buckets, their begins, then entries in place
+  std::vector<std::size_t> last_triangle(num_buckets, std::numeric_limits<std::size_t>::max());
+  bucket_begins_.assign(num_buckets + 1, 0);
+  for (std::size_t i = 0; i < num_triangles_; ++i) {
+    for_each_bucket_of(i, last_triangle, [&](std::size_t bucket) { ++bucket_begins_[bucket + 1]; });
+  }
+  for (std::size_t bucket = 0; bucket < num_buckets; ++bucket) {
+    bucket_begins_[bucket + 1] += bucket_begins_[bucket];
+  }
+
+  entries_.resize(bucket_begins_.back());
+  std::vector<std::size_t> fill_pos(bucket_begins_.begin(), bucket_begins_.end() - 1);
+  std::fill(last_triangle.begin(), last_triangle.end(), std::numeric_limits<std::size_t>::max());
+  for (std::size_t i = 0; i < num_triangles_; ++i) {
+    for_each_bucket_of(i, last_triangle, [&](std::size_t bucket) { entries_[fill_pos[bucket]++] = i; });
+  }
+}
+
+template <typename T>
+void spatial_hash_t<T>::choose_cell_size() {
+  if (num_triangles_ == 0) {
+    return;
+  }
+
+  point_t<T> scene_min = boxes_.front().get_min_corner();
+  point_t<T> scene_max = boxes_.front().get_max_corner();
+  T extents_sum = 0;
+  for (const auto& box : boxes_) {
+    point_t<T> min_corner = box.get_min_corner();
+    point_t<T> max_corner = box.get_max_corner();
+    scene_min = {std::min(scene_min.x, min_corner.x), std::min(scene_min.y, min_corner.y),
+                 std::min(scene_min.z, min_corner.z)};
+    scene_max = {std::max(scene_max.x, max_corner.x), std::max(scene_max.y, max_corner.y),
+                 std::max(scene_max.z, max_corner.z)};
+    extents_sum += std::max({max_corner.x - min_corner.x, max_corner.y - min_corner.y,
+                             max_corner.z - min_corner.z});
+  }
+  origin_ = scene_min;
+
+  T scene_extent = std::max({scene_max.x - scene_min.x, scene_max.y - scene_min.y,
+                             scene_max.z - scene_min.z});
+  cell_size_ = std::max(extents_sum / static_cast<T>(num_triangles_),
+                        scene_extent / kMaxCellsPerAxis);
+  if (!(cell_size_ > 0)) {
+    cell_size_ = 1;
+  }
+
+  cell_ranges_.resize(num_triangles_);
+  while (true) {
+    for (std::size_t i = 0; i < num_triangles_; ++i) {
+      cell_ranges_[i] = get_cell_range(boxes_[i]);
+    }
+    if (count_entries() <= static_cast<T>(kMaxMeanEntries * num_triangles_)) {
+      break;
+    }
+    cell_size_ *= 2;
+  }
+}
+
+template <typename T>
+[[nodiscard]] typename spatial_hash_t<T>::cell_range_t spatial_hash_t<T>::get_cell_range(
+  const inflated_AABB_t<T>& box
+) const {
+  point_t<T> min_corner = (box.get_min_corner() - origin_) * (static_cast<T>(1) / cell_size_);
+  point_t<T> max_corner = (box.get_max_corner() - origin_) * (static_cast<T>(1) / cell_size_);
+  auto to_cell = [](T coord) {
+    return static_cast<std::int64_t>(std::floor(std::clamp(coord, static_cast<T>(-1), kMaxCellsPerAxis)));
+  };
+
+  return {{to_cell(min_corner.x), to_cell(min_corner.y), to_cell(min_corner.z)},
+          {to_cell(max_corner.x), to_cell(max_corner.y), to_cell(max_corner.z)}};
+}
+
+template <typename T>
+[[nodiscard]] inline std::size_t spatial_hash_t<T>::get_bucket(const cell_t& cell) const {
+  if (bucket_bits_ == 0) {
+    return 0;
+  }
+
+  // multiplicative hashing, the highest bits are mixed the best
+  std::uint64_t hash = static_cast<std::uint64_t>(cell[0]) * 0x9E3779B97F4A7C15ull ^
+                       static_cast<std::uint64_t>(cell[1]) * 0xC2B2AE3D27D4EB4Full ^
+                       static_cast<std::uint64_t>(cell[2]) * 0x165667B19E3779F9ull;
+  hash *= 0xFF51AFD7ED558CCDull;
+  return hash >> (64 - bucket_bits_);
+}
+
+template <typename T>
+[[nodiscard]] T spatial_hash_t<T>::count_entries() const {
+  T num_entries = 0;
+  for (const cell_range_t& range : cell_ranges_) {
+    T num_cells = 1;
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+      num_cells *= static_cast<T>(range.max_cell[axis] - range.min_cell[axis] + 1);
+    }
+    num_entries += num_cells;
+  }
+
+  return num_entries;
+}
+
+template <typename T>
+template <typename func_t>
+void spatial_hash_t<T>::for_each_bucket_of(
+  std::size_t               triangle_ind,
+  std::vector<std::size_t>& last_triangle,
+  func_t                    func
+) const {
+  const cell_range_t& range = cell_ranges_[triangle_ind];
+  cell_t cell;
+  for (cell[0] = range.min_cell[0]; cell[0] <= range.max_cell[0]; ++cell[0]) {
+    for (cell[1] = range.min_cell[1]; cell[1] <= range.max_cell[1]; ++cell[1]) {
+      for (cell[2] = range.min_cell[2]; cell[2] <= range.max_cell[2]; ++cell[2]) {
+        // triangle goes to bucket once, even if several of its cells are hashed there
+        std::size_t bucket = get_bucket(cell);
+        if (last_triangle[bucket] != triangle_ind) {
+          last_triangle[bucket] = triangle_ind;
+          func(bucket);
+        }
+      }
+    }
+  }
+}
+
+template <typename T>
+template <typename func_t, typename next_func_t, typename stop_func_t>
+void spatial_hash_t<T>::for_each_overlapping_pair(
+  std::size_t num_threads,
+  func_t      func,
+  next_func_t get_next,
+  stop_func_t is_stopped
+) const {
+  parallel::for_each_chunk(std::max(num_threads, std::size_t{1}), get_num_buckets(), kChunkSize,
+    [&](std::size_t begin, std::size_t end, std::size_t thread_ind) {
+      for (std::size_t bucket = begin; bucket < end && !is_stopped(); ++bucket) {
+        const std::size_t bucket_end = bucket_begins_[bucket + 1];
+        for (std::size_t lhs_pos = bucket_begins_[bucket]; lhs_pos < bucket_end; ++lhs_pos) {
+          const std::size_t lhs_ind = entries_[lhs_pos];
+          const cell_range_t& lhs_range = cell_ranges_[lhs_ind];
+          const inflated_AABB_t<T>& lhs_box = boxes_[lhs_ind];
+          for (std::size_t rhs_pos = get_next(lhs_pos, lhs_pos + 1); rhs_pos < bucket_end;
+               rhs_pos = get_next(lhs_pos, rhs_pos + 1)) {
+            const std::size_t rhs_ind = entries_[rhs_pos];
+            const cell_range_t& rhs_range = cell_ranges_[rhs_ind];
+            if (!stats::count_AABB_test(lhs_box.does_inter(boxes_[rhs_ind]))) {
+              continue;
+            }
+
+            // overlapping boxes always share cells, the lowest of them is canonical
+            cell_t canonical_cell = {std::max(lhs_range.min_cell[0], rhs_range.min_cell[0]),
+                                     std::max(lhs_range.min_cell[1], rhs_range.min_cell[1]),
+                                     std::max(lhs_range.min_cell[2], rhs_range.min_cell[2])};
+            if (get_bucket(canonical_cell) == bucket) {
+              func(std::min(lhs_ind, rhs_ind), std::max(lhs_ind, rhs_ind), thread_ind);
+            }
+          }
+        }
+      }
+    }
+  );
+}
+
+template <typename T>
+template <typename skip_func_t>
+[[nodiscard]] std::size_t spatial_hash_t<T>::skip_entries(
+  std::size_t                            pos,
+  std::vector<std::atomic<std::size_t>>& jumps,
+  skip_func_t                            is_skipped
+) const {
+  if (pos >= entries_.size() || !is_skipped(pos)) {
+    return pos;
+  }
+
+  std::size_t cur  = pos;
+  std::size_t next = jumps[cur].load(std::memory_order_relaxed);
+  while (next < entries_.size() && is_skipped(next)) {
+    // [cur, next) and [next, after_next) are skipped, so is their union;
+    // concurrent store of a shorter jump only loses a shortcut
+    std::size_t after_next = jumps[next].load(std::memory_order_relaxed);
+    jumps[cur].store(after_next, std::memory_order_relaxed);
+    cur  = next;
+    next = after_next;
+  }
+
+  return next;
+}
+
+template <typename T>
+[[nodiscard]] std::vector<std::atomic<std::size_t>> spatial_hash_t<T>::make_jumps() const {
+  std::vector<std::atomic<std::size_t>> jumps(entries_.size());
+  for (std::size_t pos = 0; pos < entries_.size(); ++pos) {
+    jumps[pos].store(pos + 1, std::memory_order_relaxed);
+  }
+
+  return jumps;
+}
+
+template <typename T>
+void spatial_hash_t<T>::mark_self_intersections(std::size_t num_threads) {
+  // On dense scenes buckets are huge, but almost all of their triangles
+  // are marked soon, then marked lhs only walks over not marked entries.
+  std::vector<std::atomic<std::size_t>> jumps = make_jumps();
+  auto is_entry_marked = [this](std::size_t pos) { return is_marked(entries_[pos]); };
+
+  for_each_overlapping_pair(num_threads,
+    [this](std::size_t lhs_ind, std::size_t rhs_ind, std::size_t) {
+      // nothing new can be learned from a pair of marked triangles
+      if (is_marked(lhs_ind) && is_marked(rhs_ind)) {
+        stats::add(&stats::counters_t::marked_exits);
+        return;
+      }
+
+      if (triangles_[lhs_ind].does_intersect(triangles_[rhs_ind], kernel_)) {
+        visited_[lhs_ind].store(true, std::memory_order_relaxed);
+        visited_[rhs_ind].store(true, std::memory_order_relaxed);
+      }
+    },
+    [&](std::size_t lhs_pos, std::size_t pos) {
+      return is_entry_marked(lhs_pos) ? skip_entries(pos, jumps, is_entry_marked) : pos;
+    },
+    []() { return false; }
+  );
+}
+
+template <typename T>
+[[nodiscard]] std::vector<typename spatial_hash_t<T>::index_pair_t>
+spatial_hash_t<T>::find_intersecting_pairs(
+  std::size_t num_threads,
+  std::size_t max_num_pairs
+) const {
+  num_threads = std::max(num_threads, std::size_t{1});
+  std::vector<std::vector<index_pair_t>> thread_pairs(num_threads);
+  std::atomic<std::size_t> num_found{0};
+  auto is_limit_reached = [&]() {
+    return max_num_pairs != 0 && num_found.load(std::memory_order_relaxed) >= max_num_pairs;
+  };
+
+  for_each_overlapping_pair(num_threads,
+    [&](std::size_t lhs_ind, std::size_t rhs_ind, std::size_t thread_ind) {
+      if (is_limit_reached() || !triangles_[lhs_ind].does_intersect(triangles_[rhs_ind], kernel_)) {
+        return;
+      }
+
+      thread_pairs[thread_ind].emplace_back(lhs_ind, rhs_ind);
+      num_found.fetch_add(1, std::memory_order_relaxed);
+    },
+    [](std::size_t, std::size_t pos) { return pos; },
+    is_limit_reached
+  );
+
+  std::vector<index_pair_t> result;
+  for (auto& pairs : thread_pairs) {
+    result.insert(result.end(), pairs.begin(), pairs.end());
+    pairs = {};
+  }
+  std::sort(result.begin(), result.end());
+  // threads may overshoot the limit a little, before they see it's reached
+  if (max_num_pairs != 0 && result.size() > max_num_pairs) {
+    result.resize(max_num_pairs);
+  }
+
+  return result;
+}
+
+template <typename T>
+void spatial_hash_t<T>::unite_intersecting_triangles(
+  concurrent_union_find_t& components,
+  std::size_t              num_threads
+) const {
+  assert(components.get_size() == num_triangles_);
+  // on dense scenes whole bucket soon becomes one component, its runs are jumped over
+  std::vector<std::atomic<std::size_t>> jumps = make_jumps();
+
+  for_each_overlapping_pair(num_threads,
+    [&](std::size_t lhs_ind, std::size_t rhs_ind, std::size_t) {
+      // exact test is much more expensive than lookup in union find
+      if (!components.is_same(lhs_ind, rhs_ind) &&
+          triangles_[lhs_ind].does_intersect(triangles_[rhs_ind], kernel_)) {
+        components.unite(lhs_ind, rhs_ind);
+      }
+    },
+    [&](std::size_t lhs_pos, std::size_t pos) {
+      const std::size_t lhs_ind = entries_[lhs_pos];
+      return skip_entries(pos, jumps, [&](std::size_t other_pos) {
+        return components.is_same(lhs_ind, entries_[other_pos]);
+      });
+    },
+    []() { return false; }
+  );
+}
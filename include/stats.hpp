@@ -0,0 +1,177 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+
+// Counters of broad and narrow phase, they are collected only if COLLECT_STATS is defined
+// (cmake -DCOLLECT_STATS=ON), otherwise every function here is empty and costs nothing.
+// Each thread increments its own counters, they are added to the total, when thread exits,
+// so counting doesn't make threads contend for cache lines.
+namespace stats {
+#ifdef COLLECT_STATS
+  constexpr bool kIsEnabled = true;
+#else
+  constexpr bool kIsEnabled = false;
+#endif
+
+  struct counters_t {
+    // nodes of per triangle queries and pairs of nodes of self traversals
+    std::uint64_t nodes_visited  = 0;
+    std::uint64_t AABB_tests     = 0;
+    std::uint64_t AABB_hits      = 0;
+    // narrow phase tests, i.e. pairs, that passed all filters
+    std::uint64_t triangle_tests = 0;
+    std::uint64_t triangle_hits  = 0;
+    // triangles and pairs skipped, because their triangles are already marked
+    std::uint64_t marked_exits   = 0;
+    // maximum over built trees, root has depth 0
+    std::size_t   max_depth      = 0;
+
+    // BVH build phases, ms, summed over built trees
+    double prepare_time = 0; // props and boxes of triangles
+    double tree_time    = 0; // split into nodes
+    double reorder_time = 0; // triangles in leaves order
+    double batch_time   = 0; // copy of triangles for batch filters
+
+    void merge(const counters_t& other) {
+      nodes_visited  += other.nodes_visited;
+      AABB_tests     += other.AABB_tests;
+      AABB_hits      += other.AABB_hits;
+      triangle_tests += other.triangle_tests;
+      triangle_hits  += other.triangle_hits;
+      marked_exits   += other.marked_exits;
+      max_depth       = max_depth > other.max_depth ? max_depth : other.max_depth;
+      prepare_time   += other.prepare_time;
+      tree_time      += other.tree_time;
+      reorder_time   += other.reorder_time;
+      batch_time     += other.batch_time;
+    }
+  };
+
+  // counters of threads, that already exited
+  struct total_t {
+    std::mutex mutex;
+    counters_t counters;
+  };
+
+  inline total_t& get_total_storage() {
+    static total_t total;
+    return total;
+  }
+
+  class thread_counters_t {
+   public:
+    thread_counters_t() = default;
+    thread_counters_t(const thread_counters_t&) = delete;
+    thread_counters_t& operator=(const thread_counters_t&) = delete;
+
+    ~thread_counters_t() {
+      total_t& total = get_total_storage();
+      std::lock_guard<std::mutex> lock(total.mutex);
+      total.counters.merge(counters);
+    }
+
+    counters_t counters = {};
+  };
+
+  inline counters_t& get_thread_counters() {
+    thread_local thread_counters_t local;
+    return local.counters;
+  }
+
+  inline void add(std::uint64_t counters_t::* counter, std::uint64_t value = 1) {
+    if constexpr (kIsEnabled) {
+      get_thread_counters().*counter += value;
+    }
+  }
+
+  // returns does_inter, so it can wrap test in place
+  inline bool count_AABB_test(bool does_inter) {
+    if constexpr (kIsEnabled) {
+      counters_t& counters = get_thread_counters();
+      ++counters.AABB_tests;
+      counters.AABB_hits += does_inter;
+    }
+    return does_inter;
+  }
+
+  inline bool count_triangle_test(bool does_intersect) {
+    if constexpr (kIsEnabled) {
+      counters_t& counters = get_thread_counters();
+      ++counters.triangle_tests;
+      counters.triangle_hits += does_intersect;
+    }
+    return does_intersect;
+  }
+
+  inline void update_max_depth(std::size_t depth) {
+    if constexpr (kIsEnabled) {
+      counters_t& counters = get_thread_counters();
+      counters.max_depth = counters.max_depth > depth ? counters.max_depth : depth;
+    }
+  }
+
+  // adds time of its own life to phase
+  class phase_timer_t {
+   public:
+    explicit phase_timer_t(double counters_t::* phase) : phase_(phase) {
+      if constexpr (kIsEnabled) {
+        start_ = std::chrono::steady_clock::now();
+      }
+    }
+
+    phase_timer_t(const phase_timer_t&) = delete;
+    phase_timer_t& operator=(const phase_timer_t&) = delete;
+
+    ~phase_timer_t() {
+      if constexpr (kIsEnabled) {
+        auto finish = std::chrono::steady_clock::now();
+        get_thread_counters().*phase_ += std::chrono::duration<double, std::milli>(finish - start_).count();
+      }
+    }
+
+   private:
+    double counters_t::*                  phase_;
+    std::chrono::steady_clock::time_point start_ = {};
+  };
+
+  // Counters of exited threads and of the calling one. Worker threads of
+  // solutions are joined before they return, so after solving it's everything.
+  [[nodiscard]] inline counters_t get_total() {
+    counters_t result;
+    {
+      total_t& total = get_total_storage();
+      std::lock_guard<std::mutex> lock(total.mutex);
+      result = total.counters;
+    }
+    result.merge(get_thread_counters());
+    return result;
+  }
+
+  inline void reset() {
+    total_t& total = get_total_storage();
+    std::lock_guard<std::mutex> lock(total.mutex);
+    total.counters        = {};
+    get_thread_counters() = {};
+  }
+
+  inline void write_json(std::ostream& out_stream, const counters_t& counters) {
+    out_stream << "{\n"
+               << "  \"enabled\": "        << (kIsEnabled ? "true" : "false") << ",\n"
+               << "  \"nodes_visited\": "  << counters.nodes_visited  << ",\n"
+               << "  \"aabb_tests\": "     << counters.AABB_tests     << ",\n"
+               << "  \"aabb_hits\": "      << counters.AABB_hits      << ",\n"
+               << "  \"triangle_tests\": " << counters.triangle_tests << ",\n"
+               << "  \"triangle_hits\": "  << counters.triangle_hits  << ",\n"
+               << "  \"marked_exits\": "   << counters.marked_exits   << ",\n"
+               << "  \"max_depth\": "      << counters.max_depth      << ",\n"
+               << "  \"build_ms\": {"
+               << "\"prepare\": "   << counters.prepare_time
+               << ", \"tree\": "    << counters.tree_time
+               << ", \"reorder\": " << counters.reorder_time
+               << ", \"batch\": "   << counters.batch_time << "}\n"
+               << "}" << std::endl;
+  }
+};
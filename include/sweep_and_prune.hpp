@@ -0,0 +1,394 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "logLib.hpp"
+#include "parallel_for.hpp"
+#include "inflated_AABB.hpp"
+#include "prepared_triangle.hpp"
+#include "radix_sort.hpp"
+#include "stats.hpp"
+#include "union_find.hpp"
+
+// Sort-and-sweep broad phase: boxes of triangles are sorted by their lower bound
+// along the axis of the greatest spread of centers, then every box is checked
+// against the following ones, while they start before it ends. Those form
+// the active list of the box, so no tree is built at all. Works best, when
+// boxes are small compared to the spread along the axis, e.g. on flat scenes.
+template<typename T>
+class sweep_and_prune_t {
+ public:
+  using triangs_list_t = std::vector<prepared_triangle_t<T>>;
+  using indices_list_t = std::vector<std::size_t>;
+  // indices of triangles in input list, first < second
+  using index_pair_t   = std::pair<std::size_t, std::size_t>;
+
+  sweep_and_prune_t(const std::vector<triangle_t<T>>& triangles,
+                    triangle_inters_kernel_t kernel = triangle_t<T>::kDefaultInterKernel)
+      : sweep_and_prune_t(triangles.data(), triangles.size(), nullptr, kernel) {}
+
+  // boxes may be nullptr, else boxes[i] must be exactly AABB_t of triangles[i]
+  sweep_and_prune_t(const triangle_t<T>*     triangles,
+                    std::size_t              num_triangles,
+                    const AABB_t<T>*         boxes,
+                    triangle_inters_kernel_t kernel = triangle_t<T>::kDefaultInterKernel);
+
+  // Marks every triangle that intersects at least one other triangle.
+  // Sorted boxes are split into chunks, that threads take dynamically.
+  void mark_self_intersections(std::size_t num_threads = 1);
+
+  // same contract as BVH_t::find_intersecting_pairs
+  [[nodiscard]] std::vector<index_pair_t> find_intersecting_pairs(
+    std::size_t num_threads   = 1,
+    std::size_t max_num_pairs = 0
+  ) const;
+
+  // same contract as BVH_t::unite_intersecting_triangles
+  void unite_intersecting_triangles(
+    concurrent_union_find_t& components,
+    std::size_t              num_threads = 1
+  ) const;
+
+  [[nodiscard]] bool is_marked(std::size_t triangle_ind) const {
+    return visited_[position_of_[triangle_ind]].load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] utils::axis_t get_sweep_axis() const { return axis_; }
+
+ private:
+  [[nodiscard]] static utils::axis_t choose_sweep_axis(const triangs_list_t& triangles);
+
+  // float bounds, that contain [value_min, value_max], so keys are compared
+  // conservatively and radix sort works with 32-bit keys for any T
+  [[nodiscard]] static float get_key_below(T value);
+  [[nodiscard]] static float get_key_above(T value);
+
+  // Calls func(lhs_pos, rhs_pos, thread_ind) for every pair of positions in sorted order
+  // with overlapping boxes, lhs_pos < rhs_pos. Boxes are skipped as a whole once is_stopped().
+  template<typename func_t, typename stop_func_t>
+  void for_each_overlapping_pair(
+    std::size_t num_threads,
+    func_t      func,
+    stop_func_t is_stopped
+  ) const;
+
+  // first not marked position >= pos, or num_triangles_, can be called from several threads
+  [[nodiscard]] std::size_t find_unmarked(std::size_t pos);
+
+  void mark_position(std::size_t pos);
+
+  // Jumps over positions, that are in one component with pos, returns the first
+  // one after pos, that isn't, or num_triangles_. jumps[p] == q means, that all of [p, q)
+  // are in one component, it stays true forever, as components only grow.
+  [[nodiscard]] std::size_t find_other_component(
+    std::size_t                            pos,
+    std::vector<std::atomic<std::size_t>>& jumps,
+    concurrent_union_find_t&               components
+  ) const;
+
+ private:
+  // number of sorted boxes taken by thread at once
+  static const std::size_t kChunkSize = 256;
+
+ private:
+  const std::size_t              num_triangles_;
+  const triangle_inters_kernel_t kernel_;
+  utils::axis_t                  axis_ = utils::axis_t::X;
+
+  // everything below is in sorted order of lower bounds of boxes
+  triangs_list_t                  triangles_;
+  std::vector<inflated_AABB_t<T>> boxes_;
+  // bounds of boxes along the axis, kept apart, as most of the checks stop at them
+  std::vector<float>              min_keys_;
+  std::vector<float>              max_keys_;
+  // triangle_ids_[i] - index of triangles_[i] in the input list
+  indices_list_t                  triangle_ids_;
+  // position_of_[triangle_ids_[i]] == i
+  indices_list_t                  position_of_;
+  // marks of sorted positions, set from several threads
+  std::vector<std::atomic<bool>>  visited_;
+  // Used only by mark_self_intersections. Marked position points to some later one,
+  // not marked one points to itself, so runs of marked positions are jumped over
+  // with path halving, like in union find. Last one is sentinel num_triangles_.
+  std::vector<std::atomic<std::size_t>> next_unmarked_;
+};
+
+template <typename T>
+sweep_and_prune_t<T>::sweep_and_prune_t(
+  const triangle_t<T>*     triangles,
+  std::size_t              num_triangles,
+  const AABB_t<T>*         boxes,
+  triangle_inters_kernel_t kernel
+) : num_triangles_(num_triangles), kernel_(kernel), visited_(num_triangles) {
+  triangs_list_t prepared;
+  prepared.reserve(num_triangles_);
+  for (std::size_t i = 0; i < num_triangles_; ++i) {
+    if (boxes != nullptr) {
+      prepared.emplace_back(triangles[i], boxes[i]);
+    } else {
+      prepared.emplace_back(triangles[i]);
+    }
+  }
+  axis_ = choose_sweep_axis(prepared);
+
+  struct sort_item_t {
+    std::uint32_t key;
+    std::size_t   ind;
+  };
+  std::vector<sort_item_t> items(num_triangles_);
+  for (std::size_t i = 0; i < num_triangles_; ++i) {
+    inflated_AABB_t<T> box(prepared[i].get_AABB());
+    items[i] = {radix_sort::to_sortable_bits(
+                  get_key_below(box.get_min_corner().get_coord_by_axis_name(axis_))), i};
+  }
+  radix_sort::sort(items, [](const sort_item_t& item) { return item.key; });
+
+  triangles_.reserve(num_triangles_);
+  boxes_.reserve(num_triangles_);
+  min_keys_.reserve(num_triangles_);
+  max_keys_.reserve(num_triangles_);
+  triangle_ids_.reserve(num_triangles_);
+  position_of_.resize(num_triangles_);
+  for (const sort_item_t& item : items) {
+    position_of_[item.ind] = triangles_.size();
+    triangles_.push_back(prepared[item.ind]);
+    boxes_.emplace_back(prepared[item.ind].get_AABB());
+    min_keys_.push_back(get_key_below(boxes_.back().get_min_corner().get_coord_by_axis_name(axis_)));
+    max_keys_.push_back(get_key_above(boxes_.back().get_max_corner().get_coord_by_axis_name(axis_)));
+    triangle_ids_.push_back(item.ind);
+  }
+}
+
+template <typename T>
+[[nodiscard]] utils::axis_t sweep_and_prune_t<T>::choose_sweep_axis(
+  const triangs_list_t& triangles
+) {
+  if (triangles.empty()) {
+    return utils::axis_t::X;
+  }
+
+  // variance of centers, boxes overlap along the axis less often, when it's bigger
+  point_t<T> sum{0, 0, 0};
+  for (const auto& triangle : triangles) {
+    sum = sum + triangle.get_center();
+  }
+  point_t<T> mean = sum * (static_cast<T>(1) / static_cast<T>(triangles.size()));
+
+  T variance_x = 0, variance_y = 0, variance_z = 0;
+  for (const auto& triangle : triangles) {
+    point_t<T> diff = triangle.get_center() - mean;
+    variance_x += diff.x * diff.x;
+    variance_y += diff.y * diff.y;
+    variance_z += diff.z * diff.z;
+  }
+
+  if (variance_x >= variance_y && variance_x >= variance_z) {
+    return utils::axis_t::X;
+  }
+  return variance_y >= variance_z ? utils::axis_t::Y : utils::axis_t::Z;
+}
+
+template <typename T>
+[[nodiscard]] float sweep_and_prune_t<T>::get_key_below(T value) {
+  constexpr T kFloatMax = static_cast<T>(std::numeric_limits<float>::max());
+  if (value > kFloatMax) {
+    return std::numeric_limits<float>::max();
+  }
+  if (value < -kFloatMax) {
+    return -std::numeric_limits<float>::infinity();
+  }
+
+  float key = static_cast<float>(value);
+  return static_cast<T>(key) > value ? std::nextafter(key, -std::numeric_limits<float>::infinity())
+                                     : key;
+}
+
+template <typename T>
+[[nodiscard]] float sweep_and_prune_t<T>::get_key_above(T value) {
+  return -get_key_below(-value);
+}
+
+template <typename T>
+template <typename func_t, typename stop_func_t>
+void sweep_and_prune_t<T>::for_each_overlapping_pair(
+  std::size_t num_threads,
+  func_t      func,
+  stop_func_t is_stopped
+) const {
+  parallel::for_each_chunk(num_threads, num_triangles_, kChunkSize,
+    [&](std::size_t begin, std::size_t end, std::size_t thread_ind) {
+      for (std::size_t lhs_pos = begin; lhs_pos < end && !is_stopped(); ++lhs_pos) {
+        const float max_key = max_keys_[lhs_pos];
+        const inflated_AABB_t<T>& lhs_box = boxes_[lhs_pos];
+        // boxes are sorted by lower bound, the first one starting after lhs ends closes the list
+        for (std::size_t rhs_pos = lhs_pos + 1;
+             rhs_pos < num_triangles_ && min_keys_[rhs_pos] <= max_key; ++rhs_pos) {
+          if (stats::count_AABB_test(lhs_box.does_inter(boxes_[rhs_pos]))) {
+            func(lhs_pos, rhs_pos, thread_ind);
+          }
+        }
+      }
+    }
+  );
+}
+
+template <typename T>
+void sweep_and_prune_t<T>::mark_self_intersections(std::size_t num_threads) {
+  next_unmarked_ = std::vector<std::atomic<std::size_t>>(num_triangles_ + 1);
+  for (std::size_t pos = 0; pos <= num_triangles_; ++pos) {
+    next_unmarked_[pos].store(pos, std::memory_order_relaxed);
+  }
+
+  parallel::for_each_chunk(std::max(num_threads, std::size_t{1}), num_triangles_, kChunkSize,
+    [this](std::size_t begin, std::size_t end, std::size_t) {
+      for (std::size_t lhs_pos = begin; lhs_pos < end; ++lhs_pos) {
+        const float max_key = max_keys_[lhs_pos];
+        const inflated_AABB_t<T>& lhs_box = boxes_[lhs_pos];
+        const prepared_triangle_t<T>& lhs_triangle = triangles_[lhs_pos];
+        // On dense scenes active lists are long, but almost all of their boxes
+        // are marked soon, then marked lhs only walks over not marked boxes.
+        bool is_lhs_marked = visited_[lhs_pos].load(std::memory_order_relaxed);
+        for (std::size_t rhs_pos = is_lhs_marked ? find_unmarked(lhs_pos + 1) : lhs_pos + 1;
+             rhs_pos < num_triangles_ && min_keys_[rhs_pos] <= max_key;
+             rhs_pos = is_lhs_marked ? find_unmarked(rhs_pos + 1) : rhs_pos + 1) {
+          if (!stats::count_AABB_test(lhs_box.does_inter(boxes_[rhs_pos])) ||
+              !lhs_triangle.does_intersect(triangles_[rhs_pos], kernel_)) {
+            continue;
+          }
+
+          mark_position(lhs_pos);
+          mark_position(rhs_pos);
+          is_lhs_marked = true;
+        }
+      }
+    }
+  );
+}
+
+template <typename T>
+[[nodiscard]] std::size_t sweep_and_prune_t<T>::find_unmarked(std::size_t pos) {
+  while (true) {
+    std::size_t next = next_unmarked_[pos].load(std::memory_order_relaxed);
+    if (next == pos) {
+      return pos;
+    }
+
+    std::size_t after_next = next_unmarked_[next].load(std::memory_order_relaxed);
+    if (next != after_next) {
+      // fails only if someone has already moved pos further, which is fine
+      next_unmarked_[pos].compare_exchange_weak(next, after_next, std::memory_order_relaxed);
+    }
+    pos = after_next;
+  }
+}
+
+template <typename T>
+void sweep_and_prune_t<T>::mark_position(std::size_t pos) {
+  // only the thread that marks position unlinks it, others never touch pointer of not marked one
+  if (!visited_[pos].exchange(true, std::memory_order_relaxed)) {
+    next_unmarked_[pos].store(pos + 1, std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+[[nodiscard]] std::vector<typename sweep_and_prune_t<T>::index_pair_t>
+sweep_and_prune_t<T>::find_intersecting_pairs(
+  std::size_t num_threads,
+  std::size_t max_num_pairs
+) const {
+  num_threads = std::max(num_threads, std::size_t{1});
+  std::vector<std::vector<index_pair_t>> thread_pairs(num_threads);
+  std::atomic<std::size_t> num_found{0};
+  auto is_limit_reached = [&]() {
+    return max_num_pairs != 0 && num_found.load(std::memory_order_relaxed) >= max_num_pairs;
+  };
+
+  for_each_overlapping_pair(num_threads,
+    [&](std::size_t lhs_pos, std::size_t rhs_pos, std::size_t thread_ind) {
+      if (is_limit_reached() ||
+          !triangles_[lhs_pos].does_intersect(triangles_[rhs_pos], kernel_)) {
+        return;
+      }
+
+      auto [first, second] = std::minmax(triangle_ids_[lhs_pos], triangle_ids_[rhs_pos]);
+      thread_pairs[thread_ind].emplace_back(first, second);
+      num_found.fetch_add(1, std::memory_order_relaxed);
+    },
+    is_limit_reached
+  );
+
+  std::vector<index_pair_t> result;
+  for (auto& pairs : thread_pairs) {
+    result.insert(result.end(), pairs.begin(), pairs.end());
+    pairs = {};
+  }
+  std::sort(result.begin(), result.end());
+  // threads may overshoot the limit a little, before they see it's reached
+  if (max_num_pairs != 0 && result.size() > max_num_pairs) {
+    result.resize(max_num_pairs);
+  }
+
+  return result;
+}
+
+template <typename T>
+void sweep_and_prune_t<T>::unite_intersecting_triangles(
+  concurrent_union_find_t& components,
+  std::size_t              num_threads
+) const {
+  assert(components.get_size() == num_triangles_);
+  std::vector<std::atomic<std::size_t>> jumps(num_triangles_);
+  for (std::size_t pos = 0; pos < num_triangles_; ++pos) {
+    jumps[pos].store(pos + 1, std::memory_order_relaxed);
+  }
+
+  parallel::for_each_chunk(std::max(num_threads, std::size_t{1}), num_triangles_, kChunkSize,
+    [&](std::size_t begin, std::size_t end, std::size_t) {
+      for (std::size_t lhs_pos = begin; lhs_pos < end; ++lhs_pos) {
+        const float max_key = max_keys_[lhs_pos];
+        const inflated_AABB_t<T>& lhs_box = boxes_[lhs_pos];
+        const prepared_triangle_t<T>& lhs_triangle = triangles_[lhs_pos];
+        const std::size_t lhs_id = triangle_ids_[lhs_pos];
+        // on dense scenes whole active list soon becomes one component with lhs
+        std::size_t rhs_pos = lhs_pos + 1;
+        while (rhs_pos < num_triangles_ && min_keys_[rhs_pos] <= max_key) {
+          const std::size_t rhs_id = triangle_ids_[rhs_pos];
+          if (components.is_same(lhs_id, rhs_id)) {
+            rhs_pos = find_other_component(rhs_pos, jumps, components);
+            continue;
+          }
+
+          if (stats::count_AABB_test(lhs_box.does_inter(boxes_[rhs_pos])) &&
+              lhs_triangle.does_intersect(triangles_[rhs_pos], kernel_)) {
+            components.unite(lhs_id, rhs_id);
+          }
+          ++rhs_pos;
+        }
+      }
+    }
+  );
+}
+
+template <typename T>
+[[nodiscard]] std::size_t sweep_and_prune_t<T>::find_other_component(
+  std::size_t                            pos,
+  std::vector<std::atomic<std::size_t>>& jumps,
+  concurrent_union_find_t&               components
+) const {
+  std::size_t cur  = pos;
+  std::size_t next = jumps[cur].load(std::memory_order_relaxed);
+  while (next < num_triangles_ && components.is_same(triangle_ids_[pos], triangle_ids_[next])) {
+    // path splitting: [cur, next) and [next, after_next) are in one component,
+    // so is their union; concurrent store of a shorter jump only loses a shortcut
+    std::size_t after_next = jumps[next].load(std::memory_order_relaxed);
+    jumps[cur].store(after_next, std::memory_order_relaxed);
+    cur  = next;
+    next = after_next;
+  }
+
+  return next;
+}
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__)
+  #include <immintrin.h>
+  #define TRIANGLES_BATCH_X86
+#endif
+
+#include "prepared_triangle.hpp"
+
+namespace triangles_batch {
+  // Each leaf is stored as a separate block in structure of arrays layout,
+  // array k of block with stride n starts at block + k * n.
+  // Stride is number of triangles, rounded up to kLaneAlign.
+  enum arrays_t : std::size_t {
+    BOX_MIN_X, BOX_MIN_Y, BOX_MIN_Z,
+    BOX_MAX_X, BOX_MAX_Y, BOX_MAX_Z,
+    // first vertex of triangle, base of its plane
+    BASE_X,    BASE_Y,    BASE_Z,
+    // zero for degenerate triangles, so they are never rejected by plane test
+    NORM_X,    NORM_Y,    NORM_Z,
+    NUM_ARRAYS
+  };
+
+  constexpr std::size_t kLaneAlign = 4;
+
+  // triangle, that is checked against a batch
+  template<typename T>
+  struct query_t {
+    std::array<T, 3>                box_min         = {};
+    std::array<T, 3>                box_max         = {};
+    std::array<std::array<T, 3>, 3> points          = {};
+    // reject triangles, whose plane has all query points strictly on one side
+    bool                            use_plane_sides = false;
+  };
+
+  // Bit i is set if triangle begin + i of block is a candidate.
+  // begin is a multiple of kLaneAlign, end - begin <= 64,
+  // bits of padding lanes after end may be set too.
+  template<typename T>
+  using mask_func_t = std::uint64_t (*)(
+    const T* block, std::size_t stride, const query_t<T>& query,
+    std::size_t begin, std::size_t end);
+
+  // Same arithmetic as AABB_t::does_inter and first rejection of
+  // PLANE_SIDES kernel, so candidates are exactly triangles, that scalar code doesn't reject.
+  template<typename T>
+  [[nodiscard]] inline bool is_candidate(
+    const T*           block,
+    std::size_t        stride,
+    const query_t<T>&  query,
+    std::size_t        pos
+  ) {
+    auto get = [&](std::size_t array_ind) { return block[array_ind * stride + pos]; };
+
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+      if (utils::sign(get(BOX_MIN_X + axis) - query.box_max[axis]) == utils::signs_t::POS ||
+          utils::sign(get(BOX_MAX_X + axis) - query.box_min[axis]) == utils::signs_t::NEG) {
+        return false;
+      }
+    }
+
+    if (!query.use_plane_sides) {
+      return true;
+    }
+
+    std::array<utils::signs_t, 3> sides = {};
+    for (std::size_t i = 0; i < 3; ++i) {
+      const std::array<T, 3>& point = query.points[i];
+      sides[i] = utils::sign((point[0] - get(BASE_X)) * get(NORM_X) +
+                             (point[1] - get(BASE_Y)) * get(NORM_Y) +
+                             (point[2] - get(BASE_Z)) * get(NORM_Z));
+    }
+
+    return sides[0] == utils::signs_t::ZERO || sides[0] != sides[1] || sides[0] != sides[2];
+  }
+
+  template<typename T>
+  [[nodiscard]] inline std::uint64_t get_mask_scalar(
+    const T*           block,
+    std::size_t        stride,
+    const query_t<T>&  query,
+    std::size_t        begin,
+    std::size_t        end
+  ) {
+    std::uint64_t mask = 0;
+    for (std::size_t pos = begin; pos < end; ++pos) {
+      if (is_candidate(block, stride, query, pos)) {
+        mask |= std::uint64_t{1} << (pos - begin);
+      }
+    }
+
+    return mask;
+  }
+
+#ifdef TRIANGLES_BATCH_X86
+  // 2 triangles per step, SSE2 is present on every x86-64 cpu
+  [[nodiscard]] inline std::uint64_t get_mask_sse2(
+    const double*           block,
+    std::size_t             stride,
+    const query_t<double>&  query,
+    std::size_t             begin,
+    std::size_t             end
+  ) {
+    constexpr double kEPS = utils::float_traits<double>::kEPS;
+    const __m128d eps     = _mm_set1_pd( kEPS);
+    const __m128d neg_eps = _mm_set1_pd(-kEPS);
+    auto load = [&](std::size_t array_ind, std::size_t pos) {
+      return _mm_loadu_pd(block + array_ind * stride + pos);
+    };
+
+    std::uint64_t mask = 0;
+    std::size_t pos = begin;
+    // lanes are padded up to kLaneAlign, so there is no tail
+    for (; pos < end; pos += 2) {
+      __m128d rejected = _mm_setzero_pd();
+      for (std::size_t axis = 0; axis < 3; ++axis) {
+        __m128d min_diff = _mm_sub_pd(load(BOX_MIN_X + axis, pos), _mm_set1_pd(query.box_max[axis]));
+        __m128d max_diff = _mm_sub_pd(load(BOX_MAX_X + axis, pos), _mm_set1_pd(query.box_min[axis]));
+        rejected = _mm_or_pd(rejected, _mm_cmpgt_pd(min_diff, eps));
+        rejected = _mm_or_pd(rejected, _mm_cmplt_pd(max_diff, neg_eps));
+      }
+
+      // plane distances are needed only if some box overlaps
+      if (query.use_plane_sides && _mm_movemask_pd(rejected) != 0b11) {
+        __m128d all_pos = _mm_castsi128_pd(_mm_set1_epi64x(-1));
+        __m128d all_neg = all_pos;
+        for (const auto& point : query.points) {
+          __m128d dist = _mm_setzero_pd();
+          for (std::size_t axis = 0; axis < 3; ++axis) {
+            __m128d diff = _mm_sub_pd(_mm_set1_pd(point[axis]), load(BASE_X + axis, pos));
+            __m128d prod = _mm_mul_pd(diff, load(NORM_X + axis, pos));
+            dist = axis == 0 ? prod : _mm_add_pd(dist, prod);
+          }
+          all_pos = _mm_and_pd(all_pos, _mm_cmpgt_pd(dist, eps));
+          all_neg = _mm_and_pd(all_neg, _mm_cmplt_pd(dist, neg_eps));
+        }
+        rejected = _mm_or_pd(rejected, _mm_or_pd(all_pos, all_neg));
+      }
+
+      auto bits = static_cast<std::uint64_t>(~_mm_movemask_pd(rejected) & 0b11);
+      mask |= bits << (pos - begin);
+    }
+
+    return mask;
+  }
+
+  __attribute__((target("avx2")))
+  [[nodiscard]] inline __m256d load_avx2(
+    const double* block,
+    std::size_t   stride,
+    std::size_t   array_ind,
+    std::size_t   pos
+  ) {
+    return _mm256_loadu_pd(block + array_ind * stride + pos);
+  }
+
+  // 4 triangles per step
+  __attribute__((target("avx2")))
+  [[nodiscard]] inline std::uint64_t get_mask_avx2(
+    const double*           block,
+    std::size_t             stride,
+    const query_t<double>&  query,
+    std::size_t             begin,
+    std::size_t             end
+  ) {
+    constexpr double kEPS = utils::float_traits<double>::kEPS;
+    const __m256d eps     = _mm256_set1_pd( kEPS);
+    const __m256d neg_eps = _mm256_set1_pd(-kEPS);
+
+    std::uint64_t mask = 0;
+    std::size_t pos = begin;
+    for (; pos < end; pos += 4) {
+      __m256d rejected = _mm256_setzero_pd();
+      for (std::size_t axis = 0; axis < 3; ++axis) {
+        __m256d min_diff = _mm256_sub_pd(load_avx2(block, stride, BOX_MIN_X + axis, pos),
+                                         _mm256_set1_pd(query.box_max[axis]));
+        __m256d max_diff = _mm256_sub_pd(load_avx2(block, stride, BOX_MAX_X + axis, pos),
+                                         _mm256_set1_pd(query.box_min[axis]));
+        rejected = _mm256_or_pd(rejected, _mm256_cmp_pd(min_diff, eps,     _CMP_GT_OQ));
+        rejected = _mm256_or_pd(rejected, _mm256_cmp_pd(max_diff, neg_eps, _CMP_LT_OQ));
+      }
+
+      if (query.use_plane_sides && _mm256_movemask_pd(rejected) != 0b1111) {
+        __m256d all_pos = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        __m256d all_neg = all_pos;
+        for (const auto& point : query.points) {
+          __m256d dist = _mm256_setzero_pd();
+          for (std::size_t axis = 0; axis < 3; ++axis) {
+            __m256d diff = _mm256_sub_pd(_mm256_set1_pd(point[axis]),
+                                         load_avx2(block, stride, BASE_X + axis, pos));
+            __m256d prod = _mm256_mul_pd(diff, load_avx2(block, stride, NORM_X + axis, pos));
+            dist = axis == 0 ? prod : _mm256_add_pd(dist, prod);
+          }
+          all_pos = _mm256_and_pd(all_pos, _mm256_cmp_pd(dist, eps,     _CMP_GT_OQ));
+          all_neg = _mm256_and_pd(all_neg, _mm256_cmp_pd(dist, neg_eps, _CMP_LT_OQ));
+        }
+        rejected = _mm256_or_pd(rejected, _mm256_or_pd(all_pos, all_neg));
+      }
+
+      auto bits = static_cast<std::uint64_t>(~_mm256_movemask_pd(rejected) & 0b1111);
+      mask |= bits << (pos - begin);
+    }
+
+    return mask;
+  }
+#endif
+
+  // chooses the widest kernel, supported by cpu we run on
+  template<typename T>
+  [[nodiscard]] inline mask_func_t<T> select_mask_func() {
+#ifdef TRIANGLES_BATCH_X86
+    if constexpr (std::is_same_v<T, double>) {
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2")) {
+        return &get_mask_avx2;
+      }
+
+      return &get_mask_sse2;
+    }
+#endif
+
+    return &get_mask_scalar<T>;
+  }
+};
+
+// Copy of triangles in structure of arrays layout, so one query
+// triangle is checked against several triangles by one instruction.
+// Triangles are split into leaves, each leaf is a contiguous block of memory.
+// It only filters candidates, exact test is still done by prepared_triangle_t.
+template<typename T>
+class triangles_batch_t {
+ public:
+  using query_t     = triangles_batch::query_t<T>;
+  using mask_func_t = triangles_batch::mask_func_t<T>;
+
+  triangles_batch_t() = default;
+
+  // leaf i is [leaf_begins[i], leaf_begins[i + 1]), last one ends with triangles
+  triangles_batch_t(
+    const std::vector<prepared_triangle_t<T>>& triangles,
+    const std::vector<std::size_t>&            leaf_begins,
+    mask_func_t                                get_mask = triangles_batch::select_mask_func<T>()
+  );
+
+  [[nodiscard]] static query_t make_query(
+    const prepared_triangle_t<T>& triangle,
+    triangle_inters_kernel_t      kernel
+  );
+
+  // Calls func(pos) for every triangle from [begin, end), that may intersect query,
+  // in increasing order. Stops and returns true as soon as func returns true.
+  // Range must lie inside one leaf.
+  template<typename func_t>
+  bool for_each_candidate(
+    const query_t& query,
+    std::size_t    begin,
+    std::size_t    end,
+    func_t         func
+  ) const;
+
+ private:
+  // Lanes filtered by one kernel call. Small chunks, so any hit queries
+  // don't pay for filtering the whole leaf before the first hit.
+  static constexpr std::size_t kChunkSize = 2 * triangles_batch::kLaneAlign;
+
+  struct block_t {
+    std::size_t first_pos   = 0;
+    std::size_t data_offset = 0;
+    std::size_t stride      = 0;
+  };
+
+ private:
+  std::vector<T>           data_         = {};
+  std::vector<block_t>     blocks_       = {};
+  // index of block (i.e. leaf), containing triangle
+  std::vector<std::size_t> block_of_pos_ = {};
+  mask_func_t              get_mask_     = &triangles_batch::get_mask_scalar<T>;
+};
+
+template<typename T>
+triangles_batch_t<T>::triangles_batch_t(
+  const std::vector<prepared_triangle_t<T>>& triangles,
+  const std::vector<std::size_t>&            leaf_begins,
+  mask_func_t                                get_mask
+) : block_of_pos_(triangles.size()),
+    get_mask_(get_mask) {
+  using namespace triangles_batch;
+
+  blocks_.reserve(leaf_begins.size());
+  for (std::size_t leaf_ind = 0; leaf_ind < leaf_begins.size(); ++leaf_ind) {
+    std::size_t begin = leaf_begins[leaf_ind];
+    std::size_t end   = leaf_ind + 1 < leaf_begins.size() ? leaf_begins[leaf_ind + 1] : triangles.size();
+    assert(begin <= end);
+
+    // padding lanes stay zero, their bits are never reported
+    block_t block = {begin, data_.size(), (end - begin + kLaneAlign - 1) / kLaneAlign * kLaneAlign};
+    blocks_.push_back(block);
+    data_.resize(data_.size() + NUM_ARRAYS * block.stride);
+
+    T* block_data = data_.data() + block.data_offset;
+    for (std::size_t pos = begin; pos < end; ++pos) {
+      block_of_pos_[pos] = leaf_ind;
+
+      std::size_t lane = pos - begin;
+      auto set = [&](std::size_t array_ind, const point_t<T>& point) {
+        block_data[(array_ind + 0) * block.stride + lane] = point.x;
+        block_data[(array_ind + 1) * block.stride + lane] = point.y;
+        block_data[(array_ind + 2) * block.stride + lane] = point.z;
+      };
+
+      const prepared_triangle_t<T>& triangle = triangles[pos];
+      AABB_t<T> box = triangle.get_AABB();
+      set(BOX_MIN_X, box.get_min_corner());
+      set(BOX_MAX_X, box.get_max_corner());
+      set(BASE_X,    triangle.get_triangle().get_points()[0]);
+
+      const triangle_props_t<T>& props = triangle.get_props();
+      set(NORM_X, props.is_degenerate() ? point_t<T>{} : props.norm);
+    }
+  }
+}
+
+template<typename T>
+[[nodiscard]] typename triangles_batch_t<T>::query_t triangles_batch_t<T>::make_query(
+  const prepared_triangle_t<T>& triangle,
+  triangle_inters_kernel_t      kernel
+) {
+  query_t query;
+  AABB_t<T> box = triangle.get_AABB();
+  query.box_min = {box.get_min_corner().x, box.get_min_corner().y, box.get_min_corner().z};
+  query.box_max = {box.get_max_corner().x, box.get_max_corner().y, box.get_max_corner().z};
+
+  std::array<point_t<T>, 3> points = triangle.get_triangle().get_points();
+  for (std::size_t i = 0; i < 3; ++i) {
+    query.points[i] = {points[i].x, points[i].y, points[i].z};
+  }
+
+  // degenerate triangles are tested by EDGES kernel, which has no such rejection
+  query.use_plane_sides = kernel == triangle_inters_kernel_t::PLANE_SIDES &&
+                          !triangle.get_props().is_degenerate();
+  return query;
+}
+
+template<typename T>
+template<typename func_t>
+bool triangles_batch_t<T>::for_each_candidate(
+  const query_t& query,
+  std::size_t    begin,
+  std::size_t    end,
+  func_t         func
+) const {
+  if (begin >= end) {
+    return false;
+  }
+
+  const block_t& block = blocks_[block_of_pos_[begin]];
+  assert(end - block.first_pos <= block.stride);
+  const T* block_data = data_.data() + block.data_offset;
+
+  const std::size_t lane_begin = begin - block.first_pos;
+  const std::size_t lane_end   = end   - block.first_pos;
+  // kernels start from aligned lane, lanes before lane_begin are dropped
+  for (std::size_t chunk_begin = lane_begin / triangles_batch::kLaneAlign * triangles_batch::kLaneAlign;
+       chunk_begin < lane_end; chunk_begin += kChunkSize) {
+    std::size_t chunk_end = std::min(chunk_begin + kChunkSize, lane_end);
+    std::uint64_t mask = get_mask_(block_data, block.stride, query, chunk_begin, chunk_end);
+    if (chunk_begin < lane_begin) {
+      mask &= ~std::uint64_t{0} << (lane_begin - chunk_begin);
+    }
+    if (chunk_end - chunk_begin < kChunkSize) {
+      mask &= (std::uint64_t{1} << (chunk_end - chunk_begin)) - 1;
+    }
+
+    while (mask != 0) {
+      std::size_t lane = chunk_begin + static_cast<std::size_t>(__builtin_ctzll(mask));
+      mask &= mask - 1;
+      if (func(block.first_pos + lane)) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
@@ -0,0 +1,339 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+  #define TRIANGLES_BINARY_MMAP
+#endif
+
+#include "AABB.hpp"
+#include "triangle.hpp"
+#include "triangles_input.hpp"
+
+// Binary triangle soup, so archived scenes are loaded without text parsing.
+// Layout, all numbers are little-endian:
+//   header_t, 64 bytes
+//   coordinates at coords_offset: 9 scalars per triangle, x, y, z of a, then of b, then of c
+//   boxes at boxes_offset, if HAS_BOXES flag is set: 6 scalars per triangle,
+//   min corner, then max corner, exactly as AABB_t built from the triangle;
+//   file, where some box doesn't contain its triangle, is rejected as malformed
+// Both arrays start at offsets aligned to kDataAlign, so mapped file is used in place.
+namespace triangles_binary {
+  static_assert(
+#if defined(__BYTE_ORDER__)
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+#else
+    true,
+#endif
+    "binary triangles format is read and written only on little-endian hosts");
+
+  constexpr std::uint32_t kVersion   = 1;
+  constexpr std::size_t   kDataAlign = 64;
+  constexpr char          kMagic[8]  = {'T', 'R', 'I', 'S', 'O', 'U', 'P', '\0'};
+
+  enum class scalar_type_t : std::uint32_t {
+    FLOAT32 = 1,
+    FLOAT64 = 2
+  };
+
+  enum flags_t : std::uint32_t {
+    HAS_BOXES = 1u << 0
+  };
+
+  struct header_t {
+    char          magic[8]      = {};
+    std::uint32_t version       = kVersion;
+    scalar_type_t scalar_type   = scalar_type_t::FLOAT64;
+    std::uint64_t num_triangles = 0;
+    std::uint32_t flags         = 0;
+    std::uint32_t reserved0     = 0;
+    std::uint64_t coords_offset = 0;
+    // 0 if there are no boxes
+    std::uint64_t boxes_offset  = 0;
+    std::uint8_t  reserved1[16] = {};
+  };
+  static_assert(sizeof(header_t) == 64 && std::is_trivially_copyable_v<header_t>);
+
+  template<typename T>
+  [[nodiscard]] constexpr scalar_type_t get_scalar_type() {
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>,
+                  "binary triangles format stores only float and double");
+    return std::is_same_v<T, float> ? scalar_type_t::FLOAT32 : scalar_type_t::FLOAT64;
+  }
+
+  [[nodiscard]] inline std::size_t get_scalar_size(scalar_type_t scalar_type) {
+    return scalar_type == scalar_type_t::FLOAT32 ? sizeof(float) : sizeof(double);
+  }
+
+  // triangle_t and AABB_t are plain arrays of scalars, so file data is viewed as them
+  template<typename T>
+  constexpr bool kIsLayoutCompatible =
+    sizeof(triangle_t<T>) == 9 * sizeof(T) && std::is_standard_layout_v<triangle_t<T>> &&
+    std::is_trivially_copyable_v<triangle_t<T>> &&
+    sizeof(AABB_t<T>) == 6 * sizeof(T) && std::is_standard_layout_v<AABB_t<T>> &&
+    std::is_trivially_copyable_v<AABB_t<T>>;
+
+  [[nodiscard]] inline bool has_magic(std::string_view data) {
+    return data.size() >= sizeof(kMagic) && std::memcmp(data.data(), kMagic, sizeof(kMagic)) == 0;
+  }
+
+  // Box, that doesn't contain its triangle, makes broad phase drop real intersections.
+  // Checks are negated, so NaN in box or in triangle fails too.
+  template<typename T>
+  [[nodiscard]] bool does_box_contain(const AABB_t<T>& box, const triangle_t<T>& triangle) {
+    const point_t<T> min = box.get_min_corner();
+    const point_t<T> max = box.get_max_corner();
+    for (const point_t<T>& point : triangle.get_points()) {
+      if (!(min.x <= point.x && point.x <= max.x &&
+            min.y <= point.y && point.y <= max.y &&
+            min.z <= point.z && point.z <= max.z)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // triangles of file in place, boxes is nullptr if file has none
+  template<typename T>
+  struct view_t {
+    const triangle_t<T>* triangles     = nullptr;
+    const AABB_t<T>*     boxes         = nullptr;
+    std::size_t          num_triangles = 0;
+  };
+
+  // Checks header, bounds of data and stored boxes, throws std::invalid_argument on malformed file.
+  // Returns view only if scalar type of file is T, else all pointers are nullptr
+  // and header tells what is stored.
+  template<typename T>
+  [[nodiscard]] view_t<T> get_view(std::string_view data, header_t& header) {
+    static_assert(kIsLayoutCompatible<T>);
+    if (data.size() < sizeof(header_t) || !has_magic(data)) {
+      throw std::invalid_argument("Error: not a binary triangles file");
+    }
+
+    std::memcpy(&header, data.data(), sizeof(header_t));
+    if (header.version != kVersion) {
+      throw std::invalid_argument(
+        "Error: unsupported binary triangles version " + std::to_string(header.version));
+    }
+    if (header.scalar_type != scalar_type_t::FLOAT32 &&
+        header.scalar_type != scalar_type_t::FLOAT64) {
+      throw std::invalid_argument("Error: unknown scalar type in binary triangles file");
+    }
+
+    const std::size_t scalar_size = get_scalar_size(header.scalar_type);
+    auto check_array = [&](std::uint64_t offset, std::size_t num_scalars, const char* name) {
+      // division instead of multiplication, so huge counts can't overflow
+      bool is_ok = offset % scalar_size == 0 && offset >= sizeof(header_t) && offset <= data.size() &&
+                   header.num_triangles <= (data.size() - offset) / scalar_size / num_scalars;
+      if (!is_ok) {
+        throw std::invalid_argument(
+          std::string("Error: ") + name + " of binary triangles file are out of its bounds");
+      }
+    };
+    check_array(header.coords_offset, 9, "coordinates");
+    const bool has_boxes = (header.flags & HAS_BOXES) != 0;
+    if (has_boxes) {
+      check_array(header.boxes_offset, 6, "boxes");
+    }
+
+    view_t<T> view;
+    if (header.scalar_type != get_scalar_type<T>()) {
+      return view;
+    }
+
+    view.num_triangles = header.num_triangles;
+    view.triangles = reinterpret_cast<const triangle_t<T>*>(data.data() + header.coords_offset);
+    if (has_boxes) {
+      view.boxes = reinterpret_cast<const AABB_t<T>*>(data.data() + header.boxes_offset);
+      for (std::size_t i = 0; i < view.num_triangles; ++i) {
+        if (!does_box_contain(view.boxes[i], view.triangles[i])) {
+          throw std::invalid_argument(
+            "Error: box of triangle " + std::to_string(i) + " in binary triangles file doesn't contain it");
+        }
+      }
+    }
+
+    return view;
+  }
+
+  // Copy of triangles of binary triangles file, converted to T.
+  // Used for files of other scalar type, which can't be viewed in place.
+  template<typename T>
+  [[nodiscard]] std::vector<triangle_t<T>> copy_triangles(std::string_view data) {
+    header_t header;
+    std::vector<triangle_t<T>> result;
+    auto append = [&](const auto& view) {
+      for (std::size_t i = 0; i < view.num_triangles; ++i) {
+        auto points = view.triangles[i].get_points();
+        std::array<point_t<T>, 3> converted;
+        for (std::size_t j = 0; j < 3; ++j) {
+          converted[j] = {static_cast<T>(points[j].x), static_cast<T>(points[j].y),
+                          static_cast<T>(points[j].z)};
+        }
+        result.emplace_back(converted[0], converted[1], converted[2]);
+      }
+    };
+
+    // only view of the stored scalar type is not empty
+    append(get_view<float>(data, header));
+    append(get_view<double>(data, header));
+    return result;
+  }
+
+  // Copy of triangles of text or binary triangles file, where own vector is needed.
+  // Throws std::invalid_argument on malformed input.
+  template<typename T>
+  [[nodiscard]] std::vector<triangle_t<T>> read_file(const std::string& path);
+
+  // Writes triangles as a binary triangles file of scalar type T.
+  // Boxes are computed and stored if with_boxes is set.
+  template<typename T, typename U>
+  void write(std::ostream& out_stream, const std::vector<triangle_t<U>>& triangles, bool with_boxes) {
+    static_assert(kIsLayoutCompatible<T>);
+    auto round_up = [](std::uint64_t offset) {
+      return (offset + kDataAlign - 1) / kDataAlign * kDataAlign;
+    };
+
+    // boxes are computed from converted coordinates, so they are exactly what reader would get
+    std::vector<triangle_t<T>> converted;
+    converted.reserve(triangles.size());
+    for (const auto& triangle : triangles) {
+      std::array<point_t<U>, 3> points = triangle.get_points();
+      auto convert = [](const point_t<U>& point) {
+        return point_t<T>{static_cast<T>(point.x), static_cast<T>(point.y), static_cast<T>(point.z)};
+      };
+      converted.emplace_back(convert(points[0]), convert(points[1]), convert(points[2]));
+    }
+
+    header_t header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.scalar_type   = get_scalar_type<T>();
+    header.num_triangles = converted.size();
+    header.coords_offset = round_up(sizeof(header_t));
+    if (with_boxes) {
+      header.flags        |= HAS_BOXES;
+      header.boxes_offset  = round_up(header.coords_offset + converted.size() * sizeof(triangle_t<T>));
+    }
+
+    std::uint64_t written = 0;
+    auto write_at = [&](std::uint64_t offset, const void* data, std::size_t size) {
+      std::vector<char> padding(offset - written, 0);
+      out_stream.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+      out_stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+      written = offset + size;
+    };
+
+    write_at(0, &header, sizeof(header));
+    write_at(header.coords_offset, converted.data(), converted.size() * sizeof(triangle_t<T>));
+    if (with_boxes) {
+      std::vector<AABB_t<T>> boxes(converted.begin(), converted.end());
+      write_at(header.boxes_offset, boxes.data(), boxes.size() * sizeof(AABB_t<T>));
+    }
+
+    if (!out_stream) {
+      throw std::runtime_error("Error: failed to write binary triangles file");
+    }
+  }
+
+  // Whole file in memory: mapped where mmap is available, read into a buffer elsewhere.
+  // Throws std::invalid_argument if file can't be opened.
+  class mapped_file_t {
+   public:
+    mapped_file_t() = default;
+    explicit mapped_file_t(const std::string& path);
+
+    mapped_file_t(const mapped_file_t& other) = delete;
+    mapped_file_t& operator=(const mapped_file_t& other) = delete;
+    mapped_file_t(mapped_file_t&& other) noexcept { swap(other); }
+    mapped_file_t& operator=(mapped_file_t&& other) noexcept {
+      mapped_file_t moved(std::move(other));
+      swap(moved);
+      return *this;
+    }
+
+    ~mapped_file_t();
+
+    [[nodiscard]] std::string_view get_data() const { return {data_, size_}; }
+
+   private:
+    void swap(mapped_file_t& other) noexcept {
+      std::swap(data_,      other.data_);
+      std::swap(size_,      other.size_);
+      std::swap(is_mapped_, other.is_mapped_);
+      std::swap(buffer_,    other.buffer_);
+    }
+
+   private:
+    const char*       data_      = nullptr;
+    std::size_t       size_      = 0;
+    bool              is_mapped_ = false;
+    std::vector<char> buffer_;
+  };
+
+  inline mapped_file_t::mapped_file_t(const std::string& path) {
+#ifdef TRIANGLES_BINARY_MMAP
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+      throw std::invalid_argument("Error: can't open file \"" + path + "\"");
+    }
+
+    struct stat file_stat = {};
+    if (::fstat(file, &file_stat) == 0 && S_ISREG(file_stat.st_mode) && file_stat.st_size > 0) {
+      size_ = static_cast<std::size_t>(file_stat.st_size);
+      void* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+      if (mapped != MAP_FAILED) {
+        data_      = static_cast<const char*>(mapped);
+        is_mapped_ = true;
+      }
+    }
+    ::close(file);
+    if (is_mapped_) {
+      return;
+    }
+#endif
+
+    // not a regular file, or mmap is not available
+    std::ifstream in_stream(path, std::ios::binary);
+    if (!in_stream) {
+      throw std::invalid_argument("Error: can't open file \"" + path + "\"");
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(in_stream), std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+  }
+
+  inline mapped_file_t::~mapped_file_t() {
+#ifdef TRIANGLES_BINARY_MMAP
+    if (is_mapped_) {
+      ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+  }
+
+  template<typename T>
+  [[nodiscard]] std::vector<triangle_t<T>> read_file(const std::string& path) {
+    mapped_file_t file(path);
+    if (has_magic(file.get_data())) {
+      return copy_triangles<T>(file.get_data());
+    }
+
+    auto parsed = triangles_input::parse_coords<T>(file.get_data());
+    return triangles_input::make_triangles(parsed.coords.data(), parsed.num_triangles);
+  }
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "triangle.hpp"
+
+// Bulk reader of text input: number of triangles, then 9 coordinates per triangle,
+// separated by any whitespace. Whole input is read at once and parsed with
+// std::from_chars, which is several times faster than operator>> on streams.
+namespace triangles_input {
+  constexpr std::size_t kCoordsPerTriangle = 9;
+
+  // every triangle is 9 consecutive coordinates: x, y, z of a, then of b, then of c
+  template<typename T>
+  struct coords_t {
+    std::size_t    num_triangles = 0;
+    std::vector<T> coords;
+  };
+
+  // reads by big blocks straight from stream buffer, not symbol by symbol
+  [[nodiscard]] inline std::string read_all(std::istream& in_stream) {
+    constexpr std::size_t kBlockSize = 1 << 20;
+    std::string text;
+    std::streambuf* buffer = in_stream.rdbuf();
+    while (true) {
+      std::size_t old_size = text.size();
+      text.resize(old_size + kBlockSize);
+      std::streamsize num_read = buffer->sgetn(text.data() + old_size, kBlockSize);
+      text.resize(old_size + static_cast<std::size_t>(num_read));
+      // pipe may give less than asked before its end, so only empty read means end
+      if (num_read <= 0) {
+        break;
+      }
+    }
+
+    return text;
+  }
+
+  // position in text, line is counted for error messages
+  class cursor_t {
+   public:
+    explicit cursor_t(std::string_view text) : text_(text) {}
+
+    // returns false at the end of text
+    bool skip_spaces() {
+      for (; pos_ < text_.size(); ++pos_) {
+        char symbol = text_[pos_];
+        if (symbol == '\n') {
+          ++line_;
+        } else if (symbol != ' ' && symbol != '\t' && symbol != '\r' &&
+                   symbol != '\v' && symbol != '\f') {
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    // Returns false if there is no number of type U at current position,
+    // position is not moved then.
+    template<typename U>
+    [[nodiscard]] bool parse_number(U& number) {
+      if (!skip_spaces()) {
+        return false;
+      }
+
+      const char* begin = text_.data() + pos_;
+      const char* end   = text_.data() + text_.size();
+      // from_chars doesn't accept leading plus, but operator>> does
+      if (*begin == '+' && end - begin > 1 && *(begin + 1) != '-') {
+        ++begin;
+      }
+
+      auto [number_end, error_code] = std::from_chars(begin, end, number);
+      bool is_ok = error_code == std::errc{} && (number_end == end || is_space(*number_end));
+      if constexpr (std::is_floating_point_v<U>) {
+        is_ok = is_ok && std::isfinite(number);
+      }
+
+      if (is_ok) {
+        pos_ = static_cast<std::size_t>(number_end - text_.data());
+      }
+      return is_ok;
+    }
+
+    // error about token at current position, which isn't what was expected
+    [[nodiscard]] std::invalid_argument unexpected_token_error(const std::string& expected) {
+      if (!skip_spaces()) {
+        return error("expected " + expected + ", got end of input");
+      }
+
+      return error("expected " + expected + ", got \"" + std::string(get_token()) + "\"");
+    }
+
+    [[nodiscard]] std::size_t get_num_left() const { return text_.size() - pos_; }
+
+    [[nodiscard]] std::invalid_argument error(const std::string& message) const {
+      return std::invalid_argument("Error: line " + std::to_string(line_) + ": " + message);
+    }
+
+   private:
+    [[nodiscard]] static bool is_space(char symbol) {
+      return symbol == ' '  || symbol == '\t' || symbol == '\n' ||
+             symbol == '\r' || symbol == '\v' || symbol == '\f';
+    }
+
+    [[nodiscard]] std::string_view get_token() const {
+      std::size_t token_end = pos_;
+      while (token_end < text_.size() && !is_space(text_[token_end])) {
+        ++token_end;
+      }
+
+      return text_.substr(pos_, token_end - pos_);
+    }
+
+   private:
+    std::string_view text_;
+    std::size_t      pos_  = 0;
+    std::size_t      line_ = 1;
+  };
+
+  // Throws std::invalid_argument with line number on malformed input.
+  // Anything after the last declared triangle is ignored, as operator>> did.
+  template<typename T>
+  [[nodiscard]] coords_t<T> parse_coords(std::string_view text) {
+    cursor_t cursor(text);
+    coords_t<T> result;
+    if (!cursor.parse_number(result.num_triangles)) {
+      throw cursor.unexpected_token_error("number of triangles");
+    }
+
+    // each coordinate takes at least one symbol and one separator,
+    // so absurd count is reported before buffer is allocated
+    if (result.num_triangles > (cursor.get_num_left() / 2 + 1) / kCoordsPerTriangle) {
+      throw cursor.error(
+        std::to_string(result.num_triangles) + " triangles declared, but input is too short");
+    }
+
+    result.coords.resize(result.num_triangles * kCoordsPerTriangle);
+    for (std::size_t i = 0; i < result.coords.size(); ++i) {
+      if (!cursor.parse_number(result.coords[i])) {
+        throw cursor.unexpected_token_error(
+          "coordinate of triangle " + std::to_string(i / kCoordsPerTriangle));
+      }
+    }
+
+    return result;
+  }
+
+  template<typename T>
+  [[nodiscard]] std::vector<triangle_t<T>> make_triangles(const T* coords, std::size_t num_triangles) {
+    std::vector<triangle_t<T>> triangles;
+    triangles.reserve(num_triangles);
+    for (std::size_t i = 0; i < num_triangles; ++i, coords += kCoordsPerTriangle) {
+      triangles.emplace_back(point_t<T>{coords[0], coords[1], coords[2]},
+                             point_t<T>{coords[3], coords[4], coords[5]},
+                             point_t<T>{coords[6], coords[7], coords[8]});
+    }
+
+    return triangles;
+  }
+
+  // reads the whole stream, throws std::invalid_argument on malformed input
+  template<typename T>
+  [[nodiscard]] std::vector<triangle_t<T>> read_triangles(std::istream& in_stream) {
+    coords_t<T> parsed = parse_coords<T>(read_all(in_stream));
+    return make_triangles(parsed.coords.data(), parsed.num_triangles);
+  }
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+// Disjoint sets of indices [0, n), that can be united from several threads at once
+// without locks. Roots are linked by index order, so no cycles appear even under races,
+// and finds shorten paths by halving with compare-and-swap.
+class concurrent_union_find_t {
+ public:
+  concurrent_union_find_t() = default;
+
+  explicit concurrent_union_find_t(std::size_t size) : parents_(size) {
+    for (std::size_t i = 0; i < size; ++i) {
+      parents_[i].store(i, std::memory_order_relaxed);
+    }
+  }
+
+  [[nodiscard]] std::size_t get_size() const { return parents_.size(); }
+
+  // root may change right after return, if another thread unites
+  [[nodiscard]] std::size_t find(std::size_t ind) {
+    while (true) {
+      std::size_t parent = parents_[ind].load(std::memory_order_relaxed);
+      if (parent == ind) {
+        return ind;
+      }
+
+      std::size_t grandparent = parents_[parent].load(std::memory_order_relaxed);
+      if (parent != grandparent) {
+        // fails only if someone has already moved ind higher, which is fine
+        parents_[ind].compare_exchange_weak(parent, grandparent, std::memory_order_relaxed);
+      }
+      ind = grandparent;
+    }
+  }
+
+  // exact at the moment of return: once in one set, indices stay in one set
+  [[nodiscard]] bool is_same(std::size_t lhs, std::size_t rhs) {
+    while (true) {
+      lhs = find(lhs);
+      rhs = find(rhs);
+      if (lhs == rhs) {
+        return true;
+      }
+
+      // lhs is still a root, so sets were really different at this moment
+      if (parents_[lhs].load(std::memory_order_relaxed) == lhs) {
+        return false;
+      }
+    }
+  }
+
+  // returns false if indices were already in one set
+  bool unite(std::size_t lhs, std::size_t rhs) {
+    while (true) {
+      lhs = find(lhs);
+      rhs = find(rhs);
+      if (lhs == rhs) {
+        return false;
+      }
+
+      // bigger root goes under smaller one
+      if (lhs < rhs) {
+        std::swap(lhs, rhs);
+      }
+      std::size_t expected = lhs;
+      if (parents_[lhs].compare_exchange_strong(expected, rhs, std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+  }
+
+  // Id of each index is the smallest index of its set. Call only when nobody unites.
+  [[nodiscard]] std::vector<std::size_t> get_set_ids() {
+    std::vector<std::size_t> ids(parents_.size());
+    // smaller roots win linking, so root of every set is its smallest index
+    for (std::size_t i = 0; i < parents_.size(); ++i) {
+      ids[i] = find(i);
+    }
+
+    return ids;
+  }
+
+ private:
+  std::vector<std::atomic<std::size_t>> parents_;
+};
@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+import os
+import subprocess
+import time
+import statistics
+import sys
+from collections import defaultdict
+
+# broad phase solutions, that are compared on the same generated tests
+SOLUTIONS = {
+    "BVH":             "../bin/usecase/optimized_BVH_solution",
+    "sweep and prune": "../bin/usecase/sweep_and_prune_solution",
+    "spatial hash":    "../bin/usecase/spatial_hash_solution",
+    "auto":            "../bin/usecase/auto_solution",
+}
+
+def run_test_with_timing(executable, test_file):
+    """Run executable with test file content as stdin and return time and output"""
+    try:
+        with open(test_file, 'r') as f:
+            test_content = f.read()
+
+        start_time = time.time()
+        result = subprocess.run([executable],
+                              input=test_content,
+                              capture_output=True,
+                              text=True,
+                              timeout=10)  # 10 second timeout
+        end_time = time.time()
+
+        execution_time = (end_time - start_time) * 1000  # Convert to milliseconds
+        return execution_time, result.stdout.strip()
+    except subprocess.TimeoutExpired:
+        return 10000, "TIMEOUT"
+    except Exception as e:
+        return 0, f"ERROR: {str(e)}"
+
+def main():
+    test_data_dir = "tests_data/in_one_plane"
+    size = sys.argv[1] if len(sys.argv) > 1 else "large_tests"
+
+    for name, executable in SOLUTIONS.items():
+        if not os.path.exists(executable):
+            print(f"Error: {executable} ({name}) not found!")
+            sys.exit(1)
+
+    size_path = os.path.join(test_data_dir, size)
+    if not os.path.exists(size_path):
+        print(f"Error: {size_path} not found!")
+        sys.exit(1)
+
+    # test type -> solution name -> times
+    timing_results = defaultdict(lambda: defaultdict(list))
+    mismatches = []
+
+    for test_type in sorted(os.listdir(size_path)):
+        test_type_path = os.path.join(size_path, test_type)
+        if not os.path.isdir(test_type_path):
+            continue
+
+        print(f"🔹 {test_type.upper()} tests:")
+        for test_file in sorted(os.listdir(test_type_path)):
+            if not test_file.endswith('.dat'):
+                continue
+
+            test_file_path = os.path.join(test_type_path, test_file)
+            print(f"  {test_file}", end="")
+            outputs = set()
+            for name, executable in SOLUTIONS.items():
+                execution_time, output = run_test_with_timing(executable, test_file_path)
+                timing_results[test_type][name].append(execution_time)
+                outputs.add(output)
+                print(f" | {name}: {execution_time:.2f}ms", end="")
+
+            # every solution must find the same triangles
+            if len(outputs) != 1:
+                mismatches.append(f"{test_type}/{test_file}")
+                print(" | ❌ OUTPUTS DIFFER", end="")
+            print()
+        print()
+
+    print("="*70)
+    print("MEDIAN TIME PER TEST TYPE, ms")
+    print("="*70)
+    names = list(SOLUTIONS.keys())
+    print(f"{'type':<16}" + "".join(f"{name:>18}" for name in names) + f"{'fastest':>18}")
+    for test_type in sorted(timing_results.keys()):
+        medians = [statistics.median(timing_results[test_type][name]) for name in names]
+        fastest = names[medians.index(min(medians))]
+        print(f"{test_type:<16}" + "".join(f"{median:>18.2f}" for median in medians) +
+              f"{fastest:>18}")
+
+    if mismatches:
+        print(f"\n⚠️  Outputs differ on {len(mismatches)} tests:")
+        for test in mismatches:
+            print(f"  {test}")
+        sys.exit(1)
+
+    print(f"\n✅ All solutions gave the same output")
+
+if __name__ == "__main__":
+    main()
@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <limits>
+#include <random>
+
 #include "AABB.hpp"
+#include "inflated_AABB.hpp"
 #include "triangle.hpp"
 
 TEST(AABBTest, IntersectionIdenticalBoxes) {
@@ -626,3 +631,138 @@ TEST(AABBTest, UniteAndLongestAxisCombined) {
   EXPECT_DOUBLE_EQ(aabb1.get_min_corner().y, 1.000);
   EXPECT_DOUBLE_EQ(aabb1.get_max_corner().y, 8.000);
 }
+
+TEST(AABBTest, GetVolume) {
+  AABB_t<double> box(point_t<double>{1.0, 2.0, 3.0}, point_t<double>{3.0, 5.0, 7.0});
+  EXPECT_DOUBLE_EQ(box.get_volume(), 24.0);
+
+  AABB_t<double> flat_box(point_t<double>{1.0, 2.0, 3.0}, point_t<double>{3.0, 5.0, 3.0});
+  EXPECT_DOUBLE_EQ(flat_box.get_volume(), 0.0);
+}
+
+TEST(AABBTest, GetIntersectionPartialOverlap) {
+  // min corner of second box is inside the first one by x and z, but not by y
+  AABB_t<double> first (point_t<double>{0.0,  0.0, 0.0}, point_t<double>{4.0, 4.0, 4.0});
+  AABB_t<double> second(point_t<double>{2.0, -1.0, 1.0}, point_t<double>{6.0, 3.0, 2.0});
+
+  for (const AABB_t<double>& inter : {first.get_intersection(second), second.get_intersection(first)}) {
+    EXPECT_DOUBLE_EQ(inter.get_min_corner().x, 2.0);
+    EXPECT_DOUBLE_EQ(inter.get_min_corner().y, 0.0);
+    EXPECT_DOUBLE_EQ(inter.get_min_corner().z, 1.0);
+    EXPECT_DOUBLE_EQ(inter.get_max_corner().x, 4.0);
+    EXPECT_DOUBLE_EQ(inter.get_max_corner().y, 3.0);
+    EXPECT_DOUBLE_EQ(inter.get_max_corner().z, 2.0);
+    EXPECT_DOUBLE_EQ(inter.get_volume(), 6.0);
+  }
+}
+
+TEST(AABBTest, GetIntersectionContainedAndSeparated) {
+  AABB_t<double> outer(point_t<double>{0.0, 0.0, 0.0}, point_t<double>{4.0, 4.0, 4.0});
+  AABB_t<double> inner(point_t<double>{1.0, 2.0, 3.0}, point_t<double>{2.0, 3.0, 3.5});
+  EXPECT_DOUBLE_EQ(outer.get_intersection(inner).get_volume(), inner.get_volume());
+  EXPECT_DOUBLE_EQ(inner.get_intersection(outer).get_surface_area(), inner.get_surface_area());
+
+  AABB_t<double> far(point_t<double>{5.0, 0.0, 0.0}, point_t<double>{6.0, 4.0, 4.0});
+  EXPECT_DOUBLE_EQ(outer.get_intersection(far).get_volume(), 0.0);
+  EXPECT_DOUBLE_EQ(outer.get_intersection(far).get_surface_area(), 0.0);
+
+  // touching faces give flat box
+  AABB_t<double> touching(point_t<double>{4.0, 1.0, 1.0}, point_t<double>{5.0, 2.0, 2.0});
+  AABB_t<double> face = outer.get_intersection(touching);
+  EXPECT_DOUBLE_EQ(face.get_volume(), 0.0);
+  EXPECT_DOUBLE_EQ(face.get_surface_area(), 2.0);
+}
+
+TEST(InflatedAABBTest, NeverMissesIntersection) {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> coord(-2.0, 2.0);
+  std::uniform_real_distribution<double> size(0.0, 1.0);
+  auto random_box = [&]() {
+    point_t<double> corner(coord(gen), coord(gen), coord(gen));
+    point_t<double> other = corner + point_t<double>(size(gen), size(gen), size(gen));
+    return AABB_t<double>(corner, other);
+  };
+
+  for (int i = 0; i < 10000; ++i) {
+    AABB_t<double> aabb1 = random_box();
+    AABB_t<double> aabb2 = random_box();
+    inflated_AABB_t<double> inflated1(aabb1);
+    inflated_AABB_t<double> inflated2(aabb2);
+
+    EXPECT_EQ(inflated1.does_inter(inflated2), inflated2.does_inter(inflated1));
+    if (aabb1.does_inter(aabb2)) {
+      EXPECT_TRUE(inflated1.does_inter(inflated2));
+    }
+  }
+}
+
+TEST(InflatedAABBTest, TouchingAndSeparatedBoxes) {
+  inflated_AABB_t<double> box(     {{0.0, 0.0, 0.0}, {1.0, 1.0, 1.0}});
+  inflated_AABB_t<double> touching({{1.0, 0.0, 0.0}, {2.0, 1.0, 1.0}});
+  inflated_AABB_t<double> separated({{1.1, 0.0, 0.0}, {2.0, 1.0, 1.0}});
+
+  EXPECT_TRUE(box.does_inter(touching));
+  EXPECT_FALSE(box.does_inter(separated));
+  EXPECT_FALSE(separated.does_inter(box));
+}
+
+TEST(InflatedAABBTest, OverlapMask) {
+  inflated_AABB_t<double> box(     {{0.0, 0.0, 0.0}, {1.0, 1.0, 1.0}});
+  inflated_AABB_t<double> inside(  {{0.2, 0.2, 0.2}, {0.8, 0.8, 0.8}});
+  inflated_AABB_t<double> outside({{0.0, 5.0, 0.0}, {1.0, 6.0, 1.0}});
+
+  EXPECT_EQ(box.get_overlap_mask(inside,  inside),  0b11u);
+  EXPECT_EQ(box.get_overlap_mask(inside,  outside), 0b01u);
+  EXPECT_EQ(box.get_overlap_mask(outside, inside),  0b10u);
+  EXPECT_EQ(box.get_overlap_mask(outside, outside), 0b00u);
+}
+
+TEST(InflatedAABBTest, DoubledCenterDist) {
+  inflated_AABB_t<double> box(  {{0.0, 0.0, 0.0}, {2.0, 2.0, 2.0}});
+  inflated_AABB_t<double> near( {{1.0, 1.0, 1.0}, {3.0, 3.0, 3.0}});
+  inflated_AABB_t<double> far(  {{5.0, 0.0, 0.0}, {6.0, 1.0, 1.0}});
+
+  // inflation moves both corners, centers stay in place
+  EXPECT_NEAR(box.get_doubled_center_dist(box),  0.0, 1e-9);
+  EXPECT_NEAR(box.get_doubled_center_dist(near), 6.0, 1e-9);
+  EXPECT_NEAR(box.get_doubled_center_dist(far),  11.0, 1e-9);
+  EXPECT_NEAR(far.get_doubled_center_dist(box),  11.0, 1e-9);
+}
+
+TEST(InflatedAABBTest, FloatBoxContainsDoubleBox) {
+  std::mt19937 gen(20);
+  std::uniform_real_distribution<double> exponent(-45.0, 45.0);
+  std::uniform_real_distribution<double> mantissa(-1.0, 1.0);
+  auto random_value = [&]() { return mantissa(gen) * std::pow(10.0, exponent(gen)); };
+
+  for (int i = 0; i < 10000; ++i) {
+    point_t<double> corner(random_value(), random_value(), random_value());
+    point_t<double> other (random_value(), random_value(), random_value());
+    inflated_AABB_t<double> box(AABB_t<double>(corner, other));
+    inflated_AABB_t<float>  float_box(box);
+
+    for (utils::axis_t axis : {utils::axis_t::X, utils::axis_t::Y, utils::axis_t::Z}) {
+      ASSERT_LE(float_box.get_min_corner().get_coord_by_axis_name(axis),
+                box.get_min_corner().get_coord_by_axis_name(axis)) << box.get_min_corner();
+      ASSERT_GE(float_box.get_max_corner().get_coord_by_axis_name(axis),
+                box.get_max_corner().get_coord_by_axis_name(axis)) << box.get_max_corner();
+    }
+  }
+}
+
+TEST(InflatedAABBTest, FloatBoxOfHugeAndTinyValues) {
+  inflated_AABB_t<double> huge_box(AABB_t<double>({-1e300, -1e39, 0.0}, {1e300, 1e39, 1e-300}));
+  inflated_AABB_t<float>  huge_float_box(huge_box);
+  EXPECT_EQ(huge_float_box.get_min_corner().x, -std::numeric_limits<float>::infinity());
+  EXPECT_LE(huge_float_box.get_min_corner().y, -std::numeric_limits<float>::max());
+  EXPECT_EQ(huge_float_box.get_max_corner().x,  std::numeric_limits<float>::infinity());
+  EXPECT_GE(huge_float_box.get_max_corner().y,  std::numeric_limits<float>::max());
+  EXPECT_LT(huge_float_box.get_min_corner().z,  0.0f);
+  EXPECT_GT(huge_float_box.get_max_corner().z,  0.0f);
+
+  // boxes touching at a value, that float can't represent, still overlap
+  const double kValue = 1e7 + 0.1;
+  inflated_AABB_t<float> left (inflated_AABB_t<double>(AABB_t<double>({0.0,    0.0, 0.0}, {kValue, 1.0, 1.0})));
+  inflated_AABB_t<float> right(inflated_AABB_t<double>(AABB_t<double>({kValue, 0.0, 0.0}, {2e7,    1.0, 1.0})));
+  EXPECT_TRUE(left.does_inter(right));
+}
@@ -1,9 +1,13 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
 #include <random>
 
 #include "point.hpp"
 #include "triangle.hpp"
 #include "solutions_impl.hpp"
+#include "test_scenes.hpp"
 
 using BVH_fast_solution_double_t =
   triangles_inters_solver_t<double, opt_bvh_solution_tag>;
@@ -479,3 +483,525 @@ TEST(BVHFastSolutionTest, Complex3DWeaving) {
 }
 
 
+// ---------------  check BVH_t split strategies  ---------------
+
+using test_scenes::generate_random_triangles;
+
+static std::vector<std::size_t> solve_with_BVH(
+  const std::vector<triangle_t<double>>& triangles,
+  const BVH_build_params_t<double>&      build_params
+) {
+  BVH_t<double> BVH_tree(triangles, build_params);
+  std::vector<std::size_t> result;
+  for (std::size_t i = 0; i < triangles.size(); ++i) {
+    if (BVH_tree.is_triangle_not_alone(triangles[i], i)) {
+      result.emplace_back(i);
+    }
+  }
+
+  return result;
+}
+
+TEST(BVHSplitStrategyTest, MedianAndSAHMatchNaive) {
+  auto triangles = generate_random_triangles(600, 30.0, 2.0);
+  triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+  auto expected = naive_solver.get_inter_triangs_indices();
+  ASSERT_FALSE(expected.empty());
+
+  BVH_build_params_t<double> median_params;
+  median_params.strategy = BVH_split_strategy_t::MEDIAN;
+  BVH_build_params_t<double> SAH_params;
+  SAH_params.strategy = BVH_split_strategy_t::BINNED_SAH;
+
+  EXPECT_EQ(solve_with_BVH(triangles, median_params), expected);
+  EXPECT_EQ(solve_with_BVH(triangles, SAH_params),    expected);
+}
+
+TEST(BVHSplitStrategyTest, SAHCustomParamsMatchNaive) {
+  auto triangles = generate_random_triangles(400, 20.0, 3.0);
+  triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+  auto expected = naive_solver.get_inter_triangs_indices();
+
+  BVH_build_params_t<double> params;
+  params.num_bins          = 2;
+  params.traversal_cost    = 0.5;
+  params.intersection_cost = 10.0;
+  params.max_leaf_size     = 1;
+  EXPECT_EQ(solve_with_BVH(triangles, params), expected);
+
+  params.num_bins          = 64;
+  params.traversal_cost    = 100.0;
+  params.intersection_cost = 1.0;
+  params.max_leaf_size     = 1000;
+  EXPECT_EQ(solve_with_BVH(triangles, params), expected);
+}
+
+TEST(BVHSplitStrategyTest, SAHCoincidentCenters) {
+  // SAH can't separate triangles with equal centers, they must end up in one leaf
+  std::vector<triangle_t<double>> triangles;
+  for (int i = 0; i < 50; ++i) {
+    double side = 1.0 + i * 0.1;
+    triangles.emplace_back(point_t{-side, -side, 0.0},
+                           point_t{ side,  side, 0.0},
+                           point_t{-side,  side, 0.0});
+  }
+  triangles.emplace_back(point_t{100.0, 100.0, 100.0},
+                         point_t{101.0, 100.0, 100.0},
+                         point_t{100.0, 101.0, 100.0});
+
+  auto result = solve_with_BVH(triangles, BVH_build_params_t<double>{});
+  EXPECT_EQ(result.size(), 50);
+  EXPECT_EQ(std::find(result.begin(), result.end(), 50), result.end());
+}
+
+TEST(BVHSplitStrategyTest, LBVHMatchesNaive) {
+  auto triangles = generate_random_triangles(1500, 30.0, 3.0);
+  triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+
+  for (std::size_t num_threads : std::array<std::size_t, 2>{1, 4}) {
+    solver_params_t<double> params;
+    params.BVH_build_params.strategy = BVH_split_strategy_t::LBVH;
+    params.num_threads               = num_threads;
+    BVH_fast_solution_double_t solver{triangles, params};
+    EXPECT_EQ(solver.get_inter_triangs_indices(), naive_solver.get_inter_triangs_indices());
+    EXPECT_EQ(solver.get_inter_triangs_pairs(),   naive_solver.get_inter_triangs_pairs());
+    EXPECT_EQ(solver.get_components().ids,        naive_solver.get_components().ids);
+  }
+}
+
+template<typename T>
+static std::vector<triangle_t<T>> generate_coincident_and_flat_triangles() {
+  std::vector<triangle_t<T>> triangles;
+  for (int i = 0; i < 40; ++i) {
+    T side = static_cast<T>(1.0 + i * 0.1);
+    triangles.emplace_back(point_t<T>{-side, -side, 0},
+                           point_t<T>{ side,  side, 0},
+                           point_t<T>{-side,  side, 0});
+  }
+  for (int i = 0; i < 40; ++i) {
+    T shift = static_cast<T>(10 * (i + 1));
+    triangles.emplace_back(point_t<T>{shift, 0, 0},
+                           point_t<T>{shift + 1, 0, 0},
+                           point_t<T>{shift, 1, 0});
+  }
+
+  return triangles;
+}
+
+TEST(BVHSplitStrategyTest, LBVHCoincidentAndFlatCenters) {
+  // equal Morton codes are split in halves, zero extent along z must not break quantization
+  BVH_build_params_t<double> params;
+  params.strategy = BVH_split_strategy_t::LBVH;
+  std::vector<std::size_t> expected(40);
+  std::iota(expected.begin(), expected.end(), 0);
+  EXPECT_EQ(solve_with_BVH(generate_coincident_and_flat_triangles<double>(), params), expected);
+
+  BVH_build_params_t<float> float_params;
+  float_params.strategy = BVH_split_strategy_t::LBVH;
+  auto float_triangles = generate_coincident_and_flat_triangles<float>();
+  BVH_t<float> float_tree(float_triangles, float_params);
+  float_tree.mark_self_intersections();
+  for (std::size_t i = 0; i < float_triangles.size(); ++i) {
+    EXPECT_EQ(float_tree.is_marked(i), i < 40) << i;
+  }
+}
+
+TEST(BVHTraversalTest, DeepTreeMatchesNaive) {
+  // triangles and crossing ones, scaled by powers of 2, so SAH splits off
+  // few triangles per level and the tree is very deep and unbalanced
+  std::vector<triangle_t<double>> triangles;
+  for (int i = 0; i < 150; ++i) {
+    double x = std::ldexp(1.0, i);
+    double h = x / 2;
+    triangles.emplace_back(point_t{x, 0.0, 0.0}, point_t{x + h, 0.0, 0.0}, point_t{x, h, 0.0});
+    if (i % 3 != 0) {
+      triangles.emplace_back(point_t{x + h / 5, h / 5, -h}, point_t{x + h / 5, h / 5, h},
+                             point_t{x + h / 2, h / 2, h});
+    }
+  }
+  triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+  auto expected = naive_solver.get_inter_triangs_indices();
+  ASSERT_FALSE(expected.empty());
+
+  for (auto strategy : {BVH_split_strategy_t::MEDIAN, BVH_split_strategy_t::BINNED_SAH,
+                        BVH_split_strategy_t::LBVH}) {
+    BVH_build_params_t<double> params;
+    params.strategy      = strategy;
+    params.max_leaf_size = 1;
+    if (strategy == BVH_split_strategy_t::BINNED_SAH) {
+      EXPECT_GE(BVH_t<double>(triangles, params).get_quality().max_depth, 40u);
+    }
+    for (auto order : {BVH_traversal_order_t::NEAR_FIRST, BVH_traversal_order_t::LEFT_FIRST}) {
+      params.traversal_order = order;
+      EXPECT_EQ(solve_with_BVH(triangles, params), expected);
+    }
+  }
+}
+
+TEST(BVHTraversalTest, OrdersMatchNaive) {
+  for (double max_triangle_side : {0.5, 3.0, 10.0}) {
+    auto triangles = generate_random_triangles(800, 30.0, max_triangle_side);
+    triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+    auto expected = naive_solver.get_inter_triangs_indices();
+
+    for (auto strategy : {BVH_split_strategy_t::MEDIAN, BVH_split_strategy_t::BINNED_SAH,
+                          BVH_split_strategy_t::LBVH}) {
+      for (auto order : {BVH_traversal_order_t::NEAR_FIRST, BVH_traversal_order_t::LEFT_FIRST}) {
+        BVH_build_params_t<double> params;
+        params.strategy        = strategy;
+        params.traversal_order = order;
+        EXPECT_EQ(solve_with_BVH(triangles, params), expected);
+      }
+    }
+  }
+}
+
+// ---------------  check BVH query modes  ---------------
+
+static std::vector<std::size_t> solve_with_query_mode(
+  const std::vector<triangle_t<double>>& triangles,
+  BVH_split_strategy_t                   strategy,
+  BVH_query_mode_t                       query_mode,
+  std::size_t                            num_threads = 1
+) {
+  solver_params_t<double> params;
+  params.BVH_build_params.strategy = strategy;
+  params.BVH_query_mode            = query_mode;
+  params.num_threads               = num_threads;
+
+  BVH_fast_solution_double_t solver{triangles, params};
+  return solver.get_inter_triangs_indices();
+}
+
+TEST(BVHQueryModeTest, DualTreeMatchesNaive) {
+  for (double max_triangle_side : {0.5, 2.0, 6.0}) {
+    auto triangles = generate_random_triangles(500, 25.0, max_triangle_side);
+    triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+    auto expected = naive_solver.get_inter_triangs_indices();
+
+    for (auto strategy : {BVH_split_strategy_t::MEDIAN, BVH_split_strategy_t::BINNED_SAH,
+                          BVH_split_strategy_t::LBVH}) {
+      EXPECT_EQ(solve_with_query_mode(triangles, strategy, BVH_query_mode_t::DUAL_TREE),
+                expected);
+      EXPECT_EQ(solve_with_query_mode(triangles, strategy, BVH_query_mode_t::PER_TRIANGLE),
+                expected);
+    }
+  }
+}
+
+TEST(BVHQueryModeTest, DualTreeInsideOneLeaf) {
+  std::vector<triangle_t<double>> triangles{
+    {point_t{0.0, 0.0, 0.0}, point_t{1.0, 0.0, 0.0}, point_t{0.0, 1.0, 0.0}},
+    {point_t{5.0, 5.0, 5.0}, point_t{6.0, 5.0, 5.0}, point_t{5.0, 6.0, 5.0}},
+    {point_t{0.2, 0.2, -1.0}, point_t{0.2, 0.2, 1.0}, point_t{0.3, 0.3, 0.0}},
+  };
+
+  auto result = solve_with_query_mode(
+    triangles, BVH_split_strategy_t::BINNED_SAH, BVH_query_mode_t::DUAL_TREE
+  );
+  EXPECT_EQ(result, (std::vector<std::size_t>{0, 2}));
+}
+
+TEST(BVHQueryModeTest, MultithreadedMatchesNaive) {
+  for (double max_triangle_side : {0.5, 3.0}) {
+    auto triangles = generate_random_triangles(1200, 30.0, max_triangle_side);
+    triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+    auto expected = naive_solver.get_inter_triangs_indices();
+
+    for (std::size_t num_threads : std::array<std::size_t, 3>{2, 4, 7}) {
+      for (auto query_mode : {BVH_query_mode_t::PER_TRIANGLE, BVH_query_mode_t::DUAL_TREE}) {
+        EXPECT_EQ(solve_with_query_mode(triangles, BVH_split_strategy_t::BINNED_SAH,
+                                        query_mode, num_threads),
+                  expected);
+      }
+    }
+  }
+}
+
+TEST(BVHParallelBuildTest, SameTreeAsSerial) {
+  // big enough for subtrees to be built by different threads
+  auto triangles = generate_random_triangles(20000, 100.0, 1.0);
+
+  for (auto strategy : {BVH_split_strategy_t::MEDIAN, BVH_split_strategy_t::BINNED_SAH,
+                        BVH_split_strategy_t::LBVH}) {
+    BVH_build_params_t<double> params;
+    params.strategy = strategy;
+    BVH_t<double> serial_tree(triangles, params);
+    serial_tree.mark_self_intersections();
+
+    params.num_threads = 4;
+    BVH_t<double> parallel_tree(triangles, params);
+    parallel_tree.mark_self_intersections();
+
+    EXPECT_EQ(serial_tree.get_num_nodes(), parallel_tree.get_num_nodes());
+    EXPECT_TRUE(serial_tree.is_same_tree(parallel_tree));
+    for (std::size_t i = 0; i < triangles.size(); ++i) {
+      ASSERT_EQ(serial_tree.is_marked(i), parallel_tree.is_marked(i));
+    }
+  }
+
+  // trees of other strategies must differ, else the check above proves nothing
+  BVH_build_params_t<double> median_params;
+  median_params.strategy = BVH_split_strategy_t::MEDIAN;
+  BVH_build_params_t<double> SAH_params;
+  SAH_params.strategy = BVH_split_strategy_t::BINNED_SAH;
+  EXPECT_FALSE(BVH_t<double>(triangles, median_params).is_same_tree(BVH_t<double>(triangles, SAH_params)));
+}
+
+TEST(BVHPairsTest, AllPairsMatchNaive) {
+  for (double max_triangle_side : {0.5, 3.0}) {
+    auto triangles = generate_random_triangles(1200, 30.0, max_triangle_side);
+    triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+    auto expected = naive_solver.get_inter_triangs_pairs();
+    ASSERT_FALSE(expected.empty());
+
+    for (std::size_t num_threads : std::array<std::size_t, 3>{1, 2, 7}) {
+      solver_params_t<double> params;
+      params.num_threads = num_threads;
+      BVH_fast_solution_double_t solver{triangles, params};
+      EXPECT_EQ(solver.get_inter_triangs_pairs(), expected);
+    }
+  }
+}
+
+TEST(BVHPairsTest, PairsCoverMarkedTriangles) {
+  auto triangles = generate_random_triangles(2000, 30.0, 3.0);
+  BVH_fast_solution_double_t solver{triangles};
+
+  std::vector<std::size_t> from_pairs;
+  for (auto [first, second] : solver.get_inter_triangs_pairs()) {
+    EXPECT_LT(first, second);
+    from_pairs.push_back(first);
+    from_pairs.push_back(second);
+  }
+  std::sort(from_pairs.begin(), from_pairs.end());
+  from_pairs.erase(std::unique(from_pairs.begin(), from_pairs.end()), from_pairs.end());
+
+  EXPECT_EQ(from_pairs, solver.get_inter_triangs_indices());
+}
+
+TEST(BVHPairsTest, LimitIsExact) {
+  auto triangles = generate_random_triangles(1200, 30.0, 3.0);
+  triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+  auto all_pairs = naive_solver.get_inter_triangs_pairs();
+  ASSERT_GT(all_pairs.size(), 10u);
+
+  for (std::size_t num_threads : std::array<std::size_t, 2>{1, 4}) {
+    BVH_t<double> tree(triangles);
+    auto pairs = tree.find_intersecting_pairs(num_threads, 10);
+    ASSERT_EQ(pairs.size(), 10u);
+    EXPECT_TRUE(std::is_sorted(pairs.begin(), pairs.end()));
+    for (const auto& pair : pairs) {
+      EXPECT_TRUE(std::binary_search(all_pairs.begin(), all_pairs.end(), pair));
+    }
+  }
+
+  EXPECT_EQ(naive_solver.get_inter_triangs_pairs(10),
+            decltype(all_pairs)(all_pairs.begin(), all_pairs.begin() + 10));
+}
+
+TEST(BVHComponentsTest, ComponentsMatchNaive) {
+  for (double max_triangle_side : {0.5, 3.0}) {
+    auto triangles = generate_random_triangles(1500, 30.0, max_triangle_side);
+    triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+    components_t expected = naive_solver.get_components();
+    ASSERT_GT(expected.num_clusters, 0u);
+
+    for (std::size_t num_threads : std::array<std::size_t, 3>{1, 2, 7}) {
+      solver_params_t<double> params;
+      params.num_threads = num_threads;
+      BVH_fast_solution_double_t solver{triangles, params};
+      components_t components = solver.get_components();
+      EXPECT_EQ(components.ids,            expected.ids);
+      EXPECT_EQ(components.num_components, expected.num_components);
+      EXPECT_EQ(components.num_clusters,   expected.num_clusters);
+      EXPECT_EQ(components.max_size,       expected.max_size);
+      EXPECT_EQ(components.num_clustered,  expected.num_clustered);
+    }
+  }
+}
+
+TEST(BVHComponentsTest, ClusteredTrianglesAreIntersecting) {
+  auto triangles = generate_random_triangles(2000, 30.0, 3.0);
+  BVH_fast_solution_double_t solver{triangles};
+  components_t components = solver.get_components();
+
+  std::vector<std::size_t> sizes(triangles.size(), 0);
+  for (std::size_t id : components.ids) {
+    ++sizes[id];
+  }
+  std::vector<std::size_t> clustered;
+  for (std::size_t i = 0; i < triangles.size(); ++i) {
+    EXPECT_LE(components.ids[i], i);
+    if (sizes[components.ids[i]] > 1) {
+      clustered.push_back(i);
+    }
+  }
+
+  EXPECT_EQ(clustered, solver.get_inter_triangs_indices());
+}
+
+// ---------------  check exact narrow phase  ---------------
+
+TEST(BVHExactKernelTest, MatchesNaive) {
+  for (double max_triangle_side : {0.5, 3.0}) {
+    auto triangles = generate_random_triangles(1200, 30.0, max_triangle_side);
+    solver_params_t<double> params;
+    params.narrow_phase_kernel = triangle_inters_kernel_t::EXACT;
+
+    triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles, params};
+    auto expected = naive_solver.get_inter_triangs_indices();
+    // random coordinates are far from touching, so epsilon gives the same answer
+    triangles_inters_solver_t<double, naive_solution_tag> epsilon_solver{triangles};
+    EXPECT_EQ(epsilon_solver.get_inter_triangs_indices(), expected);
+
+    for (auto query_mode : {BVH_query_mode_t::PER_TRIANGLE, BVH_query_mode_t::DUAL_TREE}) {
+      params.BVH_query_mode = query_mode;
+      BVH_fast_solution_double_t solver{triangles, params};
+      EXPECT_EQ(solver.get_inter_triangs_indices(), expected);
+    }
+  }
+}
+
+// ---------------  check float node boxes  ---------------
+
+TEST(BVHNodePrecisionTest, NodeSize) {
+  EXPECT_EQ((BVH_t<double>::get_node_size()),        64u);
+  EXPECT_EQ((BVH_t<double, float>::get_node_size()), 32u);
+  EXPECT_EQ((BVH_t<float>::get_node_size()),         32u);
+}
+
+TEST(BVHNodePrecisionTest, FloatNodesMatchDoubleNodes) {
+  auto triangles = generate_random_triangles(1500, 30.0, 3.0);
+  for (auto strategy : {BVH_split_strategy_t::MEDIAN, BVH_split_strategy_t::BINNED_SAH,
+                        BVH_split_strategy_t::LBVH}) {
+    BVH_build_params_t<double> params;
+    params.strategy = strategy;
+    BVH_t<double>        double_tree(triangles, params);
+    BVH_t<double, float> float_tree (triangles, params);
+    EXPECT_EQ(double_tree.get_num_nodes(), float_tree.get_num_nodes());
+    EXPECT_EQ(double_tree.find_intersecting_pairs(), float_tree.find_intersecting_pairs());
+
+    double_tree.mark_not_alone_triangles();
+    float_tree.mark_not_alone_triangles();
+    for (std::size_t i = 0; i < triangles.size(); ++i) {
+      ASSERT_EQ(double_tree.is_marked(i), float_tree.is_marked(i)) << i;
+    }
+  }
+}
+
+TEST(BVHNodePrecisionTest, FarFromOriginMatchesNaive) {
+  // float step is 1 here, triangles touch at points, that float can't represent
+  const double kOrigin = 1e7;
+  std::vector<triangle_t<double>> triangles;
+  for (int i = 0; i < 200; ++i) {
+    double x = kOrigin + 0.3 * i;
+    triangles.emplace_back(point_t{x, 0.0, 0.0}, point_t{x + 0.3, 0.0, 0.0}, point_t{x, 0.3, 0.0});
+    triangles.emplace_back(point_t{x + 0.3, 0.0, 0.0}, point_t{x + 0.3, 0.3, 1.0},
+                           point_t{x + 0.3, -0.3, 1.0});
+  }
+  auto more_triangles = generate_random_triangles(500, 30.0, 1.0);
+  for (const auto& triangle : more_triangles) {
+    auto points = triangle.get_points();
+    point_t<double> shift{kOrigin, 0.0, 5.0};
+    triangles.emplace_back(points[0] + shift, points[1] + shift, points[2] + shift);
+  }
+
+  triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+  auto expected = naive_solver.get_inter_triangs_pairs();
+  ASSERT_FALSE(expected.empty());
+
+  for (auto query_mode : {BVH_query_mode_t::PER_TRIANGLE, BVH_query_mode_t::DUAL_TREE}) {
+    solver_params_t<double> params;
+    params.BVH_query_mode = query_mode;
+    BVH_fast_solution_double_t solver{triangles, params};
+    EXPECT_EQ(solver.get_inter_triangs_pairs(),   expected);
+    EXPECT_EQ(solver.get_inter_triangs_indices(), naive_solver.get_inter_triangs_indices());
+  }
+}
+
+
+// ---------------  check BVH_t quality metrics  ---------------
+
+TEST(BVHQualityTest, MetricsAreConsistent) {
+  auto triangles = generate_random_triangles(3000, 50.0, 2.0);
+  for (auto strategy : {BVH_split_strategy_t::MEDIAN, BVH_split_strategy_t::BINNED_SAH,
+                        BVH_split_strategy_t::LBVH}) {
+    BVH_build_params_t<double> params;
+    params.strategy    = strategy;
+    params.num_threads = 4;
+    BVH_t<double, float> BVH_tree(triangles, params);
+    BVH_quality_t quality = BVH_tree.get_quality();
+
+    EXPECT_EQ(quality.num_nodes, BVH_tree.get_num_nodes());
+    EXPECT_EQ(quality.num_nodes, 2 * quality.num_leaves - 1);
+    EXPECT_EQ(quality.max_depth + 1, quality.levels.size());
+    EXPECT_GT(quality.SAH_cost, 0.0);
+
+    std::size_t num_leaves_by_size = 0, num_triangles = 0;
+    for (std::size_t size = 0; size < quality.leaf_sizes.size(); ++size) {
+      num_leaves_by_size += quality.leaf_sizes[size];
+      num_triangles      += size * quality.leaf_sizes[size];
+    }
+    EXPECT_EQ(num_leaves_by_size, quality.num_leaves);
+    EXPECT_EQ(num_triangles,      triangles.size());
+
+    std::size_t num_leaves_by_depth = 0, num_inner_nodes = 0;
+    for (const auto& level : quality.levels) {
+      num_leaves_by_depth += level.num_leaves;
+      num_inner_nodes     += level.num_inner_nodes;
+      EXPECT_GE(level.mean_overlap_ratio, 0.0);
+      EXPECT_LE(level.mean_overlap_ratio, 1.0);
+    }
+    EXPECT_EQ(num_leaves_by_depth, quality.num_leaves);
+    EXPECT_EQ(num_inner_nodes + quality.num_leaves, quality.num_nodes);
+    EXPECT_EQ(quality.levels.front().num_inner_nodes, 1u);
+
+    std::size_t num_leaves_by_reason = 0;
+    for (std::size_t num : quality.leaves_by_reason) {
+      num_leaves_by_reason += num;
+    }
+    EXPECT_EQ(num_leaves_by_reason, quality.num_leaves);
+    if (strategy == BVH_split_strategy_t::LBVH) {
+      EXPECT_EQ(quality.leaves_by_reason[static_cast<std::size_t>(BVH_leaf_reason_t::SMALL)],
+                quality.num_leaves);
+    }
+  }
+}
+
+// the case, where median strategy degenerates: flat dense scene stops splitting at depth 8
+TEST(BVHQualityTest, MedianForcedLeavesAreReported) {
+  std::mt19937 gen(23);
+  std::uniform_real_distribution<double> coord_distr(0.0, 10.0);
+  std::vector<triangle_t<double>> triangles;
+  for (int i = 0; i < 20000; ++i) {
+    triangles.emplace_back(point_t{coord_distr(gen), coord_distr(gen), 0.0},
+                           point_t{coord_distr(gen), coord_distr(gen), 0.0},
+                           point_t{coord_distr(gen), coord_distr(gen), 0.0});
+  }
+
+  BVH_build_params_t<double> params;
+  params.strategy = BVH_split_strategy_t::MEDIAN;
+  BVH_t<double> median_tree(triangles, params);
+  BVH_quality_t median_quality = median_tree.get_quality();
+  std::size_t num_overlap_leaves =
+    median_quality.leaves_by_reason[static_cast<std::size_t>(BVH_leaf_reason_t::OVERLAP)];
+  EXPECT_GT(num_overlap_leaves, 0u);
+  EXPECT_LE(median_quality.max_depth, 9u);
+  // overlap of children is high on every level
+  EXPECT_GT(median_quality.levels.front().mean_overlap_ratio, 0.5);
+
+  params.strategy = BVH_split_strategy_t::LBVH;
+  BVH_t<double> LBVH_tree(triangles, params);
+  EXPECT_GT(LBVH_tree.get_quality().num_leaves, median_quality.num_leaves);
+}
+
+TEST(BVHQualityTest, EmptyTree) {
+  std::vector<triangle_t<double>> triangles;
+  BVH_t<double> BVH_tree(triangles);
+  BVH_quality_t quality = BVH_tree.get_quality();
+  EXPECT_EQ(quality.num_nodes,  0u);
+  EXPECT_EQ(quality.num_leaves, 0u);
+  EXPECT_TRUE(quality.levels.empty());
+  EXPECT_DOUBLE_EQ(quality.SAH_cost, 0.0);
+}
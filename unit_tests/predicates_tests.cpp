@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "predicates.hpp"
+
+namespace {
+  __extension__ typedef __int128 int128_t;
+
+  utils::signs_t get_sign(int128_t value) {
+    if (value == 0) {
+      return utils::signs_t::ZERO;
+    }
+    return value > 0 ? utils::signs_t::POS : utils::signs_t::NEG;
+  }
+
+  // all coordinates are integers, so determinant is computed exactly
+  utils::signs_t orient3d_reference(
+    const point_t<double>& a, const point_t<double>& b,
+    const point_t<double>& c, const point_t<double>& d
+  ) {
+    auto to_int = [](double value) { return static_cast<int128_t>(static_cast<std::int64_t>(value)); };
+    int128_t ux = to_int(b.x) - to_int(a.x), uy = to_int(b.y) - to_int(a.y), uz = to_int(b.z) - to_int(a.z);
+    int128_t vx = to_int(c.x) - to_int(a.x), vy = to_int(c.y) - to_int(a.y), vz = to_int(c.z) - to_int(a.z);
+    int128_t wx = to_int(d.x) - to_int(a.x), wy = to_int(d.y) - to_int(a.y), wz = to_int(d.z) - to_int(a.z);
+    return get_sign(ux * (vy * wz - vz * wy) + uy * (vz * wx - vx * wz) + uz * (vx * wy - vy * wx));
+  }
+
+  // coordinates are multiples of 2^-kFracBits
+  constexpr int kFracBits = 53;
+
+  utils::signs_t orient2d_reference(
+    const predicates::point2_t& a, const predicates::point2_t& b, const predicates::point2_t& c
+  ) {
+    auto to_int = [](double value) {
+      return static_cast<int128_t>(static_cast<std::int64_t>(std::ldexp(value, kFracBits)));
+    };
+    int128_t ux = to_int(b[0]) - to_int(a[0]), uy = to_int(b[1]) - to_int(a[1]);
+    int128_t vx = to_int(c[0]) - to_int(a[0]), vy = to_int(c[1]) - to_int(a[1]);
+    return get_sign(ux * vy - uy * vx);
+  }
+};
+
+TEST(PredicatesTest, Orient3dSimpleCases) {
+  point_t<double> a{0.0, 0.0, 0.0};
+  point_t<double> b{1.0, 0.0, 0.0};
+  point_t<double> c{0.0, 1.0, 0.0};
+
+  EXPECT_EQ(predicates::orient3d(a, b, c, point_t<double>{0.3, 0.3,  1.0}), utils::signs_t::POS);
+  EXPECT_EQ(predicates::orient3d(a, b, c, point_t<double>{0.3, 0.3, -1.0}), utils::signs_t::NEG);
+  EXPECT_EQ(predicates::orient3d(a, b, c, point_t<double>{5.0, 7.0,  0.0}), utils::signs_t::ZERO);
+  // far below epsilon of utils::sign, but not zero
+  EXPECT_EQ(predicates::orient3d(a, b, c, point_t<double>{0.3, 0.3, 1e-200}), utils::signs_t::POS);
+}
+
+TEST(PredicatesTest, Orient3dNearlyCoplanarMatchesIntegers) {
+  std::mt19937_64 gen(19);
+  std::uniform_int_distribution<std::int64_t> base_distr (-(std::int64_t{1} << 29), std::int64_t{1} << 29);
+  std::uniform_int_distribution<std::int64_t> vec_distr  (-(std::int64_t{1} << 28), std::int64_t{1} << 28);
+  std::uniform_int_distribution<std::int64_t> coef_distr (-2, 2);
+  std::uniform_int_distribution<std::int64_t> noise_distr(-1, 1);
+  auto to_double = [](std::int64_t value) { return static_cast<double>(value); };
+
+  std::size_t num_zeros = 0;
+  for (int iter = 0; iter < 20000; ++iter) {
+    std::int64_t a[3], u[3], v[3];
+    for (int i = 0; i < 3; ++i) {
+      a[i] = base_distr(gen);
+      u[i] = vec_distr(gen);
+      v[i] = vec_distr(gen);
+    }
+
+    // d is in the plane of abc, up to one unit of noise
+    std::int64_t m = coef_distr(gen), n = coef_distr(gen);
+    std::int64_t d[3];
+    for (int i = 0; i < 3; ++i) {
+      d[i] = a[i] + m * u[i] + n * v[i] + noise_distr(gen);
+    }
+
+    point_t<double> pa{to_double(a[0]),        to_double(a[1]),        to_double(a[2])};
+    point_t<double> pb{to_double(a[0] + u[0]), to_double(a[1] + u[1]), to_double(a[2] + u[2])};
+    point_t<double> pc{to_double(a[0] + v[0]), to_double(a[1] + v[1]), to_double(a[2] + v[2])};
+    point_t<double> pd{to_double(d[0]),        to_double(d[1]),        to_double(d[2])};
+
+    utils::signs_t expected = orient3d_reference(pa, pb, pc, pd);
+    num_zeros += expected == utils::signs_t::ZERO;
+    ASSERT_EQ(predicates::orient3d(pa, pb, pc, pd), expected) << iter;
+    // permutations change sign the way determinant does
+    ASSERT_EQ(predicates::orient3d(pb, pa, pc, pd), orient3d_reference(pb, pa, pc, pd)) << iter;
+    ASSERT_EQ(predicates::orient3d(pd, pb, pc, pa), orient3d_reference(pd, pb, pc, pa)) << iter;
+  }
+
+  // noise is zero in 1/27 of cases
+  EXPECT_GT(num_zeros, 500u);
+}
+
+TEST(PredicatesTest, Orient3dFloatCoordinates) {
+  point_t<float> a{0.1f, 0.2f, 0.3f};
+  point_t<float> b{1.7f, 0.4f, 0.9f};
+  point_t<float> c{0.5f, 2.1f, 0.6f};
+
+  EXPECT_EQ(predicates::orient3d(a, b, c, a), utils::signs_t::ZERO);
+  EXPECT_EQ(predicates::orient3d(a, b, c, c), utils::signs_t::ZERO);
+  EXPECT_EQ(predicates::orient3d(a, b, c, point_t<float>{0.1f, 0.2f, 0.30001f}),
+            predicates::orient3d(a, b, c, point_t<float>{0.1f, 0.2f, 1.0f}));
+}
+
+// points near the line y = x, naive computation gets wrong signs here
+TEST(PredicatesTest, Orient2dNearlyCollinearMatchesIntegers) {
+  const double kStep = std::ldexp(1.0, -kFracBits);
+  predicates::point2_t b{12.0, 12.0};
+  predicates::point2_t c{24.0, 24.0};
+
+  std::size_t num_naive_errors = 0;
+  for (int i = 0; i < 128; ++i) {
+    for (int j = 0; j < 128; ++j) {
+      predicates::point2_t a{0.5 + i * kStep, 0.5 + j * kStep};
+      utils::signs_t expected = orient2d_reference(a, b, c);
+      ASSERT_EQ(predicates::orient2d(a, b, c), expected) << i << " " << j;
+      ASSERT_EQ(predicates::orient2d(b, c, a), expected) << i << " " << j;
+      ASSERT_EQ(predicates::orient2d(c, a, b), expected) << i << " " << j;
+
+      double naive = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+      num_naive_errors += predicates::get_sign(naive) != expected;
+    }
+  }
+
+  EXPECT_GT(num_naive_errors, 0u);
+}
+
+TEST(PredicatesTest, ExpansionArithmetic) {
+  // 1 + 2^-60 - 1 loses nothing
+  auto one_plus_tiny = predicates::sum(predicates::diff(1.0, 0.0), predicates::diff(std::ldexp(1.0, -60), 0.0));
+  auto result        = predicates::sum(one_plus_tiny, predicates::negate(predicates::diff(1.0, 0.0)));
+  ASSERT_EQ(result.size, 1u);
+  EXPECT_EQ(result.components[0], std::ldexp(1.0, -60));
+
+  // (1 + 2^-30)^2 = 1 + 2^-29 + 2^-60
+  auto x      = predicates::diff(1.0 + std::ldexp(1.0, -30), 0.0);
+  auto square = predicates::product(x, x);
+  auto rest   = predicates::sum(square, predicates::diff(-1.0, std::ldexp(1.0, -29)));
+  ASSERT_EQ(rest.size, 1u);
+  EXPECT_EQ(rest.components[0], std::ldexp(1.0, -60));
+  EXPECT_EQ(predicates::get_sign(predicates::sum(square, predicates::negate(square))), utils::signs_t::ZERO);
+}
+
+TEST(PredicatesTest, SegmentsIntersect) {
+  using point = point_t<double>;
+  // crossing in space
+  EXPECT_TRUE (predicates::do_segments_intersect(point{0, 0, 0}, point{2, 2, 2}, point{0, 2, 0}, point{2, 0, 2}));
+  // skew
+  EXPECT_FALSE(predicates::do_segments_intersect(point{0, 0, 0}, point{2, 2, 0}, point{0, 2, 1}, point{2, 0, 1}));
+  // collinear, overlapping and touching at the end
+  EXPECT_TRUE (predicates::do_segments_intersect(point{0, 0, 0}, point{2, 2, 2}, point{1, 1, 1}, point{3, 3, 3}));
+  EXPECT_TRUE (predicates::do_segments_intersect(point{0, 0, 0}, point{2, 2, 2}, point{2, 2, 2}, point{3, 3, 3}));
+  // collinear, disjoint
+  EXPECT_FALSE(predicates::do_segments_intersect(point{0, 0, 0}, point{1, 1, 1}, point{2, 2, 2}, point{3, 3, 3}));
+  // point on segment and next to it
+  EXPECT_TRUE (predicates::do_segments_intersect(point{1, 1, 1}, point{1, 1, 1}, point{0, 0, 0}, point{3, 3, 3}));
+  EXPECT_FALSE(predicates::do_segments_intersect(point{1, 1, 1 + 1e-15}, point{1, 1, 1 + 1e-15},
+                                                 point{0, 0, 0}, point{3, 3, 3}));
+}
+
+TEST(PredicatesTest, SegmentIntersectsTriangle) {
+  using point = point_t<double>;
+  point a{0, 0, 0};
+  point b{2, 0, 0};
+  point c{0, 2, 0};
+
+  // piercing, touching by end, ending right above
+  EXPECT_TRUE (predicates::does_segment_intersect_triangle(point{0.5, 0.5, -1}, point{0.5, 0.5, 1}, a, b, c));
+  EXPECT_TRUE (predicates::does_segment_intersect_triangle(point{0.5, 0.5,  0}, point{0.5, 0.5, 1}, a, b, c));
+  EXPECT_FALSE(predicates::does_segment_intersect_triangle(point{0.5, 0.5, 1e-300}, point{0.5, 0.5, 1}, a, b, c));
+  // through the edge and just past it
+  EXPECT_TRUE (predicates::does_segment_intersect_triangle(point{1, 1, -1}, point{1, 1, 1}, a, b, c));
+  EXPECT_FALSE(predicates::does_segment_intersect_triangle(point{1, 1 + 1e-15, -1}, point{1, 1 + 1e-15, 1}, a, b, c));
+  // in the plane: crossing and outside
+  EXPECT_TRUE (predicates::does_segment_intersect_triangle(point{-1, 1, 0}, point{3, 1, 0}, a, b, c));
+  EXPECT_FALSE(predicates::does_segment_intersect_triangle(point{-1, 3, 0}, point{3, 3, 0}, a, b, c));
+  // point inside and outside
+  EXPECT_TRUE (predicates::does_segment_intersect_triangle(point{0.1, 0.1, 0}, point{0.1, 0.1, 0}, a, b, c));
+  EXPECT_FALSE(predicates::does_segment_intersect_triangle(point{2, 2, 0}, point{2, 2, 0}, a, b, c));
+}
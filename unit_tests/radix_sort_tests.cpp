@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "radix_sort.hpp"
+
+TEST(RadixSortTest, SortableBitsKeepFloatOrder) {
+  std::vector<float> values = {
+    -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::max(), -1e10f, -1.5f,
+    -std::numeric_limits<float>::denorm_min(), -0.0f, 0.0f, std::numeric_limits<float>::denorm_min(),
+    1e-30f, 1.0f, 1.0000001f, 3e38f, std::numeric_limits<float>::infinity()
+  };
+
+  for (std::size_t i = 0; i + 1 < values.size(); ++i) {
+    EXPECT_LT(radix_sort::to_sortable_bits(values[i]), radix_sort::to_sortable_bits(values[i + 1]))
+      << values[i] << " " << values[i + 1];
+  }
+}
+
+TEST(RadixSortTest, FloatKeysMatchStableSort) {
+  std::mt19937 gen(5);
+  std::uniform_real_distribution<float> value_distr(-1000.0f, 1000.0f);
+  std::uniform_int_distribution<int>    small_distr(-3, 3);
+
+  // pairs of key and original index, repeated keys check stability
+  std::vector<std::pair<float, std::size_t>> items;
+  for (std::size_t i = 0; i < 20000; ++i) {
+    float value = (i % 2 == 0) ? value_distr(gen) : static_cast<float>(small_distr(gen));
+    items.emplace_back(value, i);
+  }
+
+  auto expected = items;
+  std::stable_sort(expected.begin(), expected.end(),
+    [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+  radix_sort::sort(items,
+    [](const std::pair<float, std::size_t>& item) { return radix_sort::to_sortable_bits(item.first); });
+  EXPECT_EQ(items, expected);
+}
+
+TEST(RadixSortTest, WideKeysAndSkippedPasses) {
+  std::vector<std::uint64_t> keys = {std::uint64_t{1} << 40, 7, 0, std::uint64_t{1} << 40, 3, 7};
+  radix_sort::sort(keys, [](std::uint64_t key) { return key; });
+  EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+
+  // all keys share every byte but the lowest one
+  std::vector<std::uint32_t> same_high = {0xABCD0003u, 0xABCD0001u, 0xABCD0002u};
+  radix_sort::sort(same_high, [](std::uint32_t key) { return key; });
+  EXPECT_EQ(same_high, (std::vector<std::uint32_t>{0xABCD0001u, 0xABCD0002u, 0xABCD0003u}));
+
+  std::vector<std::uint32_t> empty;
+  radix_sort::sort(empty, [](std::uint32_t key) { return key; });
+  EXPECT_TRUE(empty.empty());
+}
+
+TEST(RadixSortTest, ParallelMatchesSerial) {
+  std::mt19937 gen(11);
+  std::uniform_int_distribution<std::uint32_t> key_distr(0, 1u << 20);
+
+  std::vector<std::pair<std::uint32_t, std::size_t>> items;
+  for (std::size_t i = 0; i < 30001; ++i) {
+    items.emplace_back(key_distr(gen) & ~0xF0u, i);
+  }
+  auto get_key = [](const std::pair<std::uint32_t, std::size_t>& item) { return item.first; };
+
+  auto expected = items;
+  radix_sort::sort(expected, get_key);
+  for (std::size_t num_threads : std::array<std::size_t, 3>{2, 3, 8}) {
+    auto sorted = items;
+    radix_sort::sort(sorted, get_key, num_threads);
+    EXPECT_EQ(sorted, expected) << num_threads;
+  }
+}
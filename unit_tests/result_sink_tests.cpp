@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "result_sink.hpp"
+#include "solutions_impl.hpp"
+
+namespace {
+  // sizes around buffer size, so that flushes in the middle are checked
+  std::vector<std::size_t> get_test_indices() {
+    std::vector<std::size_t> indices = {0, 1, 9, 10, 99, 100, 12345};
+    for (std::size_t ind = 200000; ind < 500000; ind += 3) {
+      indices.push_back(ind);
+    }
+    indices.push_back(std::numeric_limits<std::size_t>::max());
+    return indices;
+  }
+
+  template<typename sink_t>
+  void add_all(sink_t& sink, const std::vector<std::size_t>& indices) {
+    for (std::size_t ind : indices) {
+      sink.add(ind);
+    }
+    sink.finish();
+  }
+}
+
+TEST(ResultSinkTest, TextMatchesStreamOutput) {
+  auto indices = get_test_indices();
+  std::ostringstream expected;
+  for (std::size_t ind : indices) {
+    expected << ind << '\n';
+  }
+
+  std::ostringstream out_stream;
+  {
+    result_sink::text_sink_t sink(out_stream);
+    add_all(sink, indices);
+  }
+  EXPECT_EQ(out_stream.str(), expected.str());
+}
+
+TEST(ResultSinkTest, TextIsWrittenByDestructorWithoutFinish) {
+  std::ostringstream out_stream;
+  {
+    result_sink::text_sink_t sink(out_stream);
+    sink.add(42);
+  }
+  EXPECT_EQ(out_stream.str(), "42\n");
+}
+
+TEST(ResultSinkTest, BinaryIsLittleEndianUint64) {
+  auto indices = get_test_indices();
+  std::ostringstream out_stream;
+  {
+    result_sink::binary_sink_t sink(out_stream);
+    add_all(sink, indices);
+  }
+
+  std::string data = out_stream.str();
+  ASSERT_EQ(data.size(), indices.size() * sizeof(std::uint64_t));
+  for (std::size_t i = 0; i < indices.size(); ++i) {
+    std::uint64_t value = 0;
+    for (std::size_t j = 0; j < sizeof(value); ++j) {
+      value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[i * 8 + j])) << (8 * j);
+    }
+    EXPECT_EQ(value, indices[i]);
+  }
+}
+
+TEST(ResultSinkTest, BitmapHasBitPerTriangle) {
+  std::ostringstream out_stream;
+  result_sink::bitmap_sink_t sink(out_stream, 17);
+  add_all(sink, {0, 3, 8, 16});
+
+  std::string data = out_stream.str();
+  ASSERT_EQ(data.size(), 3u);
+  EXPECT_EQ(static_cast<unsigned char>(data[0]), 0b00001001u);
+  EXPECT_EQ(static_cast<unsigned char>(data[1]), 0b00000001u);
+  EXPECT_EQ(static_cast<unsigned char>(data[2]), 0b00000001u);
+}
+
+TEST(ResultSinkTest, ParseFormat) {
+  EXPECT_EQ(result_sink::parse_format("text"),   result_sink::format_t::TEXT);
+  EXPECT_EQ(result_sink::parse_format("binary"), result_sink::format_t::BINARY);
+  EXPECT_EQ(result_sink::parse_format("bitmap"), result_sink::format_t::BITMAP);
+  EXPECT_THROW((void)result_sink::parse_format("json"), std::invalid_argument);
+}
+
+TEST(ResultSinkTest, SolverStreamsSameIndicesAsList) {
+  std::vector<triangle_t<double>> triangles = {
+    {{-1, 1, 0}, {1, 1, 0},   {0, -1, 0}},
+    {{0, 1, 0},  {-1, -1, 0}, {1, -1, 0}},
+    {{100, 100, 100}, {101, 100, 100}, {100, 101, 100}},
+    {{0, 0, -1}, {0, 0, 1},   {0.1, 0.1, 0}}
+  };
+
+  triangles_inters_solver_t<double, opt_bvh_solution_tag> solver(triangles);
+  std::vector<std::size_t> expected = solver.get_inter_triangs_indices();
+
+  std::ostringstream out_stream;
+  result_sink::write_in_format(result_sink::format_t::TEXT, out_stream, solver.get_num_triangles(),
+    [&](auto& sink) { solver.write_inter_triangs_indices(sink); });
+
+  std::ostringstream expected_text;
+  for (std::size_t ind : expected) {
+    expected_text << ind << '\n';
+  }
+  EXPECT_EQ(out_stream.str(), expected_text.str());
+  EXPECT_EQ(expected, (std::vector<std::size_t>{0, 1, 3}));
+}
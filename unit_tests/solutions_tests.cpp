@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <array>
+
+#include "point.hpp"
+#include "triangle.hpp"
+#include "solutions_impl.hpp"
+#include "test_scenes.hpp"
+
+using test_scenes::generate_random_triangles;
+
+// the same checks for every solution, cases specific for one solution live in its own tests
+template <typename solution_tag>
+class SolutionTest : public ::testing::Test {};
+
+using solution_tags_t = ::testing::Types<
+  opt_bvh_solution_tag,
+  sweep_and_prune_solution_tag,
+  spatial_hash_solution_tag,
+  auto_solution_tag
+>;
+TYPED_TEST_SUITE(SolutionTest, solution_tags_t);
+
+TYPED_TEST(SolutionTest, EmptyAndSingle) {
+  using solver_t = triangles_inters_solver_t<double, TypeParam>;
+
+  std::vector<triangle_t<double>> triangles;
+  solver_t empty_solver{triangles};
+  EXPECT_TRUE(empty_solver.get_inter_triangs_indices().empty());
+
+  triangles.emplace_back(point_t<double>{0, 0, 0}, point_t<double>{1, 0, 0}, point_t<double>{0, 1, 0});
+  solver_t single_solver{triangles};
+  EXPECT_TRUE(single_solver.get_inter_triangs_indices().empty());
+}
+
+TYPED_TEST(SolutionTest, MarksMatchNaive) {
+  using solver_t = triangles_inters_solver_t<double, TypeParam>;
+
+  for (bool is_flat : {false, true}) {
+    for (double max_triangle_side : {0.5, 3.0}) {
+      auto triangles = generate_random_triangles(1500, 30.0, max_triangle_side, is_flat);
+      triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+      auto expected = naive_solver.get_inter_triangs_indices();
+      ASSERT_FALSE(expected.empty());
+
+      for (std::size_t num_threads : std::array<std::size_t, 3>{1, 2, 7}) {
+        solver_params_t<double> params;
+        params.num_threads = num_threads;
+        solver_t solver{triangles, params};
+        EXPECT_EQ(solver.get_inter_triangs_indices(), expected);
+      }
+    }
+  }
+}
+
+TYPED_TEST(SolutionTest, PairsAndComponentsMatchNaive) {
+  using solver_t = triangles_inters_solver_t<double, TypeParam>;
+
+  for (bool is_flat : {false, true}) {
+    auto triangles = generate_random_triangles(1200, 30.0, 3.0, is_flat);
+    triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+    auto expected_pairs = naive_solver.get_inter_triangs_pairs();
+    auto expected_ids   = naive_solver.get_components().ids;
+
+    for (std::size_t num_threads : std::array<std::size_t, 2>{1, 4}) {
+      solver_params_t<double> params;
+      params.num_threads = num_threads;
+      solver_t solver{triangles, params};
+      EXPECT_EQ(solver.get_inter_triangs_pairs(), expected_pairs);
+      EXPECT_EQ(solver.get_components().ids,      expected_ids);
+      EXPECT_EQ(solver.get_inter_triangs_pairs(5).size(), 5u);
+    }
+  }
+}
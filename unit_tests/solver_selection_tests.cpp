@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <array>
+
+#include "point.hpp"
+#include "triangle.hpp"
+#include "solutions_impl.hpp"
+#include "solver_selection.hpp"
+#include "test_scenes.hpp"
+
+using auto_solution_double_t =
+  triangles_inters_solver_t<double, auto_solution_tag>;
+
+using test_scenes::generate_random_triangles;
+
+namespace {
+  solver_selection::scene_stats_t get_stats(const std::vector<triangle_t<double>>& triangles) {
+    return solver_selection::collect_scene_stats(triangles.data(), triangles.size(),
+                                                 static_cast<const AABB_t<double>*>(nullptr));
+  }
+}
+
+TEST(SolverSelectionTest, TinyInputIsNotSampled) {
+  auto triangles = generate_random_triangles(solver_selection::kMaxNaiveTriangles, 5.0, 1.0, false);
+  auto stats = get_stats(triangles);
+  EXPECT_EQ(stats.num_triangles, triangles.size());
+  EXPECT_EQ(stats.sample_size, 0u);
+  EXPECT_EQ(solver_selection::choose_solver(stats), solver_selection::solver_kind_t::NAIVE);
+
+  std::vector<triangle_t<double>> empty;
+  EXPECT_EQ(solver_selection::choose_solver(get_stats(empty)), solver_selection::solver_kind_t::NAIVE);
+}
+
+TEST(SolverSelectionTest, SampleHasNoRepeatedTriangles) {
+  // just more than sample size, a repeated triangle would be a pair, that overlaps and hits
+  std::vector<triangle_t<double>> triangles;
+  for (std::size_t i = 0; i < solver_selection::kSampleSize + 100; ++i) {
+    double x = 10.0 * static_cast<double>(i);
+    triangles.emplace_back(point_t{x, 0.0, 0.0}, point_t{x, 1.0, 0.0}, point_t{x, 0.0, 1.0});
+  }
+
+  auto stats = get_stats(triangles);
+  EXPECT_EQ(stats.sample_size, solver_selection::kSampleSize);
+  EXPECT_DOUBLE_EQ(stats.box_overlap, 0.0);
+  EXPECT_DOUBLE_EQ(stats.planarity,   0.0);
+  EXPECT_DOUBLE_EQ(stats.hit_ratio,   0.0);
+}
+
+TEST(SolverSelectionTest, StatsDescribeScene) {
+  auto flat = get_stats(generate_random_triangles(5000, 100.0, 1.0, true));
+  EXPECT_EQ(flat.sample_size, solver_selection::kSampleSize);
+  EXPECT_DOUBLE_EQ(flat.planarity, 1.0);
+
+  auto spatial = get_stats(generate_random_triangles(5000, 100.0, 1.0, false));
+  EXPECT_LT(spatial.planarity, 0.01);
+  EXPECT_LT(spatial.size_spread, 3.0);
+  EXPECT_LE(spatial.box_overlap, spatial.cell_overlap);
+  EXPECT_LE(spatial.box_overlap, spatial.sweep_overlap);
+  EXPECT_GE(spatial.cells_per_triangle, 1.0);
+  EXPECT_LE(spatial.cells_per_triangle, 16.0);
+
+  // bigger triangles in the same scene overlap more often
+  auto dense = get_stats(generate_random_triangles(5000, 100.0, 5.0, false));
+  EXPECT_GT(dense.mean_size,   spatial.mean_size);
+  EXPECT_GT(dense.box_overlap, spatial.box_overlap);
+
+  // a single huge triangle among small ones
+  auto mixed_triangles = generate_random_triangles(300, 100.0, 1.0, false);
+  mixed_triangles.emplace_back(point_t<double>{0, 0, 0}, point_t<double>{100, 0, 0},
+                               point_t<double>{0, 100, 100});
+  EXPECT_GT(get_stats(mixed_triangles).size_spread, 10.0);
+}
+
+TEST(SolverSelectionTest, StructureIsChosenForBigScenes) {
+  auto costs = solver_selection::estimate_costs(
+    get_stats(generate_random_triangles(20000, 100.0, 1.0, false)));
+  EXPECT_GT(costs.naive, 100 * std::min({costs.BVH, costs.sweep_and_prune, costs.spatial_hash}));
+
+  auto flat = get_stats(generate_random_triangles(300, 30.0, 1.0, true));
+  EXPECT_NE(solver_selection::choose_solver(flat), solver_selection::solver_kind_t::NAIVE);
+}
+
+TEST(SolverSelectionTest, AutoSolutionMatchesNaive) {
+  for (std::size_t num_triangles : std::array<std::size_t, 3>{10, 300, 1200}) {
+    for (bool is_flat : {false, true}) {
+      auto triangles = generate_random_triangles(num_triangles, 30.0, 2.0, is_flat);
+      triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+
+      for (std::size_t num_threads : std::array<std::size_t, 2>{1, 4}) {
+        solver_params_t<double> params;
+        params.num_threads = num_threads;
+        auto_solution_double_t solver{triangles, params};
+        EXPECT_EQ(solver.get_inter_triangs_indices(), naive_solver.get_inter_triangs_indices());
+        EXPECT_EQ(solver.get_inter_triangs_pairs(),   naive_solver.get_inter_triangs_pairs());
+        EXPECT_EQ(solver.get_components().ids,        naive_solver.get_components().ids);
+      }
+    }
+  }
+}
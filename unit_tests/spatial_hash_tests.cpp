@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include <array>
+
+#include "point.hpp"
+#include "triangle.hpp"
+#include "solutions_impl.hpp"
+#include "test_scenes.hpp"
+
+using grid_solution_double_t =
+  triangles_inters_solver_t<double, spatial_hash_solution_tag>;
+
+using test_scenes::generate_random_triangles;
+
+TEST(SpatialHashTest, BigTrianglesPairsMatchNaive) {
+  auto triangles = generate_random_triangles(1200, 30.0, 3.0, false);
+  // a few big triangles cover many cells, their pairs still must be found once
+  triangles.emplace_back(point_t<double>{0, 0, 15}, point_t<double>{30, 0, 15}, point_t<double>{0, 30, 15});
+  triangles.emplace_back(point_t<double>{15, 0, 0}, point_t<double>{15, 30, 0}, point_t<double>{15, 0, 30});
+
+  triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+  auto expected_pairs = naive_solver.get_inter_triangs_pairs();
+  auto expected_ids   = naive_solver.get_components().ids;
+
+  for (std::size_t num_threads : std::array<std::size_t, 2>{1, 4}) {
+    solver_params_t<double> params;
+    params.num_threads = num_threads;
+    grid_solution_double_t solver{triangles, params};
+    EXPECT_EQ(solver.get_inter_triangs_pairs(), expected_pairs);
+    EXPECT_EQ(solver.get_components().ids,      expected_ids);
+    EXPECT_EQ(solver.get_inter_triangs_pairs(5).size(), 5u);
+  }
+}
+
+TEST(SpatialHashTest, CellSizeFollowsTriangles) {
+  auto small = generate_random_triangles(1000, 100.0, 0.5, false);
+  auto big   = generate_random_triangles(1000, 100.0, 4.0, false);
+  spatial_hash_t<double> small_grid(small);
+  spatial_hash_t<double> big_grid(big);
+
+  EXPECT_LT(small_grid.get_cell_size(), big_grid.get_cell_size());
+  // typical triangle covers a few cells, not hundreds and not the whole scene
+  EXPECT_LE(small_grid.get_num_entries(), 16 * small.size());
+  EXPECT_LE(big_grid.get_num_entries(),   16 * big.size());
+  EXPECT_GE(small_grid.get_num_buckets(), small_grid.get_num_entries());
+}
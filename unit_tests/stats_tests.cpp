@@ -0,0 +1,99 @@
+// counters are compiled only with this define, it must go before any header
+#define COLLECT_STATS
+
+#include <gtest/gtest.h>
+#include <array>
+#include <sstream>
+
+#include "BVH.hpp"
+#include "solutions_impl.hpp"
+#include "stats.hpp"
+#include "test_scenes.hpp"
+
+using test_scenes::generate_random_triangles;
+
+namespace {
+  stats::counters_t count_pairs_search(
+    const std::vector<triangle_t<double>>& triangles,
+    std::size_t                            num_threads,
+    std::size_t&                           num_pairs
+  ) {
+    BVH_t<double, float> BVH_tree(triangles);
+    stats::reset();
+    num_pairs = BVH_tree.find_intersecting_pairs(num_threads).size();
+    return stats::get_total();
+  }
+};
+
+TEST(StatsTest, BuildCountersAreCollected) {
+  ASSERT_TRUE(stats::kIsEnabled);
+  auto triangles = generate_random_triangles(5000, 100.0, 2.0);
+
+  stats::reset();
+  BVH_build_params_t<double> params;
+  params.num_threads = 4;
+  BVH_t<double> BVH_tree(triangles, params);
+  stats::counters_t counters = stats::get_total();
+
+  // at most 8 triangles in a leaf, so tree can't be shallower
+  EXPECT_GE(counters.max_depth, 10u);
+  EXPECT_LE(counters.max_depth, 64u);
+  EXPECT_GT(counters.prepare_time + counters.tree_time + counters.reorder_time + counters.batch_time, 0.0);
+  EXPECT_EQ(counters.triangle_tests, 0u);
+}
+
+// pairs search has no pruning by marks, so it tests the same pairs on any number of threads
+TEST(StatsTest, CountersOfThreadsAreMerged) {
+  auto triangles = generate_random_triangles(5000, 100.0, 2.0);
+
+  std::size_t num_pairs = 0, num_pairs_parallel = 0;
+  stats::counters_t counters          = count_pairs_search(triangles, 1, num_pairs);
+  stats::counters_t counters_parallel = count_pairs_search(triangles, 4, num_pairs_parallel);
+
+  ASSERT_GT(num_pairs, 0u);
+  EXPECT_EQ(num_pairs_parallel, num_pairs);
+  EXPECT_EQ(counters.triangle_hits,          num_pairs);
+  EXPECT_EQ(counters_parallel.triangle_hits, num_pairs);
+  EXPECT_EQ(counters_parallel.triangle_tests, counters.triangle_tests);
+  EXPECT_GT(counters.triangle_tests, counters.triangle_hits);
+  EXPECT_GT(counters.nodes_visited, 0u);
+  EXPECT_GE(counters.AABB_tests, counters.AABB_hits);
+}
+
+TEST(StatsTest, SolutionsCountNarrowPhase) {
+  auto triangles = generate_random_triangles(2000, 50.0, 2.0);
+
+  triangles_inters_solver_t<double, opt_bvh_solution_tag> BVH_solution(triangles);
+  stats::reset();
+  std::size_t num_inter = BVH_solution.get_inter_triangs_indices().size();
+  stats::counters_t BVH_counters = stats::get_total();
+
+  triangles_inters_solver_t<double, naive_solution_tag> naive_solution(triangles);
+  stats::reset();
+  EXPECT_EQ(naive_solution.get_inter_triangs_indices().size(), num_inter);
+  stats::counters_t naive_counters = stats::get_total();
+
+  ASSERT_GT(num_inter, 0u);
+  EXPECT_GT(BVH_counters.triangle_tests, 0u);
+  EXPECT_GT(BVH_counters.marked_exits,   0u);
+  // broad phase is what saves narrow phase tests
+  EXPECT_GT(naive_counters.triangle_tests, 10 * BVH_counters.triangle_tests);
+  EXPECT_EQ(naive_counters.AABB_tests, 0u);
+}
+
+TEST(StatsTest, WriteJson) {
+  stats::counters_t counters;
+  counters.nodes_visited  = 7;
+  counters.triangle_hits  = 3;
+  counters.max_depth      = 5;
+
+  std::stringstream stream;
+  stats::write_json(stream, counters);
+  std::string json = stream.str();
+  EXPECT_NE(json.find("\"enabled\": true"),      std::string::npos);
+  EXPECT_NE(json.find("\"nodes_visited\": 7"),   std::string::npos);
+  EXPECT_NE(json.find("\"triangle_hits\": 3"),   std::string::npos);
+  EXPECT_NE(json.find("\"max_depth\": 5"),       std::string::npos);
+  EXPECT_NE(json.find("\"build_ms\": {"),        std::string::npos);
+  EXPECT_EQ(json.front(), '{');
+}
@@ -0,0 +1,34 @@
+#include <gtest/gtest.h>
+
+#include "point.hpp"
+#include "triangle.hpp"
+#include "solutions_impl.hpp"
+
+using sweep_solution_double_t =
+  triangles_inters_solver_t<double, sweep_and_prune_solution_tag>;
+
+TEST(SweepAndPruneTest, SweepsAlongWidestAxis) {
+  std::vector<triangle_t<double>> triangles;
+  for (int i = 0; i < 10; ++i) {
+    double y = 10.0 * i;
+    triangles.emplace_back(point_t<double>{0, y, 0}, point_t<double>{1, y, 0}, point_t<double>{0, y + 1, 0});
+  }
+
+  sweep_and_prune_t<double> sweep(triangles);
+  EXPECT_EQ(sweep.get_sweep_axis(), utils::axis_t::Y);
+}
+
+TEST(SweepAndPruneTest, TouchingBoxesAtLargeCoordinates) {
+  // bounds differ from their float keys here, keys must be rounded outwards
+  const double base = 1e7 + 0.3;
+  std::vector<triangle_t<double>> triangles = {
+    {{base, 0, 0},     {base + 1, 0, 0}, {base, 1, 0}},
+    {{base + 1, 0, 0}, {base + 2, 0, 0}, {base + 1, 1, 0}},
+    {{base + 5, 0, 0}, {base + 6, 0, 0}, {base + 5, 1, 0}}
+  };
+
+  triangles_inters_solver_t<double, naive_solution_tag> naive_solver{triangles};
+  sweep_solution_double_t solver{triangles};
+  EXPECT_EQ(solver.get_inter_triangs_indices(), naive_solver.get_inter_triangs_indices());
+  EXPECT_EQ(solver.get_inter_triangs_indices(), (std::vector<std::size_t>{0, 1}));
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "point.hpp"
+#include "triangle.hpp"
+
+// Random scenes for tests of solutions and of their parts.
+// Seed is fixed, so a test gets the same scene on every run.
+namespace test_scenes {
+  const unsigned kSeed = 228;
+
+  // Centers of triangles are uniformly distributed in cube [0, scene_side]^3, vertices are
+  // at most max_triangle_side away from center along each axis. Flat scenes are made of
+  // well shaped triangles in plane z = 0, like in_one_plane tests.
+  inline std::vector<triangle_t<double>> generate_random_triangles(
+    std::size_t num_triangles,
+    double      scene_side,
+    double      max_triangle_side,
+    bool        is_flat = false
+  ) {
+    std::mt19937 gen(kSeed);
+    std::uniform_real_distribution<double> center_distr(0.0, scene_side);
+    std::uniform_real_distribution<double> offset_distr(-max_triangle_side, max_triangle_side);
+    std::uniform_real_distribution<double> radius_distr(0.5 * max_triangle_side, max_triangle_side);
+    std::uniform_real_distribution<double> angle_distr(0.0, 2 * M_PI);
+
+    std::vector<triangle_t<double>> triangles;
+    for (std::size_t i = 0; i < num_triangles; ++i) {
+      point_t center{center_distr(gen), center_distr(gen), is_flat ? 0.0 : center_distr(gen)};
+      std::array<point_t<double>, 3> points;
+      if (is_flat) {
+        double angle = angle_distr(gen);
+        for (auto& point : points) {
+          double radius = radius_distr(gen);
+          point = center + point_t{radius * std::cos(angle), radius * std::sin(angle), 0.0};
+          angle += 2 * M_PI / 3;
+        }
+      } else {
+        for (auto& point : points) {
+          point = center + point_t{offset_distr(gen), offset_distr(gen), offset_distr(gen)};
+        }
+      }
+      triangles.emplace_back(points[0], points[1], points[2]);
+    }
+
+    return triangles;
+  }
+};
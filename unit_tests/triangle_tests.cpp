@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 #include "point.hpp"
 #include "triangle.hpp"
+#include "prepared_triangle.hpp"
+
+#include <cmath>
+#include <random>
 
 TEST(TriangleTest, ConstructorFromThreePoints) {
   point_t p1{1.234, 2.345, 3.456};
@@ -863,3 +867,185 @@ TEST(TriangleSegmentTest, SegmentEndpointInsideTriangle2) {
   
   EXPECT_TRUE(tri.is_intersected_by_segm(segment_t{seg_start, seg_end}));
 }
+
+// Tests for triangle props and prepared_triangle_t
+
+TEST(TrianglePropsTest, DegeneracyClass) {
+  triangle_t<double> proper{{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}};
+  triangle_t<double> segm  {{0.0, 0.0, 0.0}, {1.0, 1.0, 1.0}, {2.0, 2.0, 2.0}};
+  triangle_t<double> point {{1.0, 2.0, 3.0}, {1.0, 2.0, 3.0}, {1.0, 2.0, 3.0}};
+
+  EXPECT_EQ(proper.get_props().degeneracy, degeneracy_t::NONE);
+  EXPECT_EQ(segm  .get_props().degeneracy, degeneracy_t::SEGMENT);
+  EXPECT_EQ(point .get_props().degeneracy, degeneracy_t::POINT);
+}
+
+TEST(TrianglePropsTest, SegmentStartsWithMiddlePoint) {
+  triangle_t<double> segm {{1.0, 1.0, 0.0}, {0.0, 2.0, 0.0}, {2.0, 0.0, 0.0}};
+  triangle_t<double> other{{2.0, 0.0, 2.0}, {2.0, 0.0, 1.0}, {2.0, 0.0, 0.0}};
+
+  // covering segment goes from the second point to the third one
+  EXPECT_TRUE(segm.does_intersect(other, triangle_inters_kernel_t::EDGES));
+  EXPECT_TRUE(segm.does_intersect(other, triangle_inters_kernel_t::PLANE_SIDES));
+  EXPECT_TRUE(other.does_intersect(segm));
+}
+
+namespace {
+  // small integer grid, so there are plenty of touching, coplanar and degenerate triangles
+  std::vector<triangle_t<double>> generate_grid_triangles(std::size_t num_triangles, int grid_side) {
+    std::mt19937 gen(228);
+    std::uniform_int_distribution<int> coord(0, grid_side);
+    auto random_point = [&]() {
+      return point_t<double>{
+        static_cast<double>(coord(gen)),
+        static_cast<double>(coord(gen)),
+        static_cast<double>(coord(gen))
+      };
+    };
+
+    std::vector<triangle_t<double>> triangles;
+    for (std::size_t i = 0; i < num_triangles; ++i) {
+      triangles.emplace_back(random_point(), random_point(), random_point());
+    }
+
+    return triangles;
+  }
+};
+
+TEST(PreparedTriangleTest, MatchesTriangleOnRandomPairs) {
+  const std::size_t kNumTriangles = 200;
+  std::vector<triangle_t<double>> triangles = generate_grid_triangles(kNumTriangles, 3);
+  std::vector<prepared_triangle_t<double>> prepared(triangles.begin(), triangles.end());
+
+  for (std::size_t i = 0; i < kNumTriangles; ++i) {
+    for (std::size_t j = 0; j < kNumTriangles; ++j) {
+      ASSERT_EQ(prepared[i].does_intersect(prepared[j]),
+                triangles[i].does_intersect(triangles[j])) << i << " " << j;
+    }
+  }
+}
+
+// Tests for intersection kernels
+
+TEST(TriangleKernelTest, PlaneSidesMatchesEdgesOnRandomPairs) {
+  for (int grid_side : {2, 3, 6}) {
+    const std::size_t kNumTriangles = 300;
+    std::vector<triangle_t<double>> triangles = generate_grid_triangles(kNumTriangles, grid_side);
+
+    for (std::size_t i = 0; i < kNumTriangles; ++i) {
+      for (std::size_t j = 0; j < kNumTriangles; ++j) {
+        ASSERT_EQ(triangles[i].does_intersect(triangles[j], triangle_inters_kernel_t::PLANE_SIDES),
+                  triangles[i].does_intersect(triangles[j], triangle_inters_kernel_t::EDGES))
+          << triangles[i] << " " << triangles[j];
+      }
+    }
+  }
+}
+
+TEST(TriangleKernelTest, PlaneSidesTouchingAndCoplanar) {
+  const auto kKernel = triangle_inters_kernel_t::PLANE_SIDES;
+  triangle_t<double> base{{0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {0.0, 2.0, 0.0}};
+
+  // vertex touches interior of the other triangle
+  EXPECT_TRUE (base.does_intersect({{0.5, 0.5, 0.0}, {0.5, 0.5, 1.0}, {1.0, 0.5, 1.0}}, kKernel));
+  // crosses the plane outside of the triangle
+  EXPECT_FALSE(base.does_intersect({{3.0, 3.0, -1.0}, {3.0, 3.0, 1.0}, {4.0, 3.0, 1.0}}, kKernel));
+  // whole triangle above the plane
+  EXPECT_FALSE(base.does_intersect({{0.0, 0.0, 1.0}, {1.0, 0.0, 1.0}, {0.0, 1.0, 2.0}}, kKernel));
+  // coplanar, one inside another
+  EXPECT_TRUE (base.does_intersect({{0.2, 0.2, 0.0}, {0.5, 0.2, 0.0}, {0.2, 0.5, 0.0}}, kKernel));
+  // coplanar, disjoint
+  EXPECT_FALSE(base.does_intersect({{3.0, 3.0, 0.0}, {4.0, 3.0, 0.0}, {3.0, 4.0, 0.0}}, kKernel));
+  // degenerate segment piercing the triangle
+  EXPECT_TRUE (base.does_intersect({{0.5, 0.5, -1.0}, {0.5, 0.5, 1.0}, {0.5, 0.5, 0.0}}, kKernel));
+}
+
+// Tests for exact predicates
+
+TEST(ExactPredicatesTest, MatchesEpsilonOnIntegerGrid) {
+  // determinants of small integers are exact in doubles, so epsilon doesn't change anything
+  for (int grid_side : {2, 3, 6}) {
+    const std::size_t kNumTriangles = 300;
+    std::vector<triangle_t<double>> triangles = generate_grid_triangles(kNumTriangles, grid_side);
+
+    for (std::size_t i = 0; i < kNumTriangles; ++i) {
+      for (std::size_t j = 0; j < kNumTriangles; ++j) {
+        ASSERT_EQ(triangles[i].does_intersect<predicates::exact_predicates_t>(triangles[j]),
+                  triangles[i].does_intersect(triangles[j]))
+          << triangles[i] << " " << triangles[j];
+      }
+    }
+  }
+}
+
+TEST(ExactPredicatesTest, KernelMatchesPolicy) {
+  const std::size_t kNumTriangles = 200;
+  std::vector<triangle_t<double>> triangles = generate_grid_triangles(kNumTriangles, 3);
+  std::vector<prepared_triangle_t<double>> prepared(triangles.begin(), triangles.end());
+
+  for (std::size_t i = 0; i < kNumTriangles; ++i) {
+    for (std::size_t j = 0; j < kNumTriangles; ++j) {
+      ASSERT_EQ(prepared[i].does_intersect(prepared[j], triangle_inters_kernel_t::EXACT),
+                triangles[i].does_intersect<predicates::exact_predicates_t>(triangles[j])) << i << " " << j;
+    }
+  }
+}
+
+TEST(ExactPredicatesTest, SmallTriangles) {
+  // parallel planes 1e-5 apart, epsilon version sees them as coplanar
+  triangle_t<double> base {{0.0, 0.0, 0.0},  {1e-3, 0.0, 0.0},  {0.0, 1e-3, 0.0}};
+  triangle_t<double> above{{0.0, 0.0, 1e-5}, {1e-3, 0.0, 1e-5}, {0.0, 1e-3, 1e-5}};
+  EXPECT_FALSE(base.does_intersect<predicates::exact_predicates_t>(above));
+  EXPECT_TRUE (base.does_intersect<predicates::exact_predicates_t>(base));
+
+  // tiny, but not degenerate triangle, pierced by other one
+  triangle_t<double> tiny {{0.0, 0.0, 0.0}, {1e-9, 0.0, 0.0}, {0.0, 1e-9, 0.0}};
+  triangle_t<double> spike{{2e-10, 2e-10, -1.0}, {2e-10, 2e-10, 1.0}, {1.0, 1.0, 1.0}};
+  triangle_t<double> miss {{2e-9, 2e-9, -1.0},   {2e-9, 2e-9, 1.0},   {1.0, 1.0, 1.0}};
+  EXPECT_TRUE (tiny.does_intersect<predicates::exact_predicates_t>(spike));
+  EXPECT_FALSE(tiny.does_intersect<predicates::exact_predicates_t>(miss));
+}
+
+TEST(ExactPredicatesTest, LargeCoordinates) {
+  const double kShift = std::ldexp(1.0, -30);
+  triangle_t<double> base{{1e6, 0.0, 0.0}, {1e6 + 1.0, 0.0, 0.0}, {1e6, 1.0, 0.0}};
+
+  // vertex lies exactly on the hypotenuse
+  triangle_t<double> touching{{1e6 + 0.5, 0.5, 0.0}, {1e6 + 0.5, 0.5, 1.0}, {1e6 + 1.5, 1.5, 1.0}};
+  // the same, moved away from the hypotenuse by 2^-30
+  triangle_t<double> outside{{1e6 + 0.5 + kShift, 0.5, 0.0}, {1e6 + 0.5 + kShift, 0.5, 1.0},
+                             {1e6 + 1.5 + kShift, 1.5, 1.0}};
+  EXPECT_TRUE (base.does_intersect<predicates::exact_predicates_t>(touching));
+  EXPECT_TRUE (touching.does_intersect<predicates::exact_predicates_t>(base));
+  EXPECT_FALSE(base.does_intersect<predicates::exact_predicates_t>(outside));
+  EXPECT_FALSE(outside.does_intersect<predicates::exact_predicates_t>(base));
+}
+
+TEST(ExactPredicatesTest, DegenerateTriangles) {
+  using exact_t = predicates::exact_predicates_t;
+  triangle_t<double> base{{0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {0.0, 2.0, 0.0}};
+
+  // segments: piercing, ending right above the plane, lying in the plane
+  EXPECT_TRUE (base.does_intersect<exact_t>({{0.5, 0.5, -1.0}, {0.5, 0.5, 1.0}, {0.5, 0.5, 0.0}}));
+  EXPECT_FALSE(base.does_intersect<exact_t>({{0.5, 0.5, 1e-300}, {0.5, 0.5, 1.0}, {0.5, 0.5, 0.5}}));
+  EXPECT_TRUE (base.does_intersect<exact_t>({{-1.0, 1.0, 0.0}, {3.0, 1.0, 0.0}, {1.0, 1.0, 0.0}}));
+  // points: inside and just outside
+  EXPECT_TRUE (base.does_intersect<exact_t>({{1.0, 1.0, 0.0}, {1.0, 1.0, 0.0}, {1.0, 1.0, 0.0}}));
+  EXPECT_FALSE(base.does_intersect<exact_t>({{1.0, 1.0 + 1e-15, 0.0}, {1.0, 1.0 + 1e-15, 0.0},
+                                            {1.0, 1.0 + 1e-15, 0.0}}));
+
+  // both degenerate: collinear segments and point on segment
+  triangle_t<double> segm{{0.0, 0.0, 0.0}, {2.0, 2.0, 2.0}, {1.0, 1.0, 1.0}};
+  EXPECT_TRUE (segm.does_intersect<exact_t>({{2.0, 2.0, 2.0}, {3.0, 3.0, 3.0}, {4.0, 4.0, 4.0}}));
+  EXPECT_FALSE(segm.does_intersect<exact_t>({{3.0, 3.0, 3.0}, {3.0, 3.0, 3.0}, {4.0, 4.0, 4.0}}));
+  EXPECT_TRUE (segm.does_intersect<exact_t>({{0.5, 0.5, 0.5}, {0.5, 0.5, 0.5}, {0.5, 0.5, 0.5}}));
+  EXPECT_TRUE (segm.does_intersect<exact_t>({{0.0, 2.0, 0.0}, {2.0, 0.0, 2.0}, {0.0, 2.0, 0.0}}));
+}
+
+TEST(ExactPredicatesTest, FloatCoordinates) {
+  triangle_t<float> base {{0.0f, 0.0f, 0.0f}, {1e-3f, 0.0f, 0.0f}, {0.0f, 1e-3f, 0.0f}};
+  triangle_t<float> above{{0.0f, 0.0f, 1e-6f}, {1e-3f, 0.0f, 1e-6f}, {0.0f, 1e-3f, 1e-6f}};
+  triangle_t<float> cross{{2e-4f, 2e-4f, -1e-6f}, {2e-4f, 2e-4f, 1e-6f}, {1.0f, 1.0f, 1e-6f}};
+  EXPECT_FALSE(base.does_intersect<predicates::exact_predicates_t>(above));
+  EXPECT_TRUE (base.does_intersect<predicates::exact_predicates_t>(cross));
+}
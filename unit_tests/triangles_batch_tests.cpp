@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include "triangles_batch.hpp"
+#include "test_scenes.hpp"
+
+static std::vector<prepared_triangle_t<double>> generate_prepared_triangles(
+  std::size_t num_triangles, double scene_side, double max_triangle_side
+) {
+  auto random_triangles = test_scenes::generate_random_triangles(num_triangles, scene_side, max_triangle_side);
+  std::vector<prepared_triangle_t<double>> triangles(random_triangles.begin(), random_triangles.end());
+
+  // some degenerate ones
+  triangles.emplace_back(point_t{1.0, 1.0, 1.0}, point_t{2.0, 2.0, 2.0}, point_t{3.0, 3.0, 3.0});
+  triangles.emplace_back(point_t{2.0, 2.0, 2.0}, point_t{2.0, 2.0, 2.0}, point_t{2.0, 2.0, 2.0});
+
+  return triangles;
+}
+
+static std::vector<triangles_batch::mask_func_t<double>> get_supported_mask_funcs() {
+  std::vector<triangles_batch::mask_func_t<double>> funcs = {&triangles_batch::get_mask_scalar<double>};
+#ifdef TRIANGLES_BATCH_X86
+  funcs.push_back(&triangles_batch::get_mask_sse2);
+  if (__builtin_cpu_supports("avx2")) {
+    funcs.push_back(&triangles_batch::get_mask_avx2);
+  }
+#endif
+
+  return funcs;
+}
+
+static std::vector<std::size_t> get_candidates(
+  const triangles_batch_t<double>&          batch,
+  const triangles_batch_t<double>::query_t& query,
+  std::size_t                               begin,
+  std::size_t                               end
+) {
+  std::vector<std::size_t> candidates;
+  static_cast<void>(batch.for_each_candidate(query, begin, end, [&](std::size_t pos) {
+    candidates.push_back(pos);
+    return false;
+  }));
+
+  return candidates;
+}
+
+TEST(TrianglesBatchTest, AllKernelsGiveSameCandidates) {
+  auto triangles = generate_prepared_triangles(300, 10.0, 2.0);
+  // leaves of different sizes, including ones longer than one mask
+  std::vector<std::size_t> leaf_begins = {0, 1, 3, 70, 75, 200, 201};
+  std::vector<triangles_batch_t<double>> batches;
+  for (auto func : get_supported_mask_funcs()) {
+    batches.emplace_back(triangles, leaf_begins, func);
+  }
+
+  for (auto kernel : {triangle_inters_kernel_t::EDGES, triangle_inters_kernel_t::PLANE_SIDES}) {
+    for (const auto& triangle : triangles) {
+      auto query = triangles_batch_t<double>::make_query(triangle, kernel);
+      // whole leaves and their parts with odd bounds
+      for (auto [begin, end] : {std::pair<std::size_t, std::size_t>{0, 1}, {1, 3}, {3, 70}, {5, 69},
+                                {70, 75}, {72, 73}, {75, 200}, {201, triangles.size()}}) {
+        auto expected = get_candidates(batches.front(), query, begin, end);
+        for (std::size_t i = 1; i < batches.size(); ++i) {
+          ASSERT_EQ(get_candidates(batches[i], query, begin, end), expected);
+        }
+      }
+    }
+  }
+}
+
+TEST(TrianglesBatchTest, NoIntersectingTriangleIsFilteredOut) {
+  auto triangles = generate_prepared_triangles(300, 10.0, 2.0);
+  triangles_batch_t<double> batch(triangles, {0});
+
+  for (auto kernel : {triangle_inters_kernel_t::EDGES, triangle_inters_kernel_t::PLANE_SIDES}) {
+    for (const auto& triangle : triangles) {
+      auto query = triangles_batch_t<double>::make_query(triangle, kernel);
+      auto candidates = get_candidates(batch, query, 0, triangles.size());
+
+      std::vector<std::size_t> expected;
+      for (std::size_t pos = 0; pos < triangles.size(); ++pos) {
+        if (triangle.get_AABB().does_inter(triangles[pos].get_AABB()) &&
+            triangle.does_intersect(triangles[pos], kernel)) {
+          expected.push_back(pos);
+        }
+      }
+
+      std::vector<std::size_t> found;
+      for (std::size_t pos : candidates) {
+        if (triangle.does_intersect(triangles[pos], kernel)) {
+          found.push_back(pos);
+        }
+      }
+      ASSERT_EQ(found, expected);
+    }
+  }
+}
+
+TEST(TrianglesBatchTest, PlaneSidesRejectsParallelTriangles) {
+  // boxes of all triangles overlap, but they lie on parallel planes
+  std::vector<prepared_triangle_t<double>> triangles;
+  for (std::size_t i = 0; i < 10; ++i) {
+    double z = static_cast<double>(i) * 0.1;
+    triangles.emplace_back(point_t{0.0, 0.0, z}, point_t{1.0, 0.0, z + 1.0}, point_t{0.0, 1.0, z});
+  }
+  triangles_batch_t<double> batch(triangles, {0});
+
+  auto query = triangles_batch_t<double>::make_query(triangles[0], triangle_inters_kernel_t::PLANE_SIDES);
+  EXPECT_EQ(get_candidates(batch, query, 0, triangles.size()), (std::vector<std::size_t>{0}));
+
+  query = triangles_batch_t<double>::make_query(triangles[0], triangle_inters_kernel_t::EDGES);
+  EXPECT_EQ(get_candidates(batch, query, 0, triangles.size()).size(), triangles.size());
+}
+
+TEST(TrianglesBatchTest, StopsOnFirstHit) {
+  auto triangles = generate_prepared_triangles(100, 1.0, 1.0);
+  triangles_batch_t<double> batch(triangles, {0});
+  auto query = triangles_batch_t<double>::make_query(triangles[0], triangle_inters_kernel_t::EDGES);
+
+  std::size_t num_calls = 0;
+  EXPECT_TRUE(batch.for_each_candidate(query, 0, triangles.size(), [&](std::size_t) {
+    ++num_calls;
+    return true;
+  }));
+  EXPECT_EQ(num_calls, 1);
+}
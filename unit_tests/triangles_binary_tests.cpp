@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "triangle.hpp"
+#include "triangles_binary.hpp"
+#include "solutions_impl.hpp"
+
+namespace {
+  std::vector<triangle_t<double>> generate_triangles(std::size_t num_triangles) {
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> coord(-10.0, 10.0);
+    std::uniform_real_distribution<double> offset(-1.0, 1.0);
+
+    std::vector<triangle_t<double>> triangles;
+    for (std::size_t i = 0; i < num_triangles; ++i) {
+      point_t<double> a(coord(gen), coord(gen), coord(gen));
+      point_t<double> b = a + point_t<double>(offset(gen), offset(gen), offset(gen));
+      point_t<double> c = a + point_t<double>(offset(gen), offset(gen), offset(gen));
+      triangles.emplace_back(a, b, c);
+    }
+
+    return triangles;
+  }
+
+  template<typename T>
+  std::string to_binary(const std::vector<triangle_t<double>>& triangles, bool with_boxes) {
+    std::ostringstream out_stream;
+    triangles_binary::write<T>(out_stream, triangles, with_boxes);
+    return out_stream.str();
+  }
+
+  void expect_same_points(const triangle_t<double>& lhs, const triangle_t<double>& rhs) {
+    auto lhs_points = lhs.get_points();
+    auto rhs_points = rhs.get_points();
+    for (std::size_t j = 0; j < 3; ++j) {
+      EXPECT_EQ(lhs_points[j].x, rhs_points[j].x);
+      EXPECT_EQ(lhs_points[j].y, rhs_points[j].y);
+      EXPECT_EQ(lhs_points[j].z, rhs_points[j].z);
+    }
+  }
+}
+
+TEST(TrianglesBinaryTest, ViewMatchesWrittenTriangles) {
+  auto triangles = generate_triangles(100);
+  std::string data = to_binary<double>(triangles, true);
+
+  triangles_binary::header_t header;
+  auto view = triangles_binary::get_view<double>(data, header);
+  ASSERT_EQ(view.num_triangles, triangles.size());
+  ASSERT_NE(view.triangles, nullptr);
+  ASSERT_NE(view.boxes,     nullptr);
+  EXPECT_EQ(header.coords_offset % triangles_binary::kDataAlign, 0u);
+  EXPECT_EQ(header.boxes_offset  % triangles_binary::kDataAlign, 0u);
+
+  for (std::size_t i = 0; i < triangles.size(); ++i) {
+    expect_same_points(view.triangles[i], triangles[i]);
+
+    AABB_t<double> box(triangles[i]);
+    EXPECT_EQ(view.boxes[i].get_min_corner().x, box.get_min_corner().x);
+    EXPECT_EQ(view.boxes[i].get_min_corner().z, box.get_min_corner().z);
+    EXPECT_EQ(view.boxes[i].get_max_corner().y, box.get_max_corner().y);
+  }
+}
+
+TEST(TrianglesBinaryTest, NoBoxesUnlessAsked) {
+  auto triangles = generate_triangles(10);
+  std::string data = to_binary<double>(triangles, false);
+
+  triangles_binary::header_t header;
+  auto view = triangles_binary::get_view<double>(data, header);
+  EXPECT_EQ(view.num_triangles, triangles.size());
+  EXPECT_EQ(view.boxes, nullptr);
+  EXPECT_EQ(header.flags & triangles_binary::HAS_BOXES, 0u);
+}
+
+TEST(TrianglesBinaryTest, OtherScalarTypeIsConverted) {
+  auto triangles = generate_triangles(50);
+  std::string data = to_binary<float>(triangles, false);
+
+  triangles_binary::header_t header;
+  auto view = triangles_binary::get_view<double>(data, header);
+  EXPECT_EQ(view.triangles, nullptr);
+  EXPECT_EQ(header.scalar_type, triangles_binary::scalar_type_t::FLOAT32);
+
+  auto converted = triangles_binary::copy_triangles<double>(data);
+  ASSERT_EQ(converted.size(), triangles.size());
+  for (std::size_t i = 0; i < triangles.size(); ++i) {
+    auto points   = converted[i].get_points();
+    auto expected = triangles[i].get_points();
+    for (std::size_t j = 0; j < 3; ++j) {
+      EXPECT_EQ(points[j].x, static_cast<double>(static_cast<float>(expected[j].x)));
+      EXPECT_EQ(points[j].y, static_cast<double>(static_cast<float>(expected[j].y)));
+      EXPECT_EQ(points[j].z, static_cast<double>(static_cast<float>(expected[j].z)));
+    }
+  }
+}
+
+TEST(TrianglesBinaryTest, RejectsMalformedFiles) {
+  std::string data = to_binary<double>(generate_triangles(10), true);
+  triangles_binary::header_t header;
+
+  std::string bad_magic = data;
+  bad_magic[0] = 'X';
+  EXPECT_THROW((void)triangles_binary::get_view<double>(bad_magic, header), std::invalid_argument);
+
+  std::string bad_version = data;
+  bad_version[8] = 7;
+  EXPECT_THROW((void)triangles_binary::get_view<double>(bad_version, header), std::invalid_argument);
+
+  std::string truncated = data.substr(0, data.size() - 1);
+  EXPECT_THROW((void)triangles_binary::get_view<double>(truncated, header), std::invalid_argument);
+
+  std::string header_only = data.substr(0, sizeof(triangles_binary::header_t) - 1);
+  EXPECT_THROW((void)triangles_binary::get_view<double>(header_only, header), std::invalid_argument);
+}
+
+TEST(TrianglesBinaryTest, RejectsBoxesNotContainingTriangles) {
+  auto triangles = generate_triangles(10);
+  std::string data = to_binary<double>(triangles, true);
+  triangles_binary::header_t header;
+  (void)triangles_binary::get_view<double>(data, header);
+
+  // box of other triangle, as in a file, where triangles were changed, but boxes weren't
+  std::string stale = data;
+  AABB_t<double> other_box(triangles[0]);
+  std::memcpy(stale.data() + header.boxes_offset + 3 * sizeof(AABB_t<double>), &other_box, sizeof(other_box));
+  EXPECT_THROW((void)triangles_binary::get_view<double>(stale, header), std::invalid_argument);
+
+  // NaN in min corner of the last box
+  std::string with_nan = data;
+  double nan = std::numeric_limits<double>::quiet_NaN();
+  std::memcpy(with_nan.data() + header.boxes_offset + 9 * sizeof(AABB_t<double>), &nan, sizeof(nan));
+  EXPECT_THROW((void)triangles_binary::get_view<double>(with_nan, header), std::invalid_argument);
+
+  // the same file without boxes flag is fine, its boxes are not used
+  std::string without_flag = stale;
+  header.flags &= ~static_cast<std::uint32_t>(triangles_binary::HAS_BOXES);
+  std::memcpy(without_flag.data(), &header, sizeof(header));
+  auto view = triangles_binary::get_view<double>(without_flag, header);
+  EXPECT_EQ(view.boxes, nullptr);
+  EXPECT_EQ(view.num_triangles, triangles.size());
+}
+
+TEST(TrianglesBinaryTest, SolverReadsMappedFileInPlace) {
+  auto triangles = generate_triangles(2000);
+  const std::string path = testing::TempDir() + "triangles_binary_test.bin";
+  {
+    std::ofstream out_stream(path, std::ios::binary);
+    triangles_binary::write<double>(out_stream, triangles, true);
+  }
+
+  triangles_inters_solver_t<double, opt_bvh_solution_tag> from_file;
+  from_file.input_file(path);
+  triangles_inters_solver_t<double, opt_bvh_solution_tag> from_vector(triangles);
+  EXPECT_EQ(from_file.get_inter_triangs_indices(), from_vector.get_inter_triangs_indices());
+
+  triangles_inters_solver_t<double, naive_solution_tag> naive_from_file;
+  naive_from_file.input_file(path);
+  EXPECT_EQ(naive_from_file.get_inter_triangs_indices(), from_vector.get_inter_triangs_indices());
+
+  std::remove(path.c_str());
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "triangle.hpp"
+#include "triangles_input.hpp"
+
+namespace {
+  // message of std::invalid_argument thrown by parse_coords, empty if nothing was thrown
+  std::string get_parse_error(const std::string& text) {
+    try {
+      auto parsed = triangles_input::parse_coords<double>(text);
+      (void)parsed;
+    } catch (const std::invalid_argument& error) {
+      return error.what();
+    }
+
+    return {};
+  }
+}
+
+TEST(TrianglesInputTest, ParsesCoordinatesInOrder) {
+  auto parsed = triangles_input::parse_coords<double>(
+    "2\n"
+    "-1 1 0 1 1 0 0 -1 0\n"
+    "0 1 0 -1 -1 0 1 -1 0.5\n");
+
+  ASSERT_EQ(parsed.num_triangles, 2u);
+  std::vector<double> expected = {-1, 1, 0, 1, 1, 0, 0, -1, 0,
+                                   0, 1, 0, -1, -1, 0, 1, -1, 0.5};
+  EXPECT_EQ(parsed.coords, expected);
+}
+
+TEST(TrianglesInputTest, AnyWhitespaceSeparatesNumbers) {
+  auto parsed = triangles_input::parse_coords<double>(
+    "  1\r\n\n0 0 0\t\n+1.5 0 0\n\n 0 1e1 -0  \n\n");
+
+  ASSERT_EQ(parsed.num_triangles, 1u);
+  std::vector<double> expected = {0, 0, 0, 1.5, 0, 0, 0, 10, 0};
+  EXPECT_EQ(parsed.coords, expected);
+}
+
+TEST(TrianglesInputTest, EmptyListOfTriangles) {
+  auto parsed = triangles_input::parse_coords<double>("0\n");
+  EXPECT_EQ(parsed.num_triangles, 0u);
+  EXPECT_TRUE(parsed.coords.empty());
+}
+
+TEST(TrianglesInputTest, MatchesStreamOperatorOnRandomInput) {
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<double> coord(-1000.0, 1000.0);
+  const std::size_t num_triangles = 500;
+
+  std::ostringstream text;
+  text.precision(17);
+  text << num_triangles << '\n';
+  for (std::size_t i = 0; i < num_triangles * triangles_input::kCoordsPerTriangle; ++i) {
+    text << coord(gen) << ((i % 3 == 2) ? '\n' : ' ');
+  }
+
+  std::istringstream bulk_stream(text.str());
+  std::vector<triangle_t<double>> bulk = triangles_input::read_triangles<double>(bulk_stream);
+
+  std::istringstream stream(text.str());
+  std::size_t num_read = 0;
+  stream >> num_read;
+  ASSERT_EQ(num_read, num_triangles);
+  ASSERT_EQ(bulk.size(), num_triangles);
+  for (std::size_t i = 0; i < num_triangles; ++i) {
+    triangle_t<double> triangle;
+    stream >> triangle;
+    auto expected = triangle.get_points();
+    auto points   = bulk[i].get_points();
+    for (std::size_t j = 0; j < 3; ++j) {
+      EXPECT_EQ(points[j].x, expected[j].x);
+      EXPECT_EQ(points[j].y, expected[j].y);
+      EXPECT_EQ(points[j].z, expected[j].z);
+    }
+  }
+}
+
+TEST(TrianglesInputTest, ReportsLineOfMalformedNumber) {
+  std::string error = get_parse_error(
+    "2\n"
+    "0 0 0 1 0 0 0 1 0\n"
+    "0 0 0 1 0x 0 0 1 0\n");
+  EXPECT_NE(error.find("line 3"),                   std::string::npos) << error;
+  EXPECT_NE(error.find("coordinate of triangle 1"), std::string::npos) << error;
+  EXPECT_NE(error.find("\"0x\""),                   std::string::npos) << error;
+}
+
+TEST(TrianglesInputTest, ReportsTruncatedInput) {
+  std::string error = get_parse_error(
+    "2\n"
+    "0 0 0 1 0 0 0 1 0\n"
+    "0 0 0 1 0 0 0 1\n");
+  EXPECT_NE(error.find("line 4"),       std::string::npos) << error;
+  EXPECT_NE(error.find("end of input"), std::string::npos) << error;
+}
+
+TEST(TrianglesInputTest, RejectsBadHeader) {
+  EXPECT_NE(get_parse_error("").find("number of triangles"),      std::string::npos);
+  EXPECT_NE(get_parse_error("-1\n").find("number of triangles"),  std::string::npos);
+  EXPECT_NE(get_parse_error("1.5\n").find("number of triangles"), std::string::npos);
+  EXPECT_NE(get_parse_error("1000000000000\n0 0 0\n").find("too short"), std::string::npos);
+  EXPECT_NE(get_parse_error("1\n0 0 0 1 0 0 0 1 nan\n").find("line 2"), std::string::npos);
+  EXPECT_TRUE(get_parse_error("1\n0 0 0 1 0 0 0 1 0").empty());
+}
+
+TEST(TrianglesInputTest, IgnoresDataAfterLastTriangle) {
+  auto parsed = triangles_input::parse_coords<double>("1\n0 0 0 1 0 0 0 1 0\n\n7 x\n");
+  ASSERT_EQ(parsed.num_triangles, 1u);
+  EXPECT_EQ(parsed.coords.size(), triangles_input::kCoordsPerTriangle);
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "union_find.hpp"
+
+TEST(UnionFindTest, SingletonsAtStart) {
+  concurrent_union_find_t union_find(5);
+  EXPECT_EQ(union_find.get_size(), 5u);
+  for (std::size_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(union_find.find(i), i);
+  }
+  EXPECT_FALSE(union_find.is_same(0, 4));
+}
+
+TEST(UnionFindTest, IdIsSmallestIndexOfSet) {
+  concurrent_union_find_t union_find(8);
+  EXPECT_TRUE(union_find.unite(7, 3));
+  EXPECT_TRUE(union_find.unite(3, 5));
+  EXPECT_FALSE(union_find.unite(5, 7));
+  EXPECT_TRUE(union_find.unite(6, 1));
+  EXPECT_TRUE(union_find.is_same(7, 5));
+  EXPECT_FALSE(union_find.is_same(1, 3));
+
+  EXPECT_EQ(union_find.get_set_ids(), (std::vector<std::size_t>{0, 1, 2, 3, 4, 3, 1, 3}));
+}
+
+TEST(UnionFindTest, ConcurrentUnitesMatchSequential) {
+  const std::size_t size = 20000;
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<std::size_t> index(0, size - 1);
+  std::vector<std::pair<std::size_t, std::size_t>> edges;
+  for (std::size_t i = 0; i < size / 2; ++i) {
+    edges.emplace_back(index(gen), index(gen));
+  }
+
+  concurrent_union_find_t expected(size);
+  for (auto [first, second] : edges) {
+    expected.unite(first, second);
+  }
+
+  const std::size_t num_threads = 4;
+  concurrent_union_find_t union_find(size);
+  std::vector<std::thread> threads;
+  for (std::size_t thread_ind = 0; thread_ind < num_threads; ++thread_ind) {
+    threads.emplace_back([&, thread_ind]() {
+      for (std::size_t i = thread_ind; i < edges.size(); i += num_threads) {
+        union_find.unite(edges[i].first, edges[i].second);
+        EXPECT_TRUE(union_find.is_same(edges[i].second, edges[i].first));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(union_find.get_set_ids(), expected.get_set_ids());
+}
@@ -0,0 +1,64 @@
+#include <iostream>
+#include <stdexcept>
+
+#include "logLib.hpp"
+#include "cmd_args.hpp"
+#include "solutions_impl.hpp"
+#include "solver_output.hpp"
+
+int main(int argc, char** argv) {
+  cmd_args_t args;
+  try {
+    args = cmd_args::parse(argc, argv);
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << '\n' << cmd_args::kUsage << std::endl;
+    return 1;
+  }
+
+  solver_params_t<double> params = get_solver_params<double>(args);
+
+  triangles_inters_solver_t<double, auto_solution_tag> auto_solution(params);
+  try {
+    if (args.input_path.empty()) {
+      auto_solution.input();
+    } else {
+      auto_solution.input_file(args.input_path);
+    }
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+
+  // choice goes to stderr, so output is the same as of the chosen solution
+  const solver_selection::scene_stats_t& stats = auto_solution.get_scene_stats();
+  solver_selection::costs_t costs = solver_selection::estimate_costs(stats);
+  const char* solver_name = solver_selection::get_solver_name(auto_solution.get_selected_solver());
+  std::cerr << "solver: "               << solver_name
+            << ", triangles: "          << stats.num_triangles
+            << ", sample: "             << stats.sample_size << '\n'
+            << "  planarity: "          << stats.planarity
+            << ", mean size: "          << stats.mean_size
+            << ", size spread: "        << stats.size_spread
+            << ", cells per triangle: " << stats.cells_per_triangle << '\n'
+            << "  overlaps: box "       << stats.box_overlap
+            << ", sweep "               << stats.sweep_overlap
+            << ", cell "                << stats.cell_overlap
+            << ", hit ratio: "          << stats.hit_ratio << '\n'
+            << "  estimated ms: naive " << costs.naive / 1e6
+            << ", BVH "                 << costs.BVH / 1e6
+            << ", sweep and prune "     << costs.sweep_and_prune / 1e6
+            << ", spatial hash "        << costs.spatial_hash / 1e6 << std::endl;
+
+  write_solver_output(auto_solution, args);
+
+  return 0;
+}
+
+/*
+
+3
+-1 1 0 1 1 0 0 -1 0
+0 1 0 -1 -1 0 1 -1 0
+100 100 100 100 100 100
+
+*/
@@ -0,0 +1,69 @@
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "logLib.hpp"
+#include "triangles_binary.hpp"
+#include "triangles_input.hpp"
+
+/*
+
+Converts triangles in text format from stdin to binary triangles file,
+which usecase targets read in place with --input FILE.
+
+*/
+
+namespace {
+  const std::string kUsage =
+    "usage: convert_to_binary OUTPUT_FILE [options] < input.dat\n"
+    "options:\n"
+    "  --float  store coordinates as float instead of double\n"
+    "  --boxes  store precomputed bounding boxes of triangles";
+}
+
+int main(int argc, char** argv) {
+  std::string output_path;
+  bool is_float   = false;
+  bool with_boxes = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view option = argv[i];
+    if (option == "--float") {
+      is_float = true;
+    } else if (option == "--boxes") {
+      with_boxes = true;
+    } else if (output_path.empty() && !option.empty() && option[0] != '-') {
+      output_path = option;
+    } else {
+      std::cerr << "Error: unknown option \"" << option << "\"\n" << kUsage << std::endl;
+      return 1;
+    }
+  }
+
+  if (output_path.empty()) {
+    std::cerr << "Error: output file is not given\n" << kUsage << std::endl;
+    return 1;
+  }
+
+  try {
+    std::vector<triangle_t<double>> triangles = triangles_input::read_triangles<double>(std::cin);
+
+    std::ofstream out_stream(output_path, std::ios::binary);
+    if (!out_stream) {
+      throw std::runtime_error("Error: can't open file \"" + output_path + "\"");
+    }
+
+    if (is_float) {
+      triangles_binary::write<float>(out_stream, triangles, with_boxes);
+    } else {
+      triangles_binary::write<double>(out_stream, triangles, with_boxes);
+    }
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
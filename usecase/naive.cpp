@@ -1,19 +1,33 @@
 #include <iostream>
-#include <vector>
+#include <stdexcept>
 
 #include "logLib.hpp"
+#include "cmd_args.hpp"
 #include "solutions_impl.hpp"
+#include "solver_output.hpp"
 
-int main() {
-  triangles_inters_solver_t<double, naive_solution_tag> brute_force_sol;
-  brute_force_sol.input();
-  std::vector<std::size_t> indices =
-    brute_force_sol.get_inter_triangs_indices();
+int main(int argc, char** argv) {
+  cmd_args_t args;
+  try {
+    args = cmd_args::parse(argc, argv);
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << '\n' << cmd_args::kUsage << std::endl;
+    return 1;
+  }
 
-  for (std::size_t ind : indices) {
-    std::cout << ind << '\n';
+  triangles_inters_solver_t<double, naive_solution_tag> brute_force_sol(get_solver_params<double>(args));
+  try {
+    if (args.input_path.empty()) {
+      brute_force_sol.input();
+    } else {
+      brute_force_sol.input_file(args.input_path);
+    }
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
   }
-  std::cout.flush();
+
+  write_solver_output(brute_force_sol, args);
 
   return 0;
 }
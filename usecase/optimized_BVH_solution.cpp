@@ -1,19 +1,35 @@
 #include <iostream>
-#include <vector>
+#include <stdexcept>
 
 #include "logLib.hpp"
+#include "cmd_args.hpp"
 #include "solutions_impl.hpp"
+#include "solver_output.hpp"
 
-int main() {
-  triangles_inters_solver_t<double, opt_bvh_solution_tag> BVH_solution;
-  BVH_solution.input();
-  std::vector<std::size_t> indices =
-    BVH_solution.get_inter_triangs_indices();
+int main(int argc, char** argv) {
+  cmd_args_t args;
+  try {
+    args = cmd_args::parse(argc, argv);
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << '\n' << cmd_args::kUsage << std::endl;
+    return 1;
+  }
+
+  solver_params_t<double> params = get_solver_params<double>(args);
 
-  for (std::size_t ind : indices) {
-    std::cout << ind << '\n';
+  triangles_inters_solver_t<double, opt_bvh_solution_tag> BVH_solution(params);
+  try {
+    if (args.input_path.empty()) {
+      BVH_solution.input();
+    } else {
+      BVH_solution.input_file(args.input_path);
+    }
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
   }
-  std::cout.flush();
+
+  write_solver_output(BVH_solution, args);
 
   return 0;
 }
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <iostream>
+
+#include "cmd_args.hpp"
+#include "result_sink.hpp"
+#include "solutions_impl.hpp"
+#include "stats.hpp"
+
+// solver params, that options ask for
+template<typename T>
+[[nodiscard]] solver_params_t<T> get_solver_params(const cmd_args_t& args) {
+  solver_params_t<T> params;
+  params.num_threads = args.num_threads;
+  if (args.exact_predicates) {
+    params.narrow_phase_kernel = triangle_inters_kernel_t::EXACT;
+  }
+
+  return params;
+}
+
+// writes to stdout what options ask for: intersecting triangles, pairs or components,
+// with --stats also writes counters of solving to stderr
+template<typename solver_t>
+void write_solver_output(solver_t& solver, const cmd_args_t& args) {
+  stats::reset();
+  if (args.find_pairs) {
+    result_sink::write_list_in_format(args.output_format, std::cout,
+      [&](auto& sink) { solver.write_inter_triangs_pairs(sink, args.max_num_pairs); });
+  } else if (args.find_components) {
+    components_t components = solver.get_components();
+    result_sink::write_list_in_format(args.output_format, std::cout,
+      [&](auto& sink) {
+        for (std::size_t id : components.ids) {
+          sink.add(id);
+        }
+        sink.finish();
+      });
+
+    std::cerr << "components: "             << components.num_components
+              << ", clusters: "             << components.num_clusters
+              << ", largest: "              << components.max_size
+              << ", triangles in clusters: " << components.num_clustered << std::endl;
+  } else {
+    result_sink::write_in_format(args.output_format, std::cout, solver.get_num_triangles(),
+      [&](auto& sink) { solver.write_inter_triangs_indices(sink); });
+  }
+
+  if (args.print_stats) {
+    stats::write_json(std::cerr, stats::get_total());
+  }
+}
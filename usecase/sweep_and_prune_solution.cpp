@@ -0,0 +1,44 @@
+#include <iostream>
+#include <stdexcept>
+
+#include "logLib.hpp"
+#include "cmd_args.hpp"
+#include "solutions_impl.hpp"
+#include "solver_output.hpp"
+
+int main(int argc, char** argv) {
+  cmd_args_t args;
+  try {
+    args = cmd_args::parse(argc, argv);
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << '\n' << cmd_args::kUsage << std::endl;
+    return 1;
+  }
+
+  solver_params_t<double> params = get_solver_params<double>(args);
+
+  triangles_inters_solver_t<double, sweep_and_prune_solution_tag> sweep_solution(params);
+  try {
+    if (args.input_path.empty()) {
+      sweep_solution.input();
+    } else {
+      sweep_solution.input_file(args.input_path);
+    }
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+
+  write_solver_output(sweep_solution, args);
+
+  return 0;
+}
+
+/*
+
+3
+-1 1 0 1 1 0 0 -1 0
+0 1 0 -1 -1 0 1 -1 0
+100 100 100 100 100 100
+
+*/